@@ -0,0 +1,194 @@
+/**
+ * @file arena.h
+ * @brief Per-invocation bump allocator for scratch memory
+ * @details An invocation of an exported method is short-lived and everything
+ *          it allocates for the host buffers and the JSON it parses is dead
+ *          once the method returns. In arena mode (define WEILSDK_ARENA) such
+ *          allocations are carved out of large chunks by bumping a pointer
+ *          and are all released at once when the outermost ArenaScope, which
+ *          the generated entry points open first thing, closes. Freeing is a
+ *          no-op except for the most recent allocation.
+ *
+ *          Two things go through the arena:
+ *          - __new/__free, via scratch_allocate()/scratch_deallocate();
+ *          - scratch_json, the JSON type the generated glue parses arguments
+ *            and builds results with, whose objects, arrays and node storage
+ *            use ArenaAllocator.
+ *
+ *          Nothing allocated from the arena may outlive the exported call.
+ *          Without WEILSDK_ARENA, scratch_json is nlohmann::ordered_json and
+ *          __new/__free go straight to Runtime::allocate/deallocate.
+ */
+
+#ifndef ARENA_H
+#define ARENA_H
+
+#include "external/nlohmann.hpp"
+#include "weilsdk/runtime.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <vector>
+
+namespace weilsdk {
+
+  class Arena {
+    private:
+      static constexpr size_t kChunk = 64 * 1024; ///< Smallest chunk requested from malloc
+
+      struct Chunk {
+        char *base;
+        size_t size;
+      };
+
+      struct Data {
+        std::vector<Chunk> chunks; ///< Chunks in allocation order
+        size_t current = 0;        ///< Chunk being bumped
+        size_t used = 0;           ///< Bytes used in the current chunk
+        size_t total = 0;          ///< Bytes handed out since the last reset
+        size_t depth = 0;          ///< Open ArenaScopes
+        char *last = nullptr;      ///< Most recent allocation, for LIFO frees
+
+        ~Data() {
+          for (const Chunk &c : chunks) {
+            std::free(c.base);
+          }
+        }
+      };
+
+      static Data &data() {
+        static Data d;
+        return d;
+      }
+
+      static void addChunk(Data &d, size_t at_least) {
+        size_t size = at_least > kChunk ? at_least : kChunk;
+        char *base = static_cast<char *>(std::malloc(size));
+        if (base == nullptr) {
+          throw std::bad_alloc();
+        }
+        d.chunks.push_back(Chunk{base, size});
+      }
+
+    public:
+      // Returns `size` bytes aligned to `align` (a power of two)
+      static void *allocate(size_t size, size_t align = alignof(std::max_align_t)) {
+        Data &d = data();
+        if (d.chunks.empty()) {
+          addChunk(d, size + align);
+        }
+        for (;;) {
+          Chunk &c = d.chunks[d.current];
+          uintptr_t top = reinterpret_cast<uintptr_t>(c.base) + d.used;
+          uintptr_t start = (top + align - 1) & ~(uintptr_t(align) - 1);
+          size_t end = (start - reinterpret_cast<uintptr_t>(c.base)) + size;
+          if (end <= c.size) {
+            d.total += end - d.used;
+            d.used = end;
+            d.last = reinterpret_cast<char *>(start);
+            return d.last;
+          }
+          if (d.current + 1 == d.chunks.size()) {
+            addChunk(d, size + align);
+          }
+          d.current++;
+          d.used = 0;
+        }
+      }
+
+      // Gives back the most recent allocation; anything else waits for reset()
+      static void deallocate(void *ptr, size_t size) {
+        Data &d = data();
+        if (ptr != nullptr && ptr == d.last) {
+          Chunk &c = d.chunks[d.current];
+          size_t start = static_cast<size_t>(d.last - c.base);
+          if (start + size == d.used) {
+            d.total -= d.used - start;
+            d.used = start;
+          }
+          d.last = nullptr;
+        }
+      }
+
+      // Releases everything. If the invocation needed more than one chunk,
+      // they are replaced by a single chunk that fits it, so later
+      // invocations of the same size bump through contiguous memory
+      static void reset() {
+        Data &d = data();
+        if (d.chunks.size() > 1) {
+          size_t high_water = 0;
+          for (const Chunk &c : d.chunks) {
+            high_water += c.size;
+            std::free(c.base);
+          }
+          d.chunks.clear();
+          addChunk(d, high_water);
+        }
+        d.current = 0;
+        d.used = 0;
+        d.total = 0;
+        d.last = nullptr;
+      }
+
+      static void enter() { data().depth++; }
+
+      static void leave() {
+        Data &d = data();
+        if (--d.depth == 0) {
+          reset();
+        }
+      }
+
+      // Bytes handed out since the last reset
+      static size_t used() { return data().total; }
+  };
+
+  // Resets the arena when the outermost scope closes. Declare it before any
+  // arena-backed local so it is destroyed after them
+  class ArenaScope {
+    public:
+      ArenaScope() { Arena::enter(); }
+      ~ArenaScope() { Arena::leave(); }
+
+      ArenaScope(const ArenaScope &) = delete;
+      ArenaScope &operator=(const ArenaScope &) = delete;
+  };
+
+  // Standard allocator over the arena
+  template <typename T>
+  struct ArenaAllocator {
+    using value_type = T;
+
+    ArenaAllocator() noexcept = default;
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U> &) noexcept {}
+
+    T *allocate(size_t n) { return static_cast<T *>(Arena::allocate(n * sizeof(T), alignof(T))); }
+    void deallocate(T *p, size_t n) noexcept { Arena::deallocate(p, n * sizeof(T)); }
+
+    template <typename U>
+    bool operator==(const ArenaAllocator<U> &) const noexcept { return true; }
+    template <typename U>
+    bool operator!=(const ArenaAllocator<U> &) const noexcept { return false; }
+  };
+
+#ifdef WEILSDK_ARENA
+  using scratch_json = nlohmann::basic_json<nlohmann::ordered_map, std::vector, std::string, bool,
+                                            std::int64_t, std::uint64_t, double, ArenaAllocator>;
+
+  inline void *scratch_allocate(size_t len) { return Arena::allocate(len ? len : 1); }
+  inline void scratch_deallocate(size_t ptr, size_t len) {
+    Arena::deallocate(reinterpret_cast<void *>(ptr), len);
+  }
+#else
+  using scratch_json = nlohmann::ordered_json;
+
+  inline void *scratch_allocate(size_t len) { return Runtime::allocate(len); }
+  inline void scratch_deallocate(size_t ptr, size_t len) { Runtime::deallocate(ptr, len); }
+#endif
+
+} // namespace weilsdk
+
+#endif // ARENA_H
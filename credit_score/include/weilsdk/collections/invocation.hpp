@@ -0,0 +1,52 @@
+/**
+ * @file invocation.hpp
+ * @brief Per-invocation reset of the collections' process-wide state
+ * @details ReadCache and WriteBuffer are process-wide and outlive a single
+ *          invocation of an exported method, while the state they mirror may
+ *          be changed by other transactions in between. Every entry point
+ *          opens an InvocationScope first thing; the outermost scope drops
+ *          whatever reads are cached and writes are buffered both when it
+ *          opens and when it closes, so nothing carries over from one
+ *          invocation to the next. Hand-written exports that use collections
+ *          must open one as well.
+ */
+
+#ifndef INVOCATION_HPP
+#define INVOCATION_HPP
+
+#include "cache.hpp"
+#include "write_buffer.hpp"
+#include <cstddef>
+
+namespace collections {
+  class InvocationScope {
+  private:
+    static size_t &depth() {
+      static size_t d = 0;
+      return d;
+    }
+
+    static void reset() {
+      ReadCache::clear();
+      WriteBuffer::discard();
+    }
+
+  public:
+    InvocationScope() {
+      if (depth()++ == 0) {
+        reset();
+      }
+    }
+
+    ~InvocationScope() {
+      if (--depth() == 0) {
+        reset();
+      }
+    }
+
+    InvocationScope(const InvocationScope &) = delete;
+    InvocationScope &operator=(const InvocationScope &) = delete;
+  };
+} // namespace collections
+
+#endif // INVOCATION_HPP
@@ -3,52 +3,100 @@
  * @brief Implementation of a persistent key-value map collection
  * @details This file provides the WeilMap template class, which implements a
  *          persistent key-value map that stores data in the blockchain state.
- *          It supports insert, get, remove, and contains operations with automatic
- *          JSON serialization/deserialization.
+ *          It supports insert, get, try_get, remove, and contains operations with
+ *          automatic serialization through a pluggable codec (JSON by default),
+ *          and prefix scans backed by a single bulk read.
  */
 
 #ifndef MAP_HPP
 #define MAP_HPP
 
+#include "cache.hpp"
+#include "codec.hpp"
 #include "collections.hpp"
+#include "key_encoder.hpp"
+#include "write_buffer.hpp"
 #include "external/nlohmann.hpp"
 #include "weilsdk/memory.h"
 #include "weilsdk/runtime.h"
+#include "weilsdk/stats.h"
+#include <algorithm>
 #include <map>
+#include <optional>
 #include <string>
+#include <utility>
+#include <vector>
 
-extern "C" void write_collection(int key, int val);
+extern "C" void write_collection(int key, int val)
 __attribute__((import_name("write_collection")));
-extern "C" int delete_collection(int key);
+extern "C" int delete_collection(int key)
 __attribute__((import_name("delete_collection")));
-extern "C" int read_collection(int key);
+extern "C" int read_collection(int key)
 __attribute__((import_name("read_collection")));
 
 namespace collections {
+  class ReadBatch;
+
   /**
    * @brief A persistent key-value map collection
    * @tparam K The type of keys in the map
    * @tparam V The type of values in the map
+   * @tparam Codec How values are encoded for storage (see codec.hpp)
    * @details This class provides a persistent map implementation that stores
    *          key-value pairs in the blockchain state. Values are automatically
-   *          serialized to JSON for storage and deserialized when retrieved.
+   *          encoded with Codec for storage and decoded when retrieved.
+   *          Maps can opt into the per-invocation ReadCache so that repeated
+   *          lookups of a key only cross the host boundary once, and into the
+   *          WriteBuffer so that mutations are coalesced into one host write
+   *          per key at the end of the invocation.
    */
-  template <typename K, typename V>
+  template <typename K, typename V, typename Codec = JsonCodec<V>>
   class WeilMap : public collections::Collection<K> {
   private:
     uint8_t state_id; ///< The state ID used to identify this map in storage
+    bool cached;      ///< Whether lookups go through the ReadCache
+    bool buffered;    ///< Whether mutations go through the WriteBuffer
+
+    friend class ReadBatch;
+
+    /**
+     * @brief Reads and decodes a value straight from the host
+     * @param state_key The full state tree key
+     * @return The decoded value, or std::nullopt if the key is absent
+     */
+    static std::optional<V> read(const std::string &state_key) {
+      auto result = weilsdk::CountedMemory::readCollection(state_key);
+      if (result.first) {
+        return std::nullopt;
+      }
+      return Codec::decode(result.second);
+    }
 
   public:
     /**
      * @brief Constructs a WeilMap with an uninitialized state ID
      */
-    WeilMap() : state_id(-1) {}
+    WeilMap() : state_id(-1), cached(false), buffered(false) {}
     
     /**
      * @brief Constructs a WeilMap with the specified state ID
      * @param id The state ID to use for this map
      */
-    WeilMap(uint8_t id) : state_id(id) {}
+    WeilMap(uint8_t id) : state_id(id), cached(false), buffered(false) {}
+
+    /**
+     * @brief Routes this map's lookups through the per-invocation ReadCache
+     * @param enabled Whether to use the cache
+     */
+    void enable_cache(bool enabled = true) { cached = enabled; }
+
+    /**
+     * @brief Buffers this map's inserts and removes in the WriteBuffer
+     * @details The owner must call WriteBuffer::flush() before handing the
+     *          state back to the host; the generated entry points do.
+     * @param enabled Whether to buffer mutations
+     */
+    void enable_write_back(bool enabled = true) { buffered = enabled; }
 
     /**
      * @brief Gets the base state path for this map
@@ -61,21 +109,29 @@ namespace collections {
     
     /**
      * @brief Constructs the full state tree key for a given key
-     * @details If the key type is std::string, it's used directly. Otherwise,
-     *          the key is serialized to JSON and used as part of the state key.
+     * @details The key is appended to the base state path with KeyEncoder, so
+     *          std::string keys are used directly and integer and tuple keys
+     *          sort in their natural order (see key_encoder.hpp). The key is
+     *          assembled in an inline buffer and copied out once.
      * @param key The key to construct the state tree key for
      * @return The full state tree key as a string
      */
     std::string state_tree_key(const K &key) const {
-      if constexpr (std::is_same<K, std::string>::value) {
-          // If the key is already a string, return it without extra quotes
-          std::string res = base_state_path() + "_" + key;
-          return res;
-      } else {
-          // Otherwise, convert key to JSON string and append
-          std::string res = base_state_path() + "_" + nlohmann::json(key).dump();
-          return res;
-      }
+      KeyBuffer buf;
+      buf.append_decimal(state_id);
+      buf.push_back('_');
+      KeyEncoder<K>::encode(buf, key, false);
+      return buf.str();
+    }
+
+    /**
+     * @brief Recovers the key from a full state tree key
+     * @param state_key A key produced by state_tree_key()
+     * @return The decoded key
+     */
+    K key_from_state_tree_key(const std::string &state_key) const {
+      const char *p = state_key.data() + base_state_path().size() + 1;
+      return KeyEncoder<K>::decode(p, state_key.data() + state_key.size(), false);
     }
 
     /**
@@ -84,11 +140,21 @@ namespace collections {
      * @param value The value to associate with the key
      */
     void insert(const K &key, const V &value) {
+      if (buffered) {
+        std::string state_key = state_tree_key(key);
+        WriteBuffer::put<V, Codec>(state_key, value);
+        if (cached) {
+          ReadCache::put<V>(state_key, value);
+        }
+        return;
+      }
 
-      nlohmann::json jsonPayload = value;
-      std::string serializedPayload = jsonPayload.dump();
+      std::string serializedPayload = Codec::encode(value);
       std::string state_key = state_tree_key(key);
-      weilsdk::Memory::writeCollection(state_tree_key(key), serializedPayload);
+      weilsdk::CountedMemory::writeCollection(state_key, serializedPayload);
+      if (cached) {
+        ReadCache::put<V>(state_key, value);
+      }
     }
 
     /**
@@ -113,27 +179,122 @@ namespace collections {
      * @return true if the key exists in the map, false otherwise
      */
     bool contains(const K &key) const {
+      if (cached || buffered) {
+        return try_get(key).has_value();
+      }
       std::string state_key = state_tree_key(key);
-      std::pair<int,std::string> result  =  weilsdk::Memory::readCollection(state_key);
+      std::pair<int,std::string> result  =  weilsdk::CountedMemory::readCollection(state_key);
       return !result.first;
     }
 
+    /**
+     * @brief Gets the value associated with a key, if any
+     * @details Costs at most one host read; none if the key is cached or has
+     *          a buffered mutation.
+     * @param key The key to look up
+     * @return The value associated with the key, or std::nullopt if not found
+     */
+    std::optional<V> try_get(const K &key) const {
+      std::string state_key = state_tree_key(key);
+      if (buffered) {
+        if (const std::optional<V> *pending = WriteBuffer::find<V>(state_key)) {
+          return *pending;
+        }
+      }
+      if (cached) {
+        if (const std::optional<V> *hit = ReadCache::find<V>(state_key)) {
+          return *hit;
+        }
+      }
+      std::optional<V> value = read(state_key);
+      if (cached) {
+        ReadCache::put<V>(state_key, value);
+      }
+      return value;
+    }
+
+    /**
+     * @brief Gets the values associated with several keys
+     * @details Keys that are buffered or cached are answered locally; the
+     *          rest are fetched with a single Memory::readCollections call.
+     * @param keys The keys to look up
+     * @return One entry per key, std::nullopt where the key is absent
+     */
+    std::vector<std::optional<V>> get_many(const std::vector<K> &keys) const {
+      std::vector<std::optional<V>> out(keys.size());
+      std::vector<std::string> missing;
+      std::vector<size_t> slots;
+      for (size_t i = 0; i < keys.size(); ++i) {
+        std::string state_key = state_tree_key(keys[i]);
+        if (buffered) {
+          if (const std::optional<V> *pending = WriteBuffer::find<V>(state_key)) {
+            out[i] = *pending;
+            continue;
+          }
+        }
+        if (cached) {
+          if (const std::optional<V> *hit = ReadCache::find<V>(state_key)) {
+            out[i] = *hit;
+            continue;
+          }
+        }
+        missing.push_back(std::move(state_key));
+        slots.push_back(i);
+      }
+      if (missing.empty()) {
+        return out;
+      }
+      std::vector<std::pair<int, std::string>> results = weilsdk::CountedMemory::readCollections(missing);
+      for (size_t j = 0; j < results.size(); ++j) {
+        std::optional<V> &value = out[slots[j]];
+        if (!results[j].first) {
+          value = Codec::decode(results[j].second);
+        }
+        if (cached) {
+          ReadCache::put<V>(missing[j], value);
+        }
+      }
+      return out;
+    }
+
+    /**
+     * @brief Inserts or updates several key-value pairs
+     * @details A buffered map defers them to the flush like insert();
+     *          otherwise they are written with a single
+     *          Memory::writeCollections call.
+     * @param entries The (key, value) pairs
+     */
+    void insert_many(const std::vector<std::pair<K, V>> &entries) {
+      if (buffered) {
+        for (const auto &entry : entries) {
+          insert(entry.first, entry.second);
+        }
+        return;
+      }
+      std::vector<std::pair<std::string, std::string>> writes;
+      writes.reserve(entries.size());
+      for (const auto &entry : entries) {
+        writes.emplace_back(state_tree_key(entry.first), Codec::encode(entry.second));
+      }
+      weilsdk::CountedMemory::writeCollections(writes);
+      if (cached) {
+        for (size_t i = 0; i < entries.size(); ++i) {
+          ReadCache::put<V>(writes[i].first, entries[i].second);
+        }
+      }
+    }
+
     /**
      * @brief Gets the value associated with a key
      * @param key The key to look up
      * @return The value associated with the key, or a default-constructed value if not found
      */
     V get(const K &key) const {
-      auto result = weilsdk::Memory::readCollection(state_tree_key(key));
-      std::string s = result.second;
-      if (weilsdk::Memory::readCollection(state_tree_key(key)).first) {
-        V v;
-        return v;
+      std::optional<V> value = try_get(key);
+      if (!value) {
+        return V{};
       }
-      nlohmann::json j = nlohmann::json::parse(s);
-      V v1 = j.get<V>();
-
-      return v1;
+      return std::move(*value);
     }
 
     /**
@@ -142,15 +303,230 @@ namespace collections {
      * @return The value that was associated with the key, or a default-constructed value if not found
      */
     V remove(const K &key) {
+      if (buffered) {
+        std::optional<V> old = try_get(key);
+        if (!old) {
+          return V{};
+        }
+        erase(key);
+        return std::move(*old);
+      }
+
+      std::string state_key = state_tree_key(key);
       std::pair<int, std::string> res =
-          weilsdk::Memory::deleteCollection(state_tree_key(key));
+          weilsdk::CountedMemory::deleteCollection(state_key);
+      if (cached) {
+        ReadCache::put<V>(state_key, std::nullopt);
+      }
       std::string s = res.second;
       if (res.first) {
-        V v;
-        return v;
+        return V{};
+      }
+      return Codec::decode(s);
+    }
+
+    /**
+     * @brief Removes a key-value pair from the map without decoding it
+     * @details Unlike remove(), this never reads the old value, so a buffered
+     *          map defers the whole operation to the flush.
+     * @param key The key to remove
+     */
+    void erase(const K &key) {
+      std::string state_key = state_tree_key(key);
+      if (buffered) {
+        WriteBuffer::erase<V>(state_key);
+      } else {
+        weilsdk::CountedMemory::deleteCollection(state_key);
       }
-      nlohmann::json j = nlohmann::json::parse(s);
-      return j.get<V>();
+      if (cached) {
+        ReadCache::put<V>(state_key, std::nullopt);
+      }
+    }
+
+    /**
+     * @brief The entries of a WeilMap whose encoded keys share a prefix
+     * @details Fetched with one Memory::readBulkCollection call when the range
+     *          is created; values are only decoded as the iterator reaches
+     *          them. Mutations still sitting in the WriteBuffer are merged in,
+     *          so a scan sees the map as the current invocation does.
+     *          Entries are visited in key order.
+     */
+    class prefix_range {
+    private:
+      using Raw = std::vector<std::pair<std::string, std::string>>;
+      using Pending = std::map<std::string, std::optional<V>>;
+
+      const WeilMap *map;  ///< The map being scanned
+      Raw host;            ///< Entries as stored by the host, sorted by key
+      Pending pending;     ///< Buffered mutations under the prefix
+
+    public:
+      /**
+       * @brief Forward iterator over decoded (key, value) pairs
+       */
+      class iterator {
+      private:
+        const prefix_range *range;             ///< The range being iterated
+        size_t host_pos;                       ///< Next host entry
+        typename Pending::const_iterator pend; ///< Next buffered entry
+
+        bool host_done() const { return host_pos == range->host.size(); }
+        bool pend_done() const { return pend == range->pending.end(); }
+
+        // Whether the current entry comes from the WriteBuffer
+        bool on_pending() const {
+          return !pend_done() &&
+                 (host_done() || pend->first < range->host[host_pos].first);
+        }
+
+        // Skips host entries shadowed by a buffered mutation and buffered
+        // deletes, leaving the iterator on a live entry or at the end
+        void settle() {
+          while (!pend_done()) {
+            if (!host_done() && range->host[host_pos].first < pend->first) {
+              return;
+            }
+            if (!host_done() && range->host[host_pos].first == pend->first) {
+              ++host_pos;
+            }
+            if (pend->second.has_value()) {
+              return;
+            }
+            ++pend;
+          }
+        }
+
+      public:
+        using iterator_category = std::forward_iterator_tag; ///< Iterator category
+        using difference_type = std::ptrdiff_t;              ///< Difference type
+        using value_type = std::pair<K, V>;                  ///< Value type
+        using pointer = value_type *;                        ///< Pointer type
+        using reference = value_type &;                      ///< Reference type
+
+        /**
+         * @brief Constructs an iterator at the given positions
+         * @param r The range being iterated
+         * @param h Index of the next host entry
+         * @param p Next buffered entry
+         */
+        iterator(const prefix_range *r, size_t h, typename Pending::const_iterator p)
+            : range(r), host_pos(h), pend(p) {
+          settle();
+        }
+
+        /**
+         * @brief Decodes the current entry
+         * @return The current (key, value) pair
+         */
+        value_type operator*() const {
+          if (on_pending()) {
+            return {range->map->key_from_state_tree_key(pend->first), *pend->second};
+          }
+          const auto &raw = range->host[host_pos];
+          return {range->map->key_from_state_tree_key(raw.first), Codec::decode(raw.second)};
+        }
+
+        /**
+         * @brief Prefix increment operator
+         * @return Reference to the incremented iterator
+         */
+        iterator &operator++() {
+          if (on_pending()) {
+            ++pend;
+          } else {
+            ++host_pos;
+          }
+          settle();
+          return *this;
+        }
+
+        /**
+         * @brief Postfix increment operator
+         * @return A copy of the iterator before incrementing
+         */
+        iterator operator++(int) {
+          iterator temp = *this;
+          ++(*this);
+          return temp;
+        }
+
+        /**
+         * @brief Equality comparison operator
+         * @param other The iterator to compare with
+         * @return true if both iterators point to the same position, false otherwise
+         */
+        bool operator==(const iterator &other) const {
+          return host_pos == other.host_pos && pend == other.pend;
+        }
+
+        /**
+         * @brief Inequality comparison operator
+         * @param other The iterator to compare with
+         * @return true if the iterators point to different positions, false otherwise
+         */
+        bool operator!=(const iterator &other) const {
+          return !(*this == other);
+        }
+      };
+
+      /**
+       * @brief Reads the entries under a state tree key prefix
+       * @param m The map being scanned
+       * @param state_prefix The prefix, including the map's base state path
+       */
+      prefix_range(const WeilMap *m, const std::string &state_prefix)
+          : map(m),
+            host(weilsdk::Memory::readPrefixForTrie<Raw>(state_prefix).value_or(Raw{})) {
+        if (!std::is_sorted(host.begin(), host.end())) {
+          std::sort(host.begin(), host.end());
+        }
+        if (map->buffered) {
+          pending = WriteBuffer::with_prefix<V>(state_prefix);
+        }
+      }
+
+      /**
+       * @brief Gets an iterator to the first entry
+       * @return Iterator pointing to the first entry in key order
+       */
+      iterator begin() const { return iterator(this, 0, pending.begin()); }
+
+      /**
+       * @brief Gets an iterator past the last entry
+       * @return Iterator pointing past the last entry
+       */
+      iterator end() const { return iterator(this, host.size(), pending.end()); }
+    };
+
+    /**
+     * @brief Scans all entries whose key starts with a prefix
+     * @details Costs one host call regardless of how many entries match.
+     *          For std::string keys the prefix is matched against the key
+     *          itself; for other key types, against its encoded form.
+     *          The returned range must not outlive the map.
+     * @param prefix The key prefix; empty to scan the whole map
+     * @return A range of (key, value) pairs in key order
+     */
+    prefix_range entries_with_prefix(const std::string &prefix) const {
+      return prefix_range(this, base_state_path() + "_" + prefix);
+    }
+
+    /**
+     * @brief Scans all entries of a tuple-keyed map by leading components
+     * @details For K = std::pair<A, B> or std::tuple<A, ...>, passing a value
+     *          of A (or a std::tuple of the first few component types)
+     *          visits exactly the keys that start with it, in key order.
+     *          Costs one host call.
+     * @param head The leading key component(s)
+     * @return A range of (key, value) pairs in key order
+     */
+    template <typename Head>
+    prefix_range entries_with_key_prefix(const Head &head) const {
+      KeyBuffer buf;
+      buf.append_decimal(state_id);
+      buf.push_back('_');
+      KeyEncoder<Head>::encode(buf, head, true);
+      return prefix_range(this, buf.str());
     }
 
     /**
@@ -170,5 +546,63 @@ namespace collections {
       setStateId(j["state_id"]);
     }
   };
+
+  /**
+   * @brief Fetches keys of several cached maps in one host round trip
+   * @details Queue the keys a method is about to read with add(), then call
+   *          fetch(): every queued key that is not already buffered or cached
+   *          is read with one Memory::readCollections call and its decoded
+   *          value (or absence) is put in the ReadCache, where the maps'
+   *          ordinary lookups find it. Keys of maps without the cache enabled
+   *          are ignored.
+   */
+  class ReadBatch {
+  private:
+    using Fill = void (*)(const std::string &, const std::pair<int, std::string> &);
+
+    std::vector<std::string> keys; ///< Queued state tree keys
+    std::vector<Fill> fills;       ///< How to decode and cache each key
+
+    template <typename V, typename Codec>
+    static void fill(const std::string &key, const std::pair<int, std::string> &result) {
+      if (result.first) {
+        ReadCache::put<V>(key, std::nullopt);
+      } else {
+        ReadCache::put<V>(key, Codec::decode(result.second));
+      }
+    }
+
+  public:
+    /**
+     * @brief Queues a key of a map
+     */
+    template <typename K, typename V, typename Codec>
+    ReadBatch &add(const WeilMap<K, V, Codec> &map, const K &key) {
+      if (!map.cached) {
+        return *this;
+      }
+      std::string state_key = map.state_tree_key(key);
+      if ((map.buffered && WriteBuffer::find<V>(state_key)) || ReadCache::find<V>(state_key)) {
+        return *this;
+      }
+      keys.push_back(std::move(state_key));
+      fills.push_back(&fill<V, Codec>);
+      return *this;
+    }
+
+    /**
+     * @brief Reads every queued key and empties the batch
+     */
+    void fetch() {
+      if (!keys.empty()) {
+        std::vector<std::pair<int, std::string>> results = weilsdk::CountedMemory::readCollections(keys);
+        for (size_t i = 0; i < results.size(); ++i) {
+          fills[i](keys[i], results[i]);
+        }
+      }
+      keys.clear();
+      fills.clear();
+    }
+  };
 } // namespace collections
 #endif // MAP_HPP
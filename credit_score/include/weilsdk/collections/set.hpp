@@ -0,0 +1,394 @@
+/**
+ * @file set.hpp
+ * @brief Implementation of persistent set and multimap collections
+ * @details This file provides WeilMultiMap, which maps each key to a set of
+ *          values, and WeilSet, a single set. Every member is its own host
+ *          key, so insert, erase and contains cost O(1) host calls no matter
+ *          how large the set grows, and members can be enumerated a page at
+ *          a time with bulk reads.
+ */
+
+#ifndef SET_HPP
+#define SET_HPP
+
+#include "codec.hpp"
+#include "collections.hpp"
+#include "key_encoder.hpp"
+#include "map.hpp"
+#include "external/nlohmann.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <set>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace collections {
+  /**
+   * @brief A persistent map from keys to sets of values
+   * @tparam K The type of keys
+   * @tparam V The type of set members
+   * @tparam Codec How members are encoded in the position slots (see codec.hpp)
+   * @details For each key, three kinds of entries live under the map's
+   *          state ID, told apart by a tag byte after the encoded key:
+   *
+   *              (key, 0)         -> number of members
+   *              (key, 1, member) -> the member's position
+   *              (key, 2, pos)    -> the member at that position
+   *
+   *          The positions of a key's members are dense, 0 to count - 1;
+   *          erase moves the last member into the freed slot. Each aligned
+   *          window of 256 positions shares one state key prefix, so a page
+   *          of members costs one bulk read per window it touches.
+   */
+  template <typename K, typename V, typename Codec = JsonCodec<V>>
+  class WeilMultiMap : public collections::Collection<K> {
+  private:
+    static constexpr uint8_t kCount = 0;    ///< Tag of the count entry
+    static constexpr uint8_t kMember = 1;   ///< Tag of member -> position entries
+    static constexpr uint8_t kPosition = 2; ///< Tag of position -> member entries
+
+    static constexpr size_t kWindowBits = 8;
+    static constexpr size_t kWindow = size_t(1) << kWindowBits; ///< Positions per bulk read
+
+    using CountKey = std::pair<K, uint8_t>;
+    using MemberKey = std::tuple<K, uint8_t, V>;
+    using PositionKey = std::tuple<K, uint8_t, uint64_t>;
+    using Slots = WeilMap<PositionKey, V, Codec>;
+
+    uint8_t state_id;                                              ///< The state ID of this map
+    WeilMap<CountKey, uint64_t, HexIntCodec<uint64_t>> counts;   ///< Members per key
+    WeilMap<MemberKey, uint64_t, HexIntCodec<uint64_t>> members; ///< Member positions
+    Slots slots;                                                   ///< Members by position
+
+  public:
+    /**
+     * @brief Constructs a WeilMultiMap with an uninitialized state ID
+     */
+    WeilMultiMap() : WeilMultiMap(static_cast<uint8_t>(-1)) {}
+
+    /**
+     * @brief Constructs a WeilMultiMap with the specified state ID
+     * @param id The state ID to use for this map
+     */
+    WeilMultiMap(uint8_t id) : state_id(id), counts(id), members(id), slots(id) {}
+
+    /**
+     * @brief Routes lookups through the per-invocation ReadCache
+     * @param enabled Whether to use the cache
+     */
+    void enable_cache(bool enabled = true) {
+      counts.enable_cache(enabled);
+      members.enable_cache(enabled);
+      slots.enable_cache(enabled);
+    }
+
+    /**
+     * @brief Buffers mutations in the WriteBuffer
+     * @details The owner must call WriteBuffer::flush() before handing the
+     *          state back to the host; the generated entry points do.
+     * @param enabled Whether to buffer mutations
+     */
+    void enable_write_back(bool enabled = true) {
+      counts.enable_write_back(enabled);
+      members.enable_write_back(enabled);
+      slots.enable_write_back(enabled);
+    }
+
+    /**
+     * @brief Gets the base state path for this map
+     * @return The base state path as a string representation of the state ID
+     */
+    std::string base_state_path() const override { return std::to_string(state_id); }
+
+    /**
+     * @brief Gets the number of members of a key's set
+     * @details Costs one host read.
+     */
+    uint64_t count(const K &key) const {
+      return counts.try_get(CountKey(key, kCount)).value_or(0);
+    }
+
+    /**
+     * @brief Checks whether a value is in a key's set
+     * @details Costs one host read.
+     */
+    bool contains(const K &key, const V &value) const {
+      return members.try_get(MemberKey(key, kMember, value)).has_value();
+    }
+
+    /**
+     * @brief Adds a value to a key's set
+     * @details Costs two host reads and three writes.
+     * @return false if the value was already a member
+     */
+    bool insert(const K &key, const V &value) {
+      MemberKey member(key, kMember, value);
+      if (members.try_get(member)) {
+        return false;
+      }
+      uint64_t n = count(key);
+      members.insert(member, n);
+      slots.insert(PositionKey(key, kPosition, n), value);
+      counts.insert(CountKey(key, kCount), n + 1);
+      return true;
+    }
+
+    /**
+     * @brief Removes a value from a key's set
+     * @details Moves the last member into the freed position. Costs at most
+     *          three host reads and five writes or deletes.
+     * @return false if the value was not a member
+     */
+    bool erase(const K &key, const V &value) {
+      MemberKey member(key, kMember, value);
+      std::optional<uint64_t> pos = members.try_get(member);
+      if (!pos) {
+        return false;
+      }
+      uint64_t last = count(key) - 1;
+      if (*pos != last) {
+        V moved = slots.get(PositionKey(key, kPosition, last));
+        slots.insert(PositionKey(key, kPosition, *pos), moved);
+        members.insert(MemberKey(key, kMember, moved), *pos);
+      }
+      slots.erase(PositionKey(key, kPosition, last));
+      members.erase(member);
+      if (last == 0) {
+        counts.erase(CountKey(key, kCount));
+      } else {
+        counts.insert(CountKey(key, kCount), last);
+      }
+      return true;
+    }
+
+    /**
+     * @brief Empties the sets of all keys that start with given components
+     * @details For a tuple key type K, `head` is a value of its first
+     *          component (or a std::tuple of the first few); every key
+     *          sharing it is cleared. Costs one bulk read plus one delete
+     *          per stored entry.
+     * @param head The leading key component(s)
+     */
+    template <typename Head>
+    void erase_with_key_prefix(const Head &head) {
+      KeyBuffer prefix;
+      prefix.append_decimal(state_id);
+      prefix.push_back('_');
+      KeyEncoder<Head>::encode(prefix, head, true);
+      const std::string state_prefix = prefix.str();
+
+      // All three kinds of entries live under the prefix, so their keys are
+      // listed once, undecoded, and told apart by the tag after the key
+      using Raw = std::vector<std::pair<std::string, std::string>>;
+      std::set<std::string> keys;
+      for (auto &entry : weilsdk::Memory::readPrefixForTrie<Raw>(state_prefix).value_or(Raw{})) {
+        keys.insert(std::move(entry.first));
+      }
+      for (auto &key : WriteBuffer::keys_with_prefix(state_prefix)) {
+        keys.insert(std::move(key));
+      }
+
+      const size_t base = base_state_path().size() + 1;
+      for (const std::string &key : keys) {
+        const char *p = key.data() + base;
+        const char *end = key.data() + key.size();
+        K k = KeyEncoder<K>::decode(p, end, true);
+        uint8_t tag = KeyEncoder<uint8_t>::decode(p, end, true);
+        if (tag == kCount) {
+          counts.erase(CountKey(k, kCount));
+        } else if (tag == kMember) {
+          members.erase(MemberKey(k, kMember, KeyEncoder<V>::decode(p, end, true)));
+        } else if (tag == kPosition) {
+          slots.erase(PositionKey(k, kPosition, KeyEncoder<uint64_t>::decode(p, end, true)));
+        }
+      }
+    }
+
+    /**
+     * @brief Gets a page of a key's members
+     * @details Members are returned in position order, which is insertion
+     *          order until the first erase. Costs one host read for the count
+     *          plus one bulk read per window of 256 positions the page touches.
+     * @param key The key whose set to enumerate
+     * @param offset The position of the first member to return
+     * @param limit The maximum number of members to return
+     * @return The members
+     */
+    std::vector<V> page(const K &key, uint64_t offset, uint64_t limit) const {
+      std::vector<V> out;
+      uint64_t end = std::min(count(key), offset + std::min(limit, ~uint64_t(0) - offset));
+      if (offset >= end) {
+        return out;
+      }
+      out.reserve(end - offset);
+      for (uint64_t first = offset & ~uint64_t(kWindow - 1); first < end; first += kWindow) {
+        KeyBuffer prefix;
+        prefix.append_decimal(state_id);
+        prefix.push_back('_');
+        KeyEncoder<K>::encode(prefix, key, true);
+        KeyEncoder<uint8_t>::encode(prefix, kPosition, true);
+        // All but the two hex digits of the position's low byte
+        KeyBuffer position;
+        KeyEncoder<uint64_t>::encode(position, first, true);
+        prefix.append(position.data(), position.size() - 2);
+
+        for (const auto &entry : typename Slots::prefix_range(&slots, prefix.str())) {
+          uint64_t pos = std::get<2>(entry.first);
+          if (pos >= offset && pos < end) {
+            out.push_back(entry.second);
+          }
+        }
+      }
+      return out;
+    }
+
+    /**
+     * @brief Gets all members of a key's set
+     */
+    std::vector<V> values(const K &key) const { return page(key, 0, count(key)); }
+
+    /**
+     * @brief Gets the state ID of this map
+     * @return The state ID
+     */
+    uint8_t getStateId() const { return this->state_id; }
+
+    /**
+     * @brief Sets the state ID of this map
+     * @param _stateId The new state ID to set
+     */
+    void setStateId(uint8_t _stateId) {
+      this->state_id = _stateId;
+      counts.setStateId(_stateId);
+      members.setStateId(_stateId);
+      slots.setStateId(_stateId);
+    }
+
+    /**
+     * @brief Serializes the map metadata to JSON
+     * @param j The JSON object to populate
+     */
+    inline void to_json(nlohmann::json &j) {
+      j = nlohmann::json::object();
+      j["state_id"] = getStateId();
+    }
+
+    /**
+     * @brief Deserializes the map metadata from JSON
+     * @param j The JSON object to deserialize from
+     */
+    inline void from_json(const nlohmann::json &j) {
+      setStateId(j["state_id"]);
+    }
+  };
+
+  /**
+   * @brief A persistent set
+   * @tparam T The type of members
+   * @tparam Codec How members are encoded in the position slots (see codec.hpp)
+   * @details A WeilMultiMap with a single key; see there for the layout and
+   *          costs.
+   */
+  template <typename T, typename Codec = JsonCodec<T>>
+  class WeilSet : public collections::Collection<T> {
+  private:
+    static constexpr uint8_t kKey = 0; ///< The multimap key all members live under
+
+    WeilMultiMap<uint8_t, T, Codec> sets; ///< The underlying multimap
+
+  public:
+    /**
+     * @brief Constructs a WeilSet with an uninitialized state ID
+     */
+    WeilSet() {}
+
+    /**
+     * @brief Constructs a WeilSet with the specified state ID
+     * @param id The state ID to use for this set
+     */
+    WeilSet(uint8_t id) : sets(id) {}
+
+    /**
+     * @brief Routes lookups through the per-invocation ReadCache
+     */
+    void enable_cache(bool enabled = true) { sets.enable_cache(enabled); }
+
+    /**
+     * @brief Buffers mutations in the WriteBuffer
+     */
+    void enable_write_back(bool enabled = true) { sets.enable_write_back(enabled); }
+
+    /**
+     * @brief Gets the base state path for this set
+     * @return The base state path as a string representation of the state ID
+     */
+    std::string base_state_path() const override { return sets.base_state_path(); }
+
+    /**
+     * @brief Gets the number of members
+     */
+    uint64_t size() const { return sets.count(kKey); }
+
+    /**
+     * @brief Checks whether a value is a member
+     */
+    bool contains(const T &value) const { return sets.contains(kKey, value); }
+
+    /**
+     * @brief Adds a member
+     * @return false if the value was already a member
+     */
+    bool insert(const T &value) { return sets.insert(kKey, value); }
+
+    /**
+     * @brief Removes a member
+     * @return false if the value was not a member
+     */
+    bool erase(const T &value) { return sets.erase(kKey, value); }
+
+    /**
+     * @brief Gets a page of members
+     * @param offset The position of the first member to return
+     * @param limit The maximum number of members to return
+     */
+    std::vector<T> page(uint64_t offset, uint64_t limit) const { return sets.page(kKey, offset, limit); }
+
+    /**
+     * @brief Gets all members
+     */
+    std::vector<T> values() const { return sets.values(kKey); }
+
+    /**
+     * @brief Gets the state ID of this set
+     * @return The state ID
+     */
+    uint8_t getStateId() const { return sets.getStateId(); }
+
+    /**
+     * @brief Sets the state ID of this set
+     * @param _stateId The new state ID to set
+     */
+    void setStateId(uint8_t _stateId) { sets.setStateId(_stateId); }
+
+    /**
+     * @brief Serializes the set metadata to JSON
+     * @param j The JSON object to populate
+     */
+    inline void to_json(nlohmann::json &j) {
+      j = nlohmann::json::object();
+      j["state_id"] = getStateId();
+    }
+
+    /**
+     * @brief Deserializes the set metadata from JSON
+     * @param j The JSON object to deserialize from
+     */
+    inline void from_json(const nlohmann::json &j) {
+      setStateId(j["state_id"]);
+    }
+  };
+} // namespace collections
+
+#endif // SET_HPP
@@ -0,0 +1,665 @@
+/**
+ * @file sorted_map.hpp
+ * @brief Implementation of a persistent ordered map collection
+ * @details This file provides the WeilSortedMap template class, a B+tree whose
+ *          nodes are stored as pages in the blockchain state. It supports
+ *          insert, try_get, remove and contains in O(log_B N) host reads,
+ *          lower_bound/upper_bound, ordered iteration, range queries, min/max
+ *          and cursor-based pagination.
+ */
+
+#ifndef SORTED_MAP_HPP
+#define SORTED_MAP_HPP
+
+#include "codec.hpp"
+#include "collections.hpp"
+#include "map.hpp"
+#include "external/nlohmann.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace collections {
+  /**
+   * @brief A persistent ordered key-value map backed by a B+tree
+   * @tparam K The type of keys; must be ordered by operator< and convertible
+   *           to and from nlohmann::json
+   * @tparam V The type of values; must be convertible to and from nlohmann::json
+   * @tparam Fanout The maximum number of keys per node
+   * @details Every node is one page, stored with BinaryCodec under
+   *          "<state_id>_<page id>"; a small header page (root, height, size,
+   *          next free page id) lives under "<state_id>_". Values are kept in
+   *          the leaves, which are linked in both directions so iteration
+   *          walks leaf to leaf with one host read per Fanout entries.
+   *
+   *          Choose Fanout so that a full leaf stays within a few KiB of
+   *          encoded keys and values: fewer, larger pages mean fewer host
+   *          reads per lookup, but every insert rewrites the whole leaf.
+   *
+   *          Removes unlink leaves that become empty (and internal nodes
+   *          left without children) but do not merge underfull nodes, so
+   *          the tree never holds empty leaves but may hold sparse ones.
+   *
+   *          Like WeilMap, the map can route its page reads through the
+   *          ReadCache and its page writes through the WriteBuffer; with
+   *          both enabled, repeated operations within one invocation touch
+   *          each page once.
+   */
+  template <typename K, typename V, size_t Fanout = 64>
+  class WeilSortedMap : public collections::Collection<K> {
+    static_assert(Fanout >= 3, "WeilSortedMap needs room for at least three keys per node");
+
+  public:
+    /**
+     * @brief One page of the tree
+     * @details Leaves hold keys with their values; internal nodes hold
+     *          separator keys and keys.size() + 1 child page ids, where every
+     *          key of children[i] is >= keys[i - 1] and < keys[i].
+     */
+    struct Node {
+      bool leaf = true;
+      std::vector<K> keys;
+      std::vector<V> values;           ///< Leaves only
+      std::vector<uint32_t> children;  ///< Internal nodes only
+      uint32_t prev = 0;               ///< Previous leaf, 0 if none
+      uint32_t next = 0;               ///< Next leaf, 0 if none
+
+      friend void to_json(nlohmann::json &j, const Node &n) {
+        j = nlohmann::json{{"l", n.leaf}, {"k", n.keys}};
+        if (n.leaf) {
+          j["v"] = n.values;
+          j["p"] = n.prev;
+          j["n"] = n.next;
+        } else {
+          j["c"] = n.children;
+        }
+      }
+
+      friend void from_json(const nlohmann::json &j, Node &n) {
+        n.leaf = j.at("l").get<bool>();
+        n.keys = j.at("k").get<std::vector<K>>();
+        if (n.leaf) {
+          n.values = j.at("v").get<std::vector<V>>();
+          n.prev = j.at("p").get<uint32_t>();
+          n.next = j.at("n").get<uint32_t>();
+        } else {
+          n.children = j.at("c").get<std::vector<uint32_t>>();
+        }
+      }
+    };
+
+    /**
+     * @brief Tree-wide bookkeeping, stored under "<state_id>_"
+     */
+    struct Header {
+      uint32_t root = 0;      ///< Root page, 0 while the tree has never held a key
+      uint32_t height = 0;    ///< Levels, 1 for a lone leaf
+      uint32_t next_page = 1; ///< Next unused page id
+      uint64_t count = 0;     ///< Number of keys
+
+      friend void to_json(nlohmann::json &j, const Header &h) {
+        j = nlohmann::json{{"r", h.root}, {"h", h.height}, {"n", h.next_page}, {"c", h.count}};
+      }
+
+      friend void from_json(const nlohmann::json &j, Header &h) {
+        h.root = j.at("r").get<uint32_t>();
+        h.height = j.at("h").get<uint32_t>();
+        h.next_page = j.at("n").get<uint32_t>();
+        h.count = j.at("c").get<uint64_t>();
+      }
+    };
+
+  private:
+    using Split = std::optional<std::pair<K, uint32_t>>;
+
+    uint8_t state_id;                                          ///< The state ID of this map
+    WeilMap<uint32_t, Node, BinaryCodec<Node>> pages;          ///< Tree pages by id
+    WeilMap<std::string, Header, BinaryCodec<Header>> header_; ///< The header, under key ""
+
+    Header header() const { return header_.try_get(std::string()).value_or(Header{}); }
+    void set_header(const Header &h) { header_.insert(std::string(), h); }
+
+    Node load(uint32_t page) const { return pages.try_get(page).value_or(Node{}); }
+    void store(uint32_t page, const Node &node) { pages.insert(page, node); }
+
+    /**
+     * @brief Descends from the root to the leaf that would hold a key
+     * @return The leaf's page id, or 0 for an empty tree
+     */
+    uint32_t find_leaf(const K &key, Node &leaf) const {
+      Header h = header();
+      uint32_t page = h.root;
+      if (page == 0) {
+        return 0;
+      }
+      Node node = load(page);
+      while (!node.leaf) {
+        size_t i = std::upper_bound(node.keys.begin(), node.keys.end(), key) - node.keys.begin();
+        page = node.children[i];
+        node = load(page);
+      }
+      leaf = std::move(node);
+      return page;
+    }
+
+    /**
+     * @brief Descends along the first or last child of every node
+     * @return The leftmost or rightmost leaf's page id, or 0 for an empty tree
+     */
+    uint32_t edge_leaf(bool rightmost, Node &leaf) const {
+      Header h = header();
+      uint32_t page = h.root;
+      if (page == 0) {
+        return 0;
+      }
+      Node node = load(page);
+      while (!node.leaf) {
+        page = rightmost ? node.children.back() : node.children.front();
+        node = load(page);
+      }
+      leaf = std::move(node);
+      return page;
+    }
+
+    /**
+     * @brief Inserts into the subtree rooted at a page
+     * @param added Set to whether the key was new
+     * @return The separator and page id of the new right sibling if the
+     *         page was split
+     */
+    Split insert_into(uint32_t page, const K &key, const V &value, Header &h, bool &added) {
+      Node node = load(page);
+      if (node.leaf) {
+        auto it = std::lower_bound(node.keys.begin(), node.keys.end(), key);
+        size_t i = it - node.keys.begin();
+        if (it != node.keys.end() && !(key < *it)) {
+          node.values[i] = value;
+          store(page, node);
+          added = false;
+          return std::nullopt;
+        }
+        node.keys.insert(it, key);
+        node.values.insert(node.values.begin() + i, value);
+        added = true;
+      } else {
+        size_t i = std::upper_bound(node.keys.begin(), node.keys.end(), key) - node.keys.begin();
+        Split split = insert_into(node.children[i], key, value, h, added);
+        if (!split) {
+          return std::nullopt;
+        }
+        node.keys.insert(node.keys.begin() + i, std::move(split->first));
+        node.children.insert(node.children.begin() + i + 1, split->second);
+      }
+
+      if (node.keys.size() <= Fanout) {
+        store(page, node);
+        return std::nullopt;
+      }
+
+      uint32_t right_page = h.next_page++;
+      size_t mid = node.keys.size() / 2;
+      Node right;
+      right.leaf = node.leaf;
+      Split split;
+      if (node.leaf) {
+        right.keys.assign(node.keys.begin() + mid, node.keys.end());
+        right.values.assign(node.values.begin() + mid, node.values.end());
+        node.keys.resize(mid);
+        node.values.resize(mid);
+        right.prev = page;
+        right.next = node.next;
+        if (node.next != 0) {
+          Node after = load(node.next);
+          after.prev = right_page;
+          store(node.next, after);
+        }
+        node.next = right_page;
+        split.emplace(right.keys.front(), right_page);
+      } else {
+        split.emplace(node.keys[mid], right_page);
+        right.keys.assign(node.keys.begin() + mid + 1, node.keys.end());
+        right.children.assign(node.children.begin() + mid + 1, node.children.end());
+        node.keys.resize(mid);
+        node.children.resize(mid + 1);
+      }
+      store(page, node);
+      store(right_page, right);
+      return split;
+    }
+
+    /**
+     * @brief Removes from the subtree rooted at a page
+     * @param removed Set to whether the key was present
+     * @return Whether the page became empty and was deleted
+     */
+    bool remove_from(uint32_t page, const K &key, bool is_root, bool &removed) {
+      Node node = load(page);
+      if (node.leaf) {
+        auto it = std::lower_bound(node.keys.begin(), node.keys.end(), key);
+        if (it == node.keys.end() || key < *it) {
+          removed = false;
+          return false;
+        }
+        size_t i = it - node.keys.begin();
+        node.keys.erase(it);
+        node.values.erase(node.values.begin() + i);
+        removed = true;
+        if (!node.keys.empty() || is_root) {
+          store(page, node);
+          return false;
+        }
+        // Unlink the empty leaf from its neighbours
+        if (node.prev != 0) {
+          Node before = load(node.prev);
+          before.next = node.next;
+          store(node.prev, before);
+        }
+        if (node.next != 0) {
+          Node after = load(node.next);
+          after.prev = node.prev;
+          store(node.next, after);
+        }
+        pages.erase(page);
+        return true;
+      }
+
+      size_t i = std::upper_bound(node.keys.begin(), node.keys.end(), key) - node.keys.begin();
+      if (!remove_from(node.children[i], key, false, removed)) {
+        return false;
+      }
+      node.children.erase(node.children.begin() + i);
+      if (!node.keys.empty()) {
+        node.keys.erase(node.keys.begin() + (i > 0 ? i - 1 : 0));
+      }
+      if (node.children.empty() && !is_root) {
+        pages.erase(page);
+        return true;
+      }
+      store(page, node);
+      return false;
+    }
+
+  public:
+    /**
+     * @brief Forward iterator over (key, value) pairs in key order
+     * @details Holds a copy of the current leaf, so advancing within a leaf
+     *          costs nothing and moving to the next leaf costs one read.
+     */
+    class iterator {
+    private:
+      const WeilSortedMap *map;         ///< The map being iterated
+      uint32_t page;                    ///< Current leaf, 0 at the end
+      std::shared_ptr<const Node> node; ///< Copy of the current leaf
+      size_t pos;                       ///< Position within the leaf
+
+      // Moves past the end of a leaf onto the next one
+      void settle() {
+        while (node && pos >= node->keys.size()) {
+          page = node->next;
+          pos = 0;
+          node = page != 0 ? std::make_shared<const Node>(map->load(page)) : nullptr;
+        }
+        if (!node) {
+          page = 0;
+          pos = 0;
+        }
+      }
+
+    public:
+      using iterator_category = std::forward_iterator_tag; ///< Iterator category
+      using difference_type = std::ptrdiff_t;              ///< Difference type
+      using value_type = std::pair<K, V>;                  ///< Value type
+      using pointer = value_type *;                        ///< Pointer type
+      using reference = value_type &;                      ///< Reference type
+
+      /**
+       * @brief Constructs an iterator at a position within a leaf
+       * @param m The map being iterated
+       * @param p The leaf's page id, 0 for the end iterator
+       * @param n The leaf's contents
+       * @param i The position within the leaf
+       */
+      iterator(const WeilSortedMap *m, uint32_t p, Node n, size_t i)
+          : map(m), page(p), node(p != 0 ? std::make_shared<const Node>(std::move(n)) : nullptr), pos(i) {
+        settle();
+      }
+
+      /**
+       * @brief Gets the key at the current position
+       */
+      const K &key() const { return node->keys[pos]; }
+
+      /**
+       * @brief Gets the value at the current position
+       */
+      const V &value() const { return node->values[pos]; }
+
+      /**
+       * @brief Dereferences the iterator
+       * @return The current (key, value) pair
+       */
+      value_type operator*() const { return {node->keys[pos], node->values[pos]}; }
+
+      /**
+       * @brief Prefix increment operator
+       * @return Reference to the incremented iterator
+       */
+      iterator &operator++() {
+        ++pos;
+        settle();
+        return *this;
+      }
+
+      /**
+       * @brief Postfix increment operator
+       * @return A copy of the iterator before incrementing
+       */
+      iterator operator++(int) {
+        iterator temp = *this;
+        ++(*this);
+        return temp;
+      }
+
+      /**
+       * @brief Equality comparison operator
+       * @param other The iterator to compare with
+       * @return true if both iterators point to the same position, false otherwise
+       */
+      bool operator==(const iterator &other) const {
+        return page == other.page && pos == other.pos;
+      }
+
+      /**
+       * @brief Inequality comparison operator
+       * @param other The iterator to compare with
+       * @return true if the iterators point to different positions, false otherwise
+       */
+      bool operator!=(const iterator &other) const {
+        return !(*this == other);
+      }
+    };
+
+    /**
+     * @brief Constructs a WeilSortedMap with an uninitialized state ID
+     */
+    WeilSortedMap() : WeilSortedMap(static_cast<uint8_t>(-1)) {}
+
+    /**
+     * @brief Constructs a WeilSortedMap with the specified state ID
+     * @param id The state ID to use for this map
+     */
+    WeilSortedMap(uint8_t id) : state_id(id), pages(id), header_(id) {}
+
+    /**
+     * @brief Routes page reads through the per-invocation ReadCache
+     * @param enabled Whether to use the cache
+     */
+    void enable_cache(bool enabled = true) {
+      pages.enable_cache(enabled);
+      header_.enable_cache(enabled);
+    }
+
+    /**
+     * @brief Buffers page writes in the WriteBuffer
+     * @details The owner must call WriteBuffer::flush() before handing the
+     *          state back to the host; the generated entry points do.
+     * @param enabled Whether to buffer page writes
+     */
+    void enable_write_back(bool enabled = true) {
+      pages.enable_write_back(enabled);
+      header_.enable_write_back(enabled);
+    }
+
+    /**
+     * @brief Gets the base state path for this map
+     * @return The base state path as a string representation of the state ID
+     */
+    std::string base_state_path() const override { return std::to_string(state_id); }
+
+    /**
+     * @brief Gets the number of keys in the map
+     * @return The number of keys
+     */
+    uint64_t size() const { return header().count; }
+
+    /**
+     * @brief Checks whether the map holds no keys
+     */
+    bool empty() const { return size() == 0; }
+
+    /**
+     * @brief Inserts or updates a key-value pair
+     * @details Costs one read per level plus one write per page changed;
+     *          splits propagate upwards and may grow the tree by a level.
+     * @param key The key to insert or update
+     * @param value The value to associate with the key
+     */
+    void insert(const K &key, const V &value) {
+      Header h = header();
+      if (h.root == 0) {
+        h.root = h.next_page++;
+        h.height = 1;
+        store(h.root, Node{});
+      }
+      bool added = false;
+      Split split = insert_into(h.root, key, value, h, added);
+      if (split) {
+        Node root;
+        root.leaf = false;
+        root.keys.push_back(std::move(split->first));
+        root.children = {h.root, split->second};
+        h.root = h.next_page++;
+        h.height++;
+        store(h.root, root);
+      }
+      if (added) {
+        h.count++;
+      }
+      if (added || split) {
+        set_header(h);
+      }
+    }
+
+    /**
+     * @brief Gets the value associated with a key, if any
+     * @details Costs one read per level of the tree.
+     * @param key The key to look up
+     * @return The value, or std::nullopt if not found
+     */
+    std::optional<V> try_get(const K &key) const {
+      Node leaf;
+      if (find_leaf(key, leaf) == 0) {
+        return std::nullopt;
+      }
+      auto it = std::lower_bound(leaf.keys.begin(), leaf.keys.end(), key);
+      if (it == leaf.keys.end() || key < *it) {
+        return std::nullopt;
+      }
+      return std::move(leaf.values[it - leaf.keys.begin()]);
+    }
+
+    /**
+     * @brief Gets the value associated with a key
+     * @param key The key to look up
+     * @return The value, or a default-constructed value if not found
+     */
+    V get(const K &key) const { return try_get(key).value_or(V()); }
+
+    /**
+     * @brief Checks if the map contains a key
+     * @param key The key to check for
+     * @return true if the key exists in the map, false otherwise
+     */
+    bool contains(const K &key) const { return try_get(key).has_value(); }
+
+    /**
+     * @brief Removes a key
+     * @param key The key to remove
+     * @return true if the key was present
+     */
+    bool remove(const K &key) {
+      Header h = header();
+      if (h.root == 0) {
+        return false;
+      }
+      bool removed = false;
+      remove_from(h.root, key, true, removed);
+      if (!removed) {
+        return false;
+      }
+      h.count--;
+      // Collapse internal roots that are down to a single child
+      Node root = load(h.root);
+      while (!root.leaf && root.children.size() == 1) {
+        pages.erase(h.root);
+        h.root = root.children.front();
+        h.height--;
+        root = load(h.root);
+      }
+      if (!root.leaf && root.children.empty()) {
+        root = Node{};
+        store(h.root, root);
+        h.height = 1;
+      }
+      set_header(h);
+      return true;
+    }
+
+    /**
+     * @brief Gets an iterator to the smallest key
+     */
+    iterator begin() const {
+      Node leaf;
+      uint32_t page = edge_leaf(false, leaf);
+      return iterator(this, page, std::move(leaf), 0);
+    }
+
+    /**
+     * @brief Gets the past-the-end iterator
+     */
+    iterator end() const { return iterator(this, 0, Node{}, 0); }
+
+    /**
+     * @brief Gets an iterator to the first key not less than a key
+     * @details Costs one read per level of the tree.
+     */
+    iterator lower_bound(const K &key) const {
+      Node leaf;
+      uint32_t page = find_leaf(key, leaf);
+      size_t pos = std::lower_bound(leaf.keys.begin(), leaf.keys.end(), key) - leaf.keys.begin();
+      return iterator(this, page, std::move(leaf), pos);
+    }
+
+    /**
+     * @brief Gets an iterator to the first key greater than a key
+     * @details Costs one read per level of the tree.
+     */
+    iterator upper_bound(const K &key) const {
+      Node leaf;
+      uint32_t page = find_leaf(key, leaf);
+      size_t pos = std::upper_bound(leaf.keys.begin(), leaf.keys.end(), key) - leaf.keys.begin();
+      return iterator(this, page, std::move(leaf), pos);
+    }
+
+    /**
+     * @brief Gets the entry with the smallest key
+     * @return The entry, or std::nullopt if the map is empty
+     */
+    std::optional<std::pair<K, V>> first() const {
+      iterator it = begin();
+      if (it == end()) {
+        return std::nullopt;
+      }
+      return *it;
+    }
+
+    /**
+     * @brief Gets the entry with the largest key
+     * @return The entry, or std::nullopt if the map is empty
+     */
+    std::optional<std::pair<K, V>> last() const {
+      Node leaf;
+      if (edge_leaf(true, leaf) == 0 || leaf.keys.empty()) {
+        return std::nullopt;
+      }
+      return std::make_pair(leaf.keys.back(), leaf.values.back());
+    }
+
+    /**
+     * @brief Collects the entries with keys in [lo, hi)
+     * @param lo The inclusive lower bound
+     * @param hi The exclusive upper bound
+     * @param limit The maximum number of entries to return
+     * @return The entries in key order
+     */
+    std::vector<std::pair<K, V>> range(const K &lo, const K &hi,
+                                       size_t limit = std::numeric_limits<size_t>::max()) const {
+      std::vector<std::pair<K, V>> out;
+      for (iterator it = lower_bound(lo); it != end() && out.size() < limit; ++it) {
+        if (!(it.key() < hi)) {
+          break;
+        }
+        out.push_back(*it);
+      }
+      return out;
+    }
+
+    /**
+     * @brief Gets one page of entries in key order
+     * @details Pass the last key of the previous page as the cursor to get
+     *          the next one; the cursor stays valid across inserts and
+     *          removes made in between.
+     * @param after Return entries with keys greater than this; std::nullopt
+     *              to start from the smallest key
+     * @param limit The maximum number of entries to return
+     * @return The entries in key order
+     */
+    std::vector<std::pair<K, V>> page(const std::optional<K> &after, size_t limit) const {
+      std::vector<std::pair<K, V>> out;
+      for (iterator it = after ? upper_bound(*after) : begin(); it != end() && out.size() < limit; ++it) {
+        out.push_back(*it);
+      }
+      return out;
+    }
+
+    /**
+     * @brief Gets the state ID of this map
+     * @return The state ID
+     */
+    uint8_t getStateId() const { return this->state_id; }
+
+    /**
+     * @brief Sets the state ID of this map
+     * @param _stateId The new state ID to set
+     */
+    void setStateId(uint8_t _stateId) {
+      this->state_id = _stateId;
+      pages.setStateId(_stateId);
+      header_.setStateId(_stateId);
+    }
+
+    /**
+     * @brief Serializes the map metadata to JSON
+     * @param j The JSON object to populate
+     */
+    inline void to_json(nlohmann::json &j) {
+      j = nlohmann::json::object();
+      j["state_id"] = getStateId();
+    }
+
+    /**
+     * @brief Deserializes the map metadata from JSON
+     * @param j The JSON object to deserialize from
+     */
+    inline void from_json(const nlohmann::json &j) {
+      setStateId(j["state_id"]);
+    }
+  };
+} // namespace collections
+
+#endif // SORTED_MAP_HPP
@@ -3,41 +3,90 @@
  * @brief Implementation of a persistent vector collection
  * @details This file provides the WeilVec template class, which implements a
  *          persistent vector/array that stores data in the blockchain state.
- *          It supports push, pop, get, set operations with automatic JSON
- *          serialization/deserialization, and provides iterator support.
+ *          It supports push, pop, get, set operations with automatic
+ *          serialization through a pluggable codec (JSON by default), bulk
+ *          extend/get_range/truncate, and a prefetching iterator.
  */
 
 #ifndef VECTOR_HPP
 #define VECTOR_HPP
 
+#include "codec.hpp"
 #include "collections.hpp"
+#include "key_encoder.hpp"
 #include "weilsdk/memory.h"
+#include "weilsdk/stats.h"
 #include "external/nlohmann.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
-extern "C" void write_collection(int key, int val);
+extern "C" void write_collection(int key, int val)
 __attribute__((import_name("write_collection")));
-extern "C" int delete_collection(int key);
+extern "C" int delete_collection(int key)
 __attribute__((import_name("delete_collection")));
-extern "C" int read_collection(int key);
+extern "C" int read_collection(int key)
 __attribute__((import_name("read_collection")));
 
 namespace collections {
   /**
    * @brief A persistent vector/array collection
    * @tparam T The type of elements stored in the vector
+   * @tparam Codec How elements are encoded for storage (see codec.hpp)
    * @details This class provides a persistent vector implementation that stores
    *          elements in the blockchain state. Elements are automatically
-   *          serialized to JSON for storage and deserialized when retrieved.
+   *          encoded with Codec for storage and decoded when retrieved.
    *          The vector supports standard operations like push, pop, get, and set.
+   *
+   *          Element i is stored under "<state_id>_" followed by i as 8 hex
+   *          digits (see key_encoder.hpp), so each aligned window of kWindow
+   *          elements shares one key prefix and can be fetched with a single
+   *          Memory::readBulkCollection call.
    */
-  template <typename T>
+  template <typename T, typename Codec = JsonCodec<T>>
   class WeilVec : public collections::Collection<int> {
   private:
     uint8_t state_id; ///< The state ID used to identify this vector in storage
     int len;          ///< The current length of the vector
 
+    static constexpr size_t kWindowBits = 8;
+    static constexpr size_t kWindow = size_t(1) << kWindowBits; ///< Elements per bulk read
+
+    /**
+     * @brief Writes "<state_id>_" into a key buffer
+     */
+    void append_base(KeyBuffer &buf) const {
+      buf.append_decimal(state_id);
+      buf.push_back('_');
+    }
+
+    /**
+     * @brief Reads the aligned window of elements containing an index
+     * @param first The first index of the window; a multiple of kWindow
+     * @return The window's elements in index order, std::nullopt where absent
+     */
+    std::vector<std::optional<T>> read_window(size_t first) const {
+      using Raw = std::vector<std::pair<std::string, std::string>>;
+      // The window's keys share all but the last kWindowBits / 4 hex digits
+      std::string prefix = state_tree_key(first);
+      prefix.resize(prefix.size() - kWindowBits / 4);
+      size_t key_len = prefix.size() + kWindowBits / 4;
+
+      std::vector<std::optional<T>> window(kWindow);
+      Raw raw = weilsdk::Memory::readPrefixForTrie<Raw>(prefix).value_or(Raw{});
+      for (const auto &entry : raw) {
+        if (entry.first.size() != key_len) {
+          continue;
+        }
+        const char *p = entry.first.data() + prefix.size();
+        window[text::from_hex<uint8_t>(p)] = Codec::decode(entry.second);
+      }
+      return window;
+    }
+
   public:
     /**
      * @brief Constructs a WeilVec with an uninitialized state ID and zero length
@@ -74,7 +123,10 @@ namespace collections {
      * @return The full state tree key as a string
      */
     std::string state_tree_key(const size_t &index) const {
-      return base_state_path() + "_" + std::to_string(index);
+      KeyBuffer buf;
+      append_base(buf);
+      KeyEncoder<uint32_t>::encode(buf, static_cast<uint32_t>(index), false);
+      return buf.str();
     }
 
     /**
@@ -82,10 +134,9 @@ namespace collections {
      * @param item The element to append
      */
     void push(const T &item) {
-      nlohmann::json jsonPayload = item;
-      std::string serializedPayload = jsonPayload.dump();
+      std::string serializedPayload = Codec::encode(item);
 
-      weilsdk::Memory::writeCollection(state_tree_key(len), serializedPayload);
+      weilsdk::CountedMemory::writeCollection(state_tree_key(len), serializedPayload);
       len++;
     }
 
@@ -95,14 +146,13 @@ namespace collections {
      * @return The element at the specified index, or a default-constructed value if not found
      */
     T get(int index) const {
-      auto result = weilsdk::Memory::readCollection(state_tree_key(index));
+      auto result = weilsdk::CountedMemory::readCollection(state_tree_key(index));
       std::string s = result.second;
       if (result.first) {
         T t;
         return t;
       }
-      nlohmann::json j = nlohmann::json::parse(s);
-      T t1 = j.get<T>();
+      T t1 = Codec::decode(s);
       return t1;
     }
     
@@ -117,10 +167,9 @@ namespace collections {
         return;
       }
       // serialize
-      nlohmann::json jsonPayload = item;
-      std::string serializedPayload = jsonPayload.dump();
+      std::string serializedPayload = Codec::encode(item);
 
-      weilsdk::Memory::writeCollection(state_tree_key(index), serializedPayload);
+      weilsdk::CountedMemory::writeCollection(state_tree_key(index), serializedPayload);
     }
     
     /**
@@ -130,15 +179,88 @@ namespace collections {
     T pop() {
 
       std::pair<int, std::string> res =
-          weilsdk::Memory::deleteCollection(state_tree_key(len-1));
+          weilsdk::CountedMemory::deleteCollection(state_tree_key(len-1));
       std::string s = res.second;
       if (res.first) {
         T t1;
         return t1;
       }
       len--;
-      nlohmann::json j = nlohmann::json::parse(s);
-      return j.get<T>();
+      return Codec::decode(s);
+    }
+
+    /**
+     * @brief Appends every element of a range
+     * @details Encodes each element once and writes them all in one
+     *          writeCollections batch; no element is read back.
+     * @param items Any range of T
+     */
+    template <typename Range>
+    void extend(const Range &items) {
+      std::vector<std::pair<std::string, std::string>> entries;
+      size_t index = static_cast<size_t>(len);
+      for (const auto &item : items) {
+        entries.emplace_back(state_tree_key(index++), Codec::encode(item));
+      }
+      if (entries.empty()) {
+        return;
+      }
+      weilsdk::CountedMemory::writeCollections(entries);
+      len = static_cast<int>(index);
+    }
+
+    /**
+     * @brief Gets a run of consecutive elements
+     * @details Costs one bulk read per window of kWindow elements the run
+     *          touches, or a single read when only one element of a window is
+     *          wanted. The run is clipped to the vector's length.
+     * @param first The index of the first element
+     * @param count The number of elements
+     * @return The elements, with a default-constructed value for any missing
+     */
+    std::vector<T> get_range(size_t first, size_t count) const {
+      std::vector<T> out;
+      size_t last = std::min(first + count, static_cast<size_t>(std::max(len, 0)));
+      if (first >= last) {
+        return out;
+      }
+      out.reserve(last - first);
+      size_t i = first;
+      while (i < last) {
+        size_t window_first = i & ~(kWindow - 1);
+        size_t window_last = std::min(window_first + kWindow, last);
+        if (window_last - i == 1) {
+          out.push_back(get(static_cast<int>(i)));
+          i = window_last;
+          continue;
+        }
+        std::vector<std::optional<T>> window = read_window(window_first);
+        for (; i < window_last; ++i) {
+          std::optional<T> &value = window[i - window_first];
+          out.push_back(value ? std::move(*value) : T());
+        }
+      }
+      return out;
+    }
+
+    /**
+     * @brief Shrinks the vector to its first n elements
+     * @details Deletes the dropped elements in one deleteCollections batch,
+     *          without reading or decoding them. Does nothing if the vector
+     *          is not longer than n.
+     * @param n The new length
+     */
+    void truncate(size_t n) {
+      if (static_cast<size_t>(len) <= n) {
+        return;
+      }
+      std::vector<std::string> keys;
+      keys.reserve(static_cast<size_t>(len) - n);
+      for (size_t index = n; index < static_cast<size_t>(len); ++index) {
+        keys.push_back(state_tree_key(index));
+      }
+      weilsdk::CountedMemory::deleteCollections(keys);
+      len = static_cast<int>(n);
     }
 
     /**
@@ -161,12 +283,18 @@ namespace collections {
      * @brief Forward iterator for WeilVec
      * @details This iterator allows forward iteration over the elements of the vector.
      *          It provides standard iterator operations including dereference, increment,
-     *          and comparison.
+     *          and comparison. Elements are fetched and decoded a window of
+     *          kWindow at a time, so a full walk costs len / kWindow host calls.
+     *          Copies of an iterator share the window they have fetched.
      */
     class iterator {
     private:
-      const WeilVec *vector; ///< Pointer to the vector being iterated
-      int current;           ///< Current index position
+      using Window = std::vector<std::optional<T>>;
+
+      const WeilVec *vector;                 ///< Pointer to the vector being iterated
+      int current;                           ///< Current index position
+      mutable std::shared_ptr<Window> window; ///< Prefetched elements
+      mutable size_t window_first;           ///< Index of window's first element
 
     public:
       using iterator_category = std::forward_iterator_tag; ///< Iterator category
@@ -181,14 +309,20 @@ namespace collections {
        * @param idx The starting index
        */
       iterator(const WeilVec *v, int idx)
-          : vector(v), current(idx) {}
+          : vector(v), current(idx), window_first(0) {}
 
       /**
        * @brief Dereferences the iterator to get the current element
        * @return The element at the current index
        */
       T operator*() const {
-        return vector->get(current);
+        size_t index = static_cast<size_t>(current);
+        if (!window || index - window_first >= kWindow) {
+          window_first = index & ~(kWindow - 1);
+          window = std::make_shared<Window>(vector->read_window(window_first));
+        }
+        const std::optional<T> &value = (*window)[index - window_first];
+        return value ? *value : T();
       }
 
       /**
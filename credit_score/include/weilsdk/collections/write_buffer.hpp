@@ -0,0 +1,159 @@
+/**
+ * @file write_buffer.hpp
+ * @brief Per-invocation write-back overlay for collection mutations
+ * @details Collections that opt in record inserts and removes here instead of
+ *          writing through to the host. Later reads of a buffered key see the
+ *          buffered value (read-your-writes), repeated writes to one key
+ *          coalesce, and flush() hands every dirty key to the host in one
+ *          writeCollections batch (deletes still go one key at a time).
+ *          The generated entry points call flush() right before
+ *          Runtime::setStateAndResult; anything still buffered when the
+ *          invocation's InvocationScope closes belonged to a method that
+ *          bailed out with an error and is discarded.
+ */
+
+#ifndef WRITE_BUFFER_HPP
+#define WRITE_BUFFER_HPP
+
+#include "weilsdk/memory.h"
+#include "weilsdk/stats.h"
+#include <any>
+#include <map>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace collections {
+  /**
+   * @brief Process-wide buffer shared by all write-back collections
+   * @details Values are kept decoded (as std::optional<V>, std::nullopt for a
+   *          pending delete) and only encoded once, with the owning
+   *          collection's codec, at flush time.
+   */
+  class WriteBuffer {
+  private:
+    struct Entry {
+      std::any value;                          ///< std::optional<V>
+      std::string (*encode)(const std::any &); ///< Serializer for V
+      bool erased;                             ///< Pending delete
+    };
+
+    struct Data {
+      std::map<std::string, Entry> pending; ///< Ordered so flushes are deterministic
+    };
+
+    static Data &data() {
+      static Data d;
+      return d;
+    }
+
+    template <typename V, typename Codec>
+    static std::string encode(const std::any &value) {
+      return Codec::encode(**std::any_cast<std::optional<V>>(&value));
+    }
+
+  public:
+    /**
+     * @brief Looks up a buffered value
+     * @tparam V The decoded value type
+     * @param key The state tree key
+     * @return nullptr if the key has no pending mutation; otherwise the
+     *         buffered value, which is std::nullopt for a pending delete
+     */
+    template <typename V>
+    static const std::optional<V> *find(const std::string &key) {
+      auto &pending = data().pending;
+      auto it = pending.find(key);
+      if (it == pending.end()) {
+        return nullptr;
+      }
+      return std::any_cast<std::optional<V>>(&it->second.value);
+    }
+
+    /**
+     * @brief Buffers a write, replacing any earlier mutation of the key
+     * @tparam Codec The codec the value is encoded with at flush time
+     */
+    template <typename V, typename Codec>
+    static void put(const std::string &key, const V &value) {
+      data().pending[key] = Entry{std::optional<V>(value), &encode<V, Codec>, false};
+    }
+
+    /**
+     * @brief Buffers a delete, replacing any earlier mutation of the key
+     */
+    template <typename V>
+    static void erase(const std::string &key) {
+      data().pending[key] = Entry{std::optional<V>(), nullptr, true};
+    }
+
+    /**
+     * @brief Collects the buffered mutations of every key under a prefix
+     * @param prefix The state tree key prefix
+     * @return Buffered values by state tree key, std::nullopt for deletes
+     */
+    template <typename V>
+    static std::map<std::string, std::optional<V>> with_prefix(const std::string &prefix) {
+      std::map<std::string, std::optional<V>> out;
+      auto &pending = data().pending;
+      for (auto it = pending.lower_bound(prefix);
+           it != pending.end() && it->first.compare(0, prefix.size(), prefix) == 0;
+           ++it) {
+        if (const auto *value = std::any_cast<std::optional<V>>(&it->second.value)) {
+          out.emplace(it->first, *value);
+        }
+      }
+      return out;
+    }
+
+    /**
+     * @brief Lists the keys under a prefix with a buffered mutation
+     * @details Unlike with_prefix(), covers values of every type.
+     * @param prefix The state tree key prefix
+     * @return The state tree keys, deletes included, in key order
+     */
+    static std::vector<std::string> keys_with_prefix(const std::string &prefix) {
+      std::vector<std::string> out;
+      auto &pending = data().pending;
+      for (auto it = pending.lower_bound(prefix);
+           it != pending.end() && it->first.compare(0, prefix.size(), prefix) == 0;
+           ++it) {
+        out.push_back(it->first);
+      }
+      return out;
+    }
+
+    /**
+     * @brief Number of dirty keys waiting to be flushed
+     */
+    static size_t size() { return data().pending.size(); }
+
+    /**
+     * @brief Writes every dirty key to the host, once, and empties the buffer
+     */
+    static void flush() {
+      auto &pending = data().pending;
+      std::vector<std::pair<std::string, std::string>> writes;
+      writes.reserve(pending.size());
+      for (auto &kv : pending) {
+        if (kv.second.erased) {
+          weilsdk::CountedMemory::deleteCollection(kv.first);
+        } else {
+          writes.emplace_back(kv.first, kv.second.encode(kv.second.value));
+        }
+      }
+      if (!writes.empty()) {
+        weilsdk::CountedMemory::writeCollections(writes);
+      }
+      pending.clear();
+    }
+
+    /**
+     * @brief Drops every buffered mutation without writing it
+     */
+    static void discard() { data().pending.clear(); }
+  };
+} // namespace collections
+
+#endif // WRITE_BUFFER_HPP
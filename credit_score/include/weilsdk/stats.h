@@ -0,0 +1,274 @@
+/**
+ * @file stats.h
+ * @brief Per-invocation host-call, byte and JSON counters
+ * @details Every host crossing is reported here by the inline wrappers the
+ *          SDK and the generated glue call the host through (CountedMemory,
+ *          CountedRuntime). JSON work is counted by the collection codecs and
+ *          by CountedJson, which the glue parses its arguments and state and
+ *          dumps its results through, and contracts use for the JSON they
+ *          handle themselves. Counting lives in headers so that it is compiled
+ *          into the contract and works the same on-chain and natively. Counters
+ *          are collected per invocation of an exported method and folded into
+ *          per-method totals when the invocation ends. Totals are what the
+ *          generated `__stats` query returns; when logging is enabled each
+ *          invocation's counters are also emitted through Runtime::debugLog.
+ *
+ *          Define WEILSDK_STATS_LOG to turn logging on at compile time.
+ */
+
+#ifndef STATS_H
+#define STATS_H
+
+#include "external/nlohmann.hpp"
+#include "weilsdk/runtime.h"
+#include <cstdint>
+#include <map>
+#include <string>
+#include <utility>
+#include <variant>
+
+namespace weilsdk {
+
+  struct HostCounters {
+    uint64_t host_calls = 0;    ///< Crossings into the host, of any kind
+    uint64_t reads = 0;         ///< Keys read by readCollection(s)
+    uint64_t bulk_reads = 0;    ///< Memory::readBulkCollection calls
+    uint64_t writes = 0;        ///< Keys written by writeCollection(s)
+    uint64_t deletes = 0;       ///< Keys deleted by deleteCollection(s)
+    uint64_t bytes_read = 0;    ///< Bytes handed back by the host
+    uint64_t bytes_written = 0; ///< Bytes handed to the host (keys included)
+    uint64_t json_parses = 0;   ///< Documents parsed by the codecs and CountedJson
+    uint64_t json_dumps = 0;    ///< Documents serialized by the codecs and CountedJson
+
+    void add(const HostCounters &other) {
+      host_calls += other.host_calls;
+      reads += other.reads;
+      bulk_reads += other.bulk_reads;
+      writes += other.writes;
+      deletes += other.deletes;
+      bytes_read += other.bytes_read;
+      bytes_written += other.bytes_written;
+      json_parses += other.json_parses;
+      json_dumps += other.json_dumps;
+    }
+  };
+
+  inline void to_json(nlohmann::json &j, const HostCounters &c) {
+    j = nlohmann::json{
+      {"host_calls", c.host_calls},
+      {"reads", c.reads},
+      {"bulk_reads", c.bulk_reads},
+      {"writes", c.writes},
+      {"deletes", c.deletes},
+      {"bytes_read", c.bytes_read},
+      {"bytes_written", c.bytes_written},
+      {"json_parses", c.json_parses},
+      {"json_dumps", c.json_dumps},
+    };
+  }
+
+  class Stats {
+    private:
+      struct MethodTotals {
+        uint64_t calls = 0;
+        HostCounters counters;
+      };
+
+      struct Data {
+        std::string method;
+        HostCounters current;
+        std::map<std::string, MethodTotals> totals;
+#ifdef WEILSDK_STATS_LOG
+        bool logging = true;
+#else
+        bool logging = false;
+#endif
+      };
+
+      static Data &data() {
+        static Data d;
+        return d;
+      }
+
+    public:
+      // Counters of the invocation in flight
+      static HostCounters &current() { return data().current; }
+
+      static void setLogging(bool enabled) { data().logging = enabled; }
+
+      // Starts attributing counters to `method`
+      static void begin(const std::string &method) {
+        data().method = method;
+        data().current = HostCounters{};
+      }
+
+      // Folds the invocation into the per-method totals
+      static void end() {
+        Data &d = data();
+        MethodTotals &t = d.totals[d.method];
+        t.calls++;
+        t.counters.add(d.current);
+        if (d.logging) {
+          nlohmann::json j = d.current;
+          Runtime::debugLog("__stats " + d.method + " " + j.dump());
+        }
+        d.method.clear();
+      }
+
+      static void onRead(size_t key_len, size_t val_len) {
+        HostCounters &c = current();
+        c.host_calls++;
+        c.reads++;
+        c.bytes_written += key_len;
+        c.bytes_read += val_len;
+      }
+
+      static void onBulkRead(size_t prefix_len, size_t val_len) {
+        HostCounters &c = current();
+        c.host_calls++;
+        c.bulk_reads++;
+        c.bytes_written += prefix_len;
+        c.bytes_read += val_len;
+      }
+
+      static void onWrite(size_t key_len, size_t val_len) {
+        HostCounters &c = current();
+        c.host_calls++;
+        c.writes++;
+        c.bytes_written += key_len + val_len;
+      }
+
+      // One crossing for a whole readCollections/writeCollections/
+      // deleteCollections batch
+      static void onReadBatch(size_t keys, size_t key_bytes, size_t val_bytes) {
+        HostCounters &c = current();
+        c.host_calls++;
+        c.reads += keys;
+        c.bytes_written += key_bytes;
+        c.bytes_read += val_bytes;
+      }
+
+      static void onWriteBatch(size_t keys, size_t bytes) {
+        HostCounters &c = current();
+        c.host_calls++;
+        c.writes += keys;
+        c.bytes_written += bytes;
+      }
+
+      static void onDeleteBatch(size_t keys, size_t key_bytes) {
+        HostCounters &c = current();
+        c.host_calls++;
+        c.deletes += keys;
+        c.bytes_written += key_bytes;
+      }
+
+      static void onDelete(size_t key_len, size_t val_len) {
+        HostCounters &c = current();
+        c.host_calls++;
+        c.deletes++;
+        c.bytes_written += key_len;
+        c.bytes_read += val_len;
+      }
+
+      // Runtime crossings: state/args fetches and result/state hand-back
+      static void onRuntime(size_t bytes_in, size_t bytes_out) {
+        HostCounters &c = current();
+        c.host_calls++;
+        c.bytes_read += bytes_in;
+        c.bytes_written += bytes_out;
+      }
+
+      static void onParse() { current().json_parses++; }
+      static void onDump() { current().json_dumps++; }
+
+      // {"<method>": {"calls": n, <HostCounters totals>}, ...}
+      static std::string report() {
+        nlohmann::json j = nlohmann::json::object();
+        for (const auto &kv : data().totals) {
+          nlohmann::json m = kv.second.counters;
+          m["calls"] = kv.second.calls;
+          j[kv.first] = m;
+        }
+        return j.dump();
+      }
+  };
+
+  // Attributes every host crossing made during its lifetime to one method
+  class StatsScope {
+    public:
+      explicit StatsScope(const std::string &method) { Stats::begin(method); }
+      ~StatsScope() { Stats::end(); }
+
+      StatsScope(const StatsScope &) = delete;
+      StatsScope &operator=(const StatsScope &) = delete;
+  };
+
+  // Runtime as the generated glue calls it: each call forwards to the host
+  // binding and reports the crossing to Stats
+  class CountedRuntime {
+    public:
+      static std::string state() {
+        std::string s = Runtime::state();
+        Stats::onRuntime(s.size(), 0);
+        return s;
+      }
+
+      static std::string args() {
+        std::string s = Runtime::args();
+        Stats::onRuntime(s.size(), 0);
+        return s;
+      }
+
+      static std::pair<std::string, std::string> stateAndArgs() {
+        std::pair<std::string, std::string> p = Runtime::stateAndArgs();
+        Stats::onRuntime(p.first.size() + p.second.size(), 0);
+        return p;
+      }
+
+      static StateArgsView stateAndArgsView() {
+        StateArgsView p = Runtime::stateAndArgsView();
+        Stats::onRuntime(p.state.size() + p.args.size(), 0);
+        return p;
+      }
+
+      static void setState(std::string state) {
+        Stats::onRuntime(0, state.size());
+        Runtime::setState(std::move(state));
+      }
+
+      static void setResult(std::string result, int error) {
+        Stats::onRuntime(0, result.size());
+        Runtime::setResult(std::move(result), error);
+      }
+
+      static void setStateAndResult(std::variant<WeilValue, std::string> result) {
+        if (std::holds_alternative<std::string>(result)) {
+          Stats::onRuntime(0, std::get<std::string>(result).size());
+        } else {
+          WeilValue &wv = std::get<WeilValue>(result);
+          Stats::onRuntime(0, (wv.has_state() ? wv.state.size() : 0) + wv.ok_val.size());
+        }
+        Runtime::setStateAndResult(std::move(result));
+      }
+  };
+
+  // JSON parsing and dumping as the glue and the contracts do it outside
+  // the collection codecs: each call is reported to Stats
+  class CountedJson {
+    public:
+      template <typename J, typename... Args>
+      static J parse(Args &&...args) {
+        Stats::onParse();
+        return J::parse(std::forward<Args>(args)...);
+      }
+
+      template <typename J>
+      static std::string dump(const J &j) {
+        Stats::onDump();
+        return j.dump();
+      }
+  };
+
+} // namespace weilsdk
+
+#endif // STATS_H
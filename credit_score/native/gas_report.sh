@@ -0,0 +1,33 @@
+#!/usr/bin/env bash
+# Runs get_score over a few applicant profiles through the native runner and
+# prints its simulated gas per profile.
+#
+#   native/gas_report.sh <runner>
+#
+# <runner> is the native credit_score executable, built without Emscripten:
+#
+#   cmake -S . -B build-native && cmake --build build-native
+#   native/gas_report.sh build-native/credit_score
+#
+# Extra runner options such as --gas-limit or --cost can be passed through
+# GAS_OPTS.
+set -euo pipefail
+
+if (($# < 1)); then
+  echo "usage: $0 <runner>" >&2
+  exit 2
+fi
+
+runner=$1
+
+profiles=(
+  '{"account_age_months":1,"monthly_income_avg":0,"income_frequency":"irregular","monthly_rent":0,"monthly_utilities":0,"missed_payments_count":0}'
+  '{"account_age_months":12,"monthly_income_avg":3000,"income_frequency":"monthly","monthly_rent":1000,"monthly_utilities":100,"missed_payments_count":0}'
+  '{"account_age_months":120,"monthly_income_avg":12000,"income_frequency":"weekly","monthly_rent":2500,"monthly_utilities":300,"missed_payments_count":7}'
+)
+
+for args in "${profiles[@]}"; do
+  echo "== $args"
+  # shellcheck disable=SC2086
+  echo "get_score $args" | "$runner" --quiet --gas ${GAS_OPTS:-} 2>&1
+done
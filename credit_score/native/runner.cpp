@@ -0,0 +1,216 @@
+/**
+ * @file runner.cpp
+ * @brief Command-line driver for a contract linked against the native host
+ * @details Deploys the contract (calls `init`) and then replays a script of
+ *          invocations, one per line:
+ *
+ *              <method> [json-args]
+ *
+ *          Blank lines and lines starting with '#' are skipped. The script is
+ *          read from the file given on the command line, or from stdin.
+ *          Exported methods are resolved by name from the executable's own
+ *          dynamic symbol table, so the driver does not need to know the
+ *          contract's interface.
+ *
+ *          Options:
+ *            --repeat N   run every script line N times (for profiling)
+ *            --quiet      only print the per-method timing summary
+ *            --debug      forward Runtime::debugLog to stderr
+ *            --stats      log every invocation's host counters (implies --debug)
+ *            --gas        add simulated gas columns to the summary
+ *            --gas-limit N
+ *                         per-invocation gas limit (0 for none)
+ *            --cost call=N,read_byte=N,write_byte=N,trie_level=N
+ *                         override entries of the gas schedule
+ *
+ *          Gas comes from the host's CostModel (see weil_host.h). An
+ *          invocation that goes over the limit still completes here but is
+ *          counted in the `oog` column; on the node it would have failed.
+ */
+
+#include "weil_host.h"
+#include "weilsdk/stats.h"
+
+#include <dlfcn.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+
+namespace {
+
+  using Method = void (*)();
+
+  struct Timing {
+    uint64_t calls = 0;
+    uint64_t errors = 0;
+    double micros = 0;
+    uint64_t gas = 0;
+    uint64_t max_gas = 0;
+    uint64_t out_of_gas = 0;
+  };
+
+  Method resolve(const std::string &name) {
+    return reinterpret_cast<Method>(dlsym(RTLD_DEFAULT, name.c_str()));
+  }
+
+  int usage(const char *argv0) {
+    std::cerr << "usage: " << argv0
+              << " [--repeat N] [--quiet] [--debug] [--stats] [--gas] [--gas-limit N]"
+                 " [--cost name=N,...] [script]"
+              << std::endl;
+    return 2;
+  }
+
+  // Applies a `name=N,name=N` list to the cost model; false on a bad entry
+  bool parseCost(const std::string &spec, weilsdk::host::CostModel &model) {
+    std::istringstream ss(spec);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+      size_t eq = item.find('=');
+      if (eq == std::string::npos) {
+        return false;
+      }
+      std::string name = item.substr(0, eq);
+      uint64_t value = std::strtoull(item.c_str() + eq + 1, nullptr, 10);
+      if (name == "call") {
+        model.per_call = value;
+      } else if (name == "read_byte") {
+        model.per_byte_read = value;
+      } else if (name == "write_byte") {
+        model.per_byte_written = value;
+      } else if (name == "trie_level") {
+        model.per_trie_level = value;
+      } else {
+        return false;
+      }
+    }
+    return true;
+  }
+
+} // namespace
+
+int main(int argc, char **argv) {
+  uint64_t repeat = 1;
+  bool quiet = false;
+  bool gas = false;
+  weilsdk::host::CostModel cost;
+  std::string script;
+
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--repeat" && i + 1 < argc) {
+      repeat = std::strtoull(argv[++i], nullptr, 10);
+    } else if (arg == "--quiet") {
+      quiet = true;
+    } else if (arg == "--debug") {
+      weilsdk::host::Host::setDebugLog(true);
+    } else if (arg == "--stats") {
+      weilsdk::Stats::setLogging(true);
+      weilsdk::host::Host::setDebugLog(true);
+    } else if (arg == "--gas") {
+      gas = true;
+    } else if (arg == "--gas-limit" && i + 1 < argc) {
+      cost.gas_limit = std::strtoull(argv[++i], nullptr, 10);
+    } else if (arg == "--cost" && i + 1 < argc) {
+      if (!parseCost(argv[++i], cost)) {
+        return usage(argv[0]);
+      }
+    } else if (!arg.empty() && arg[0] != '-' && script.empty()) {
+      script = arg;
+    } else {
+      return usage(argv[0]);
+    }
+  }
+  weilsdk::host::Host::setCostModel(cost);
+
+  std::ifstream file;
+  if (!script.empty()) {
+    file.open(script);
+    if (!file) {
+      std::cerr << "cannot open " << script << std::endl;
+      return 1;
+    }
+  }
+  std::istream &in = script.empty() ? std::cin : file;
+
+  Method init = resolve("init");
+  if (init == nullptr) {
+    std::cerr << "contract does not export init" << std::endl;
+    return 1;
+  }
+  weilsdk::host::Host::invoke(init, "{}");
+
+  std::map<std::string, Timing> timings;
+  std::string line;
+  while (std::getline(in, line)) {
+    if (line.empty() || line[0] == '#') {
+      continue;
+    }
+    std::istringstream ls(line);
+    std::string name;
+    ls >> name;
+    std::string args;
+    std::getline(ls >> std::ws, args);
+    if (args.empty()) {
+      args = "{}";
+    }
+
+    Method method = resolve(name);
+    if (method == nullptr) {
+      std::cerr << "unknown method: " << name << std::endl;
+      return 1;
+    }
+
+    Timing &t = timings[name];
+    for (uint64_t r = 0; r < repeat; ++r) {
+      auto start = std::chrono::steady_clock::now();
+      weilsdk::host::Outcome out = weilsdk::host::Host::invoke(method, args);
+      auto stop = std::chrono::steady_clock::now();
+
+      double us = std::chrono::duration<double, std::micro>(stop - start).count();
+      t.calls++;
+      t.micros += us;
+      if (out.error) {
+        t.errors++;
+      }
+      t.gas += out.gas_used;
+      t.max_gas = std::max(t.max_gas, out.gas_used);
+      if (out.out_of_gas) {
+        t.out_of_gas++;
+      }
+      if (!quiet && r == 0) {
+        std::cout << name << (out.error ? " err " : " ok ") << out.result
+                  << std::endl;
+      }
+    }
+  }
+
+  std::cerr << "method                     calls   errors    avg_us";
+  if (gas) {
+    std::cerr << "      avg_gas      max_gas   oog";
+  }
+  std::cerr << std::endl;
+  for (const auto &kv : timings) {
+    const Timing &t = kv.second;
+    char row[192];
+    int n = std::snprintf(row, sizeof(row), "%-24s %8llu %8llu %9.2f", kv.first.c_str(),
+                          static_cast<unsigned long long>(t.calls),
+                          static_cast<unsigned long long>(t.errors),
+                          t.calls ? t.micros / t.calls : 0.0);
+    if (gas) {
+      std::snprintf(row + n, sizeof(row) - n, " %12llu %12llu %5llu",
+                    static_cast<unsigned long long>(t.calls ? t.gas / t.calls : 0),
+                    static_cast<unsigned long long>(t.max_gas),
+                    static_cast<unsigned long long>(t.out_of_gas));
+    }
+    std::cerr << row << std::endl;
+  }
+  return 0;
+}
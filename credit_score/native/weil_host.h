@@ -0,0 +1,123 @@
+/**
+ * @file weil_host.h
+ * @brief In-process emulator of the Weilliptic host for native builds
+ * @details The wasm build links the contract against libweilsdk_static.a and
+ *          resolves the state imports inside the Weilliptic node. The native
+ *          build links against weil_host.cpp instead, which implements
+ *          weilsdk::Runtime, weilsdk::Memory and weilsdk::Ledger on top of an
+ *          ordered in-memory key space. This header is the control surface a
+ *          driver uses to seed the environment and invoke exported methods.
+ */
+
+#ifndef WEIL_HOST_H
+#define WEIL_HOST_H
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+#include <utility>
+
+namespace weilsdk {
+namespace host {
+
+  /**
+   * @brief What an exported method handed back to the host
+   */
+  struct Outcome {
+    std::string result;         ///< Serialized result or error payload
+    int error = 0;              ///< Non-zero when the method reported an error
+    bool state_written = false; ///< true if the method persisted a new contract state
+    uint64_t gas_used = 0;      ///< Simulated gas, see CostModel
+    bool out_of_gas = false;    ///< gas_used went over CostModel::gas_limit
+  };
+
+  /**
+   * @brief Simulated gas schedule charged for every host call
+   * @details A call costs per_call, plus per_byte_read for every byte the
+   *          host hands back and per_byte_written for every byte handed to
+   *          it (keys included), plus per_trie_level for each level of the
+   *          state trie walked per storage key it touches. The trie is
+   *          modelled as branching on hex nibbles, so its depth grows with
+   *          log16 of the number of keys stored.
+   *
+   *          The defaults are not the node's schedule. They are calibrated
+   *          so that in_memory_db's drop_table runs out of gas at around
+   *          2000 records, as its comment warns; set the node's figures to
+   *          get absolute numbers.
+   */
+  struct CostModel {
+    uint64_t per_call = 1000;
+    uint64_t per_byte_read = 1;
+    uint64_t per_byte_written = 10;
+    uint64_t per_trie_level = 100;
+    uint64_t gas_limit = 10000000; ///< Per invocation; 0 for no limit
+  };
+
+  /**
+   * @brief Handler for cross-contract calls made through Runtime::callContract
+   * @details Receives (contract id, method name, serialized args) and returns
+   *          the same (error, payload) pair the real host would.
+   */
+  using CallHandler = std::function<std::pair<int, std::string>(
+      const std::string &, const std::string &, const std::string &)>;
+
+  /**
+   * @brief Process-wide emulated host
+   * @details All state is global, mirroring a single deployed contract. The
+   *          key space is an ordered map so prefix reads behave like the
+   *          node's state trie.
+   */
+  class Host {
+    public:
+      /**
+       * @brief Drops all collection entries, balances and contract state
+       */
+      static void reset();
+
+      /**
+       * @brief The ordered key space backing Memory::*Collection
+       */
+      static std::map<std::string, std::string> &keySpace();
+
+      /**
+       * @brief The serialized contract state persisted between invocations
+       */
+      static std::string &contractState();
+
+      static void setContractId(std::string id);
+      static void setSender(std::string sender);
+      static void setLedgerContractId(std::string id);
+      static void setBlockHeight(uint64_t height);
+      static void setBlockTimestamp(std::string timestamp);
+
+      /**
+       * @brief Routes Runtime::debugLog to stderr when enabled
+       */
+      static void setDebugLog(bool enabled);
+
+      /**
+       * @brief Installs the handler used for callContract/callXpodContract
+       */
+      static void setCallHandler(CallHandler handler);
+
+      /**
+       * @brief Replaces the gas schedule applied from the next host call on
+       */
+      static void setCostModel(const CostModel &model);
+      static const CostModel &costModel();
+
+      /**
+       * @brief Runs one exported method the way the node would
+       * @param method The exported entry point (e.g. `insert`)
+       * @param args The serialized method arguments
+       * @return The result the method set; the contract state is updated in
+       *         place when the method persisted one
+       */
+      static Outcome invoke(void (*method)(), const std::string &args);
+  };
+
+} // namespace host
+} // namespace weilsdk
+
+#endif // WEIL_HOST_H
@@ -8,6 +8,9 @@
 #include "weilsdk/utils.h"
 #include "weilsdk/runtime.h"
 #include "weilsdk/ledger.h"
+#include "weilsdk/arena.h"
+#include "weilsdk/stats.h"
+#include "weilsdk/collections/invocation.hpp"
 #include "contract.hpp"
 
 // Function declarations
@@ -17,6 +20,7 @@ extern "C" void init() __attribute__((export_name("init")));
 extern "C" void method_kind_data() __attribute__((export_name("method_kind_data")));
 extern "C" void get_score() __attribute__((export_name("get_score")));
 extern "C" void tools() __attribute__((export_name("tools")));
+extern "C" void __stats() __attribute__((export_name("__stats")));
 
 // Global contract state instance
 credit_score_ContractState credit_score_instance;
@@ -32,8 +36,8 @@ struct get_score_args {
     uint32_t missed_payments_count;
 
     
-    friend void to_json(nlohmann::ordered_json &j, const get_score_args &obj) {
-        j = nlohmann::ordered_json::object();
+    friend void to_json(weilsdk::scratch_json &j, const get_score_args &obj) {
+        j = weilsdk::scratch_json::object();
 
             j["account_age_months"] = obj.account_age_months;
 
@@ -48,7 +52,7 @@ struct get_score_args {
             j["missed_payments_count"] = obj.missed_payments_count;
     }
     
-    friend void from_json(const nlohmann::ordered_json &j, get_score_args &obj) {
+    friend void from_json(const weilsdk::scratch_json &j, get_score_args &obj) {
         try {
 
             if (!j.contains("account_age_months")) {
@@ -89,68 +93,79 @@ struct get_score_args {
 extern "C" {
 
     int __new(size_t len, unsigned char _id) {
-        void *ptr = weilsdk::Runtime::allocate(len);
-        return reinterpret_cast<int>(ptr);
+        void *ptr = weilsdk::scratch_allocate(len);
+        return static_cast<int>(reinterpret_cast<uintptr_t>(ptr));
     }
     
     void __free(size_t ptr, size_t len) {
-        weilsdk::Runtime::deallocate(ptr, len);
+        weilsdk::scratch_deallocate(ptr, len);
     }
     
     
     // Initialize contract state
     void init() {
+        weilsdk::ArenaScope arena_scope;
+        collections::InvocationScope invocation_scope;
+        weilsdk::StatsScope stats_scope("init");
         credit_score_ContractState new_instance;
         // TODO: Initialize contract state as needed
     
         nlohmann::ordered_json j = new_instance;
         weilsdk::WeilValue wv;
-        wv.new_with_state_and_ok_value(j.dump(), "null");
-        weilsdk::Runtime::setStateAndResult(std::variant<weilsdk::WeilValue,std::string> {wv});
+        wv.new_with_state_and_ok_value(weilsdk::CountedJson::dump(j), "null");
+        weilsdk::CountedRuntime::setStateAndResult(std::variant<weilsdk::WeilValue,std::string> {std::move(wv)});
     }
     
     
     // Method kind data collection
     void method_kind_data() {
+        weilsdk::ArenaScope arena_scope;
+        collections::InvocationScope invocation_scope;
+        weilsdk::StatsScope stats_scope("method_kind_data");
         std::map<std::string, std::string> method_kind_mapping;
         
         
         method_kind_mapping["get_score"] = "query";
         method_kind_mapping["tools"] = "query";
+        method_kind_mapping["__stats"] = "query";
         nlohmann::ordered_json json_object = method_kind_mapping;
-        std::string serialized_string = json_object.dump();
-        weilsdk::Runtime::setResult(serialized_string, 0);
+        std::string serialized_string = weilsdk::CountedJson::dump(json_object);
+        weilsdk::CountedRuntime::setResult(serialized_string, 0);
     }
     
     
     void get_score() {
-            std::pair<std::string, std::string> p = weilsdk::Runtime::stateAndArgs();
-            std::string raw_args = p.second;
-            nlohmann::ordered_json j = nlohmann::ordered_json::parse(raw_args);
+        weilsdk::ArenaScope arena_scope;
+        collections::InvocationScope invocation_scope;
+        weilsdk::StatsScope stats_scope("get_score");
+            weilsdk::StateArgsView p = weilsdk::CountedRuntime::stateAndArgsView();
+            weilsdk::scratch_json j = weilsdk::CountedJson::parse<weilsdk::scratch_json>(p.args);
         
             if (j.is_discarded() || !j.contains("account_age_months") || !j.contains("monthly_income_avg") || !j.contains("income_frequency") || !j.contains("monthly_rent") || !j.contains("monthly_utilities") || !j.contains("missed_payments_count")) {
             weilsdk::MethodError me = weilsdk::MethodError("get_score", "invalid_args");
-            weilsdk::Runtime::setResult(weilsdk::WeilError::MethodArgumentDeserializationError(me), 1);
+            weilsdk::CountedRuntime::setResult(weilsdk::WeilError::MethodArgumentDeserializationError(me), 1);
             return;
         }
         
         get_score_args args;
         args = j.get<get_score_args>();
         
-        std::string stateString = p.first;
     
-        nlohmann::ordered_json j1 = nlohmann::ordered_json::parse(stateString);
+        nlohmann::ordered_json j1 = weilsdk::CountedJson::parse<nlohmann::ordered_json>(p.state);
         from_json(j1, credit_score_instance);
         
         double result = credit_score_instance.get_score(args.account_age_months, args.monthly_income_avg, args.income_frequency, args.monthly_rent, args.monthly_utilities, args.missed_payments_count);
-        nlohmann::ordered_json j_result = result;
-        weilsdk::Runtime::setResult(j_result.dump(), 0);
+        weilsdk::scratch_json j_result = result;
+        weilsdk::CountedRuntime::setResult(weilsdk::CountedJson::dump(j_result), 0);
     }
 
     void tools() {
+    weilsdk::ArenaScope arena_scope;
+    collections::InvocationScope invocation_scope;
+    weilsdk::StatsScope stats_scope("tools");
     // 1. Recover state
-    std::string stateString = weilsdk::Runtime::state();
-    nlohmann::ordered_json j = nlohmann::ordered_json::parse(stateString);
+    std::string stateString = weilsdk::CountedRuntime::state();
+    nlohmann::ordered_json j = weilsdk::CountedJson::parse<nlohmann::ordered_json>(stateString);
     from_json(j, credit_score_instance);
 
     // 2. Get tools JSON string
@@ -158,7 +173,13 @@ extern "C" {
 
     // 3. Wrap as a JSON string to satisfy the host's type expectation
     nlohmann::ordered_json result_wrapper = tools_json_raw;
-    weilsdk::Runtime::setResult(result_wrapper.dump(), 0);
+    weilsdk::CountedRuntime::setResult(weilsdk::CountedJson::dump(result_wrapper), 0);
 }
 
+    // Per-method host-call, byte and JSON counters collected since the
+    // instance was created
+    void __stats() {
+        weilsdk::CountedRuntime::setResult(weilsdk::Stats::report(), 0);
+    }
+
 } // extern "C"
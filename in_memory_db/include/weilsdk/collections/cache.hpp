@@ -0,0 +1,72 @@
+/**
+ * @file cache.hpp
+ * @brief Per-invocation read-through cache of decoded collection values
+ * @details Collections that opt in keep every value they read or write here,
+ *          keyed by its state tree key, so repeated lookups of the same key
+ *          within one invocation do not cross the host boundary again. A miss
+ *          is cached as well. The cache is emptied at both ends of every
+ *          invocation by collections::InvocationScope, since other
+ *          transactions may have changed the state in between.
+ */
+
+#ifndef CACHE_HPP
+#define CACHE_HPP
+
+#include <any>
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+namespace collections {
+  /**
+   * @brief Process-wide cache shared by all opted-in collections
+   * @details Entries hold a std::optional<V>; std::nullopt records that the
+   *          key is known to be absent from the state.
+   */
+  class ReadCache {
+  private:
+    struct Data {
+      std::unordered_map<std::string, std::any> entries;
+    };
+
+    static Data &data() {
+      static Data d;
+      return d;
+    }
+
+  public:
+    /**
+     * @brief Looks up a cached value
+     * @tparam V The decoded value type
+     * @param key The state tree key
+     * @return nullptr if the key is not cached; otherwise the cached value,
+     *         which is std::nullopt if the key is known to be absent
+     */
+    template <typename V>
+    static const std::optional<V> *find(const std::string &key) {
+      auto &entries = data().entries;
+      auto it = entries.find(key);
+      if (it == entries.end()) {
+        return nullptr;
+      }
+      return std::any_cast<std::optional<V>>(&it->second);
+    }
+
+    /**
+     * @brief Records the current value of a key
+     * @param key The state tree key
+     * @param value The decoded value, or std::nullopt if the key is absent
+     */
+    template <typename V>
+    static void put(const std::string &key, std::optional<V> value) {
+      data().entries[key] = std::move(value);
+    }
+
+    /**
+     * @brief Drops every cached entry
+     */
+    static void clear() { data().entries.clear(); }
+  };
+} // namespace collections
+
+#endif // CACHE_HPP
@@ -0,0 +1,121 @@
+/**
+ * @file codec.hpp
+ * @brief Value codecs for the persistent collections
+ * @details A codec turns a collection value into the byte string handed to
+ *          the host and back. WeilMap and WeilVec take one as a template
+ *          parameter; JsonCodec is the default and matches what the
+ *          collections have always stored. A codec is a type with
+ *
+ *              static std::string encode(const T &value);
+ *              static T decode(const std::string &bytes);
+ *
+ *          Encoded values must be valid UTF-8 text: the host hands bulk
+ *          reads back as JSON (see text.hpp).
+ *
+ *          Changing the codec of a collection changes its storage format, so
+ *          it must be chosen before any data is written.
+ */
+
+#ifndef CODEC_HPP
+#define CODEC_HPP
+
+#include "text.hpp"
+#include "external/nlohmann.hpp"
+#include "weilsdk/stats.h"
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+namespace collections {
+  /**
+   * @brief Stores values as JSON text
+   * @tparam T Any type with nlohmann::json conversions
+   */
+  template <typename T>
+  struct JsonCodec {
+    static std::string encode(const T &value) {
+      nlohmann::json j = value;
+      weilsdk::Stats::onDump();
+      return j.dump();
+    }
+
+    static T decode(const std::string &bytes) {
+      nlohmann::json j = nlohmann::json::parse(bytes);
+      weilsdk::Stats::onParse();
+      return j.get<T>();
+    }
+  };
+
+  /**
+   * @brief Stores strings as-is
+   * @details For values that are already serialized (e.g. a JSON record),
+   *          which JsonCodec would escape into a JSON string and parse twice.
+   *          The strings must be valid UTF-8.
+   */
+  struct RawCodec {
+    static std::string encode(const std::string &value) { return value; }
+    static std::string decode(const std::string &bytes) { return bytes; }
+  };
+
+  /**
+   * @brief Stores integers as the shortest lowercase hex, '-' first for
+   *        negative values
+   * @details Positions and counters are mostly small, so this is one or two
+   *          bytes where JSON would take as many digits in decimal.
+   * @tparam T An integral type
+   */
+  template <typename T>
+  struct HexIntCodec {
+    static_assert(std::is_integral<T>::value, "HexIntCodec requires an integral type");
+    using U = typename std::make_unsigned<T>::type;
+
+    static std::string encode(const T &value) {
+      if constexpr (std::is_signed<T>::value) {
+        if (value < 0) {
+          return "-" + text::to_short_hex(static_cast<U>(U(0) - static_cast<U>(value)));
+        }
+      }
+      return text::to_short_hex(static_cast<U>(value));
+    }
+
+    static T decode(const std::string &bytes) {
+      if (!bytes.empty() && bytes[0] == '-') {
+        return static_cast<T>(U(0) - text::from_short_hex<U>(bytes.substr(1)));
+      }
+      return static_cast<T>(text::from_short_hex<U>(bytes));
+    }
+  };
+
+  /**
+   * @brief Stores values as base64-encoded MessagePack
+   * @details Same type requirements as JsonCodec; each value is serialized
+   *          once. The format is picked per collection, not per value: for
+   *          structs with short member names and numeric fields (table
+   *          metadata, jobs, B+tree pages) the base64 comes out smaller than
+   *          the JSON text despite its third of overhead, e.g. 16 bytes
+   *          against 19 for a fresh table's metadata and 696 against 781
+   *          for a 32-key page. Values that are mostly long strings are
+   *          smaller as JsonCodec or RawCodec. Strings need not be valid
+   *          UTF-8, since MessagePack carries them as bytes.
+   * @tparam T Any type with nlohmann::json conversions
+   */
+  template <typename T>
+  struct BinaryCodec {
+    static std::string encode(const T &value) {
+      nlohmann::json j = value;
+      std::string bytes;
+      nlohmann::json::to_msgpack(j, bytes);
+      weilsdk::Stats::onDump();
+      return text::to_base64(bytes);
+    }
+
+    static T decode(const std::string &bytes) {
+      nlohmann::json j = nlohmann::json::from_msgpack(text::from_base64(bytes));
+      weilsdk::Stats::onParse();
+      return j.get<T>();
+    }
+  };
+} // namespace collections
+
+#endif // CODEC_HPP
@@ -0,0 +1,238 @@
+/**
+ * @file key_encoder.hpp
+ * @brief Order-preserving encoding of collection keys into state tree keys
+ * @details Keys are encoded into a KeyBuffer, which keeps typical keys in an
+ *          inline array so building a state tree key does no heap work until
+ *          the final std::string is handed to the host. Encodings preserve
+ *          order: comparing two encoded keys bytewise gives the same result
+ *          as comparing the keys, so ordered and prefix scans over the host
+ *          key space visit keys in their natural order. Encoded keys are
+ *          valid UTF-8 as long as string keys are, so they survive the
+ *          host's JSON bulk reads (see text.hpp).
+ *
+ *          - std::string: the bytes themselves. Inside a tuple, 0x00 is
+ *            escaped as 0x00 0x01 and the string is terminated by 0x00 0x00,
+ *            so no component is a prefix of another and the end of a string
+ *            never depends on the component that follows it.
+ *          - integers: fixed-width lowercase hex, 2 * sizeof(K) digits,
+ *            sign bit flipped for signed types.
+ *          - bool: one byte.
+ *          - std::pair / std::tuple: the components in order, each encoded
+ *            as a tuple component.
+ *          - anything else: its JSON text, as the collections always did.
+ */
+
+#ifndef KEY_ENCODER_HPP
+#define KEY_ENCODER_HPP
+
+#include "text.hpp"
+#include "external/nlohmann.hpp"
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace collections {
+  /**
+   * @brief Append-only byte buffer with inline storage for short keys
+   */
+  class KeyBuffer {
+  private:
+    static constexpr size_t kInline = 64; ///< Bytes stored without allocating
+
+    char inline_buf[kInline]; ///< Inline storage
+    size_t len;               ///< Bytes used
+    std::string spill;        ///< Storage once the key outgrows inline_buf
+
+  public:
+    KeyBuffer() : len(0) {}
+
+    KeyBuffer(const KeyBuffer &) = delete;
+    KeyBuffer &operator=(const KeyBuffer &) = delete;
+
+    /**
+     * @brief Appends raw bytes
+     */
+    void append(const char *bytes, size_t n) {
+      if (spill.empty() && len + n <= kInline) {
+        std::memcpy(inline_buf + len, bytes, n);
+      } else {
+        if (spill.empty()) {
+          spill.assign(inline_buf, len);
+        }
+        spill.append(bytes, n);
+      }
+      len += n;
+    }
+
+    /**
+     * @brief Appends a single byte
+     */
+    void push_back(char c) { append(&c, 1); }
+
+    /**
+     * @brief Appends the decimal digits of an unsigned number
+     */
+    void append_decimal(uint64_t value) {
+      char digits[20];
+      size_t n = 0;
+      do {
+        digits[sizeof(digits) - ++n] = static_cast<char>('0' + value % 10);
+        value /= 10;
+      } while (value != 0);
+      append(digits + sizeof(digits) - n, n);
+    }
+
+    const char *data() const { return spill.empty() ? inline_buf : spill.data(); }
+    size_t size() const { return len; }
+
+    /**
+     * @brief Copies the encoded key out as a std::string
+     */
+    std::string str() const { return std::string(data(), len); }
+  };
+
+  /**
+   * @brief Encoder for keys of type K
+   * @details The primary template is the JSON fallback. Specializations
+   *          provide the order-preserving encodings.
+   *
+   *          encode(out, key, nested) appends the key; `nested` is true when
+   *          the key is a tuple component and must be self-delimiting.
+   *          decode(p, end, nested) reads one key starting at p and advances
+   *          p past it.
+   */
+  template <typename K, typename Enable = void>
+  struct KeyEncoder;
+
+  template <>
+  struct KeyEncoder<std::string> {
+    static void encode(KeyBuffer &out, const std::string &key, bool nested) {
+      if (!nested) {
+        out.append(key.data(), key.size());
+        return;
+      }
+      size_t start = 0;
+      for (size_t i = 0; i < key.size(); ++i) {
+        if (key[i] == '\0') {
+          out.append(key.data() + start, i - start + 1);
+          out.push_back('\x01');
+          start = i + 1;
+        }
+      }
+      out.append(key.data() + start, key.size() - start);
+      out.append("\0\0", 2);
+    }
+
+    static std::string decode(const char *&p, const char *end, bool nested) {
+      if (!nested) {
+        std::string key(p, end);
+        p = end;
+        return key;
+      }
+      std::string key;
+      while (p < end) {
+        if (*p != '\0') {
+          key.push_back(*p++);
+          continue;
+        }
+        if (p + 1 == end) {
+          break;
+        }
+        if (p[1] == '\0') {
+          p += 2; // terminator
+          return key;
+        }
+        if (p[1] != '\x01') {
+          throw std::runtime_error("KeyEncoder: invalid escape in string component");
+        }
+        key.push_back('\0');
+        p += 2;
+      }
+      throw std::runtime_error("KeyEncoder: unterminated string component");
+    }
+  };
+
+  template <>
+  struct KeyEncoder<bool> {
+    static void encode(KeyBuffer &out, bool key, bool) { out.push_back(key ? '\x01' : '\x00'); }
+
+    static bool decode(const char *&p, const char *end, bool) {
+      if (p >= end) {
+        throw std::runtime_error("KeyEncoder: truncated bool");
+      }
+      return *p++ != '\0';
+    }
+  };
+
+  template <typename K>
+  struct KeyEncoder<K, typename std::enable_if<std::is_integral<K>::value &&
+                                               !std::is_same<K, bool>::value>::type> {
+    using U = typename std::make_unsigned<K>::type;
+
+    // Flipping the sign bit maps signed order onto unsigned order
+    static constexpr U kSignFlip = std::is_signed<K>::value
+                                       ? static_cast<U>(U(1) << (sizeof(K) * 8 - 1))
+                                       : U(0);
+
+    static constexpr size_t kDigits = 2 * sizeof(K);
+
+    static void encode(KeyBuffer &out, const K &key, bool) {
+      char digits[kDigits];
+      text::to_hex(static_cast<U>(static_cast<U>(key) ^ kSignFlip), digits);
+      out.append(digits, kDigits);
+    }
+
+    static K decode(const char *&p, const char *end, bool) {
+      if (end - p < static_cast<std::ptrdiff_t>(kDigits)) {
+        throw std::runtime_error("KeyEncoder: truncated integer");
+      }
+      U u = text::from_hex<U>(p);
+      p += kDigits;
+      return static_cast<K>(static_cast<U>(u ^ kSignFlip));
+    }
+  };
+
+  template <typename A, typename B>
+  struct KeyEncoder<std::pair<A, B>> {
+    static void encode(KeyBuffer &out, const std::pair<A, B> &key, bool) {
+      KeyEncoder<A>::encode(out, key.first, true);
+      KeyEncoder<B>::encode(out, key.second, true);
+    }
+
+    static std::pair<A, B> decode(const char *&p, const char *end, bool) {
+      A a = KeyEncoder<A>::decode(p, end, true);
+      B b = KeyEncoder<B>::decode(p, end, true);
+      return {std::move(a), std::move(b)};
+    }
+  };
+
+  template <typename... Ts>
+  struct KeyEncoder<std::tuple<Ts...>> {
+    static void encode(KeyBuffer &out, const std::tuple<Ts...> &key, bool) {
+      std::apply([&out](const Ts &...parts) { (KeyEncoder<Ts>::encode(out, parts, true), ...); }, key);
+    }
+
+    static std::tuple<Ts...> decode(const char *&p, const char *end, bool) {
+      // Braced initialization evaluates the components left to right
+      return std::tuple<Ts...>{KeyEncoder<Ts>::decode(p, end, true)...};
+    }
+  };
+
+  // JSON fallback for every other key type
+  template <typename K, typename Enable>
+  struct KeyEncoder {
+    static void encode(KeyBuffer &out, const K &key, bool nested) {
+      KeyEncoder<std::string>::encode(out, nlohmann::json(key).dump(), nested);
+    }
+
+    static K decode(const char *&p, const char *end, bool nested) {
+      return nlohmann::json::parse(KeyEncoder<std::string>::decode(p, end, nested)).template get<K>();
+    }
+  };
+} // namespace collections
+
+#endif // KEY_ENCODER_HPP
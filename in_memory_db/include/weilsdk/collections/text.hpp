@@ -0,0 +1,163 @@
+/**
+ * @file text.hpp
+ * @brief Text-safe encodings for binary collection data
+ * @details The host moves keys and values as text: bulk reads come back as a
+ *          JSON array of [key, value] pairs, which can only carry valid UTF-8.
+ *          Codecs and key encodings that would otherwise produce arbitrary
+ *          bytes use these helpers instead: fixed-width lowercase hex for
+ *          integers in keys, which sorts like the number, the shortest hex
+ *          for integers in values, and base64 for opaque byte strings.
+ */
+
+#ifndef TEXT_HPP
+#define TEXT_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+namespace collections {
+  namespace text {
+    /**
+     * @brief Writes an unsigned integer as 2 * sizeof(U) lowercase hex digits
+     * @param out Destination with room for 2 * sizeof(U) characters
+     */
+    template <typename U>
+    void to_hex(U value, char *out) {
+      static_assert(std::is_unsigned<U>::value, "to_hex requires an unsigned type");
+      static const char kDigits[] = "0123456789abcdef";
+      for (size_t i = 2 * sizeof(U); i-- > 0;) {
+        out[i] = kDigits[value & 0xf];
+        value = static_cast<U>(value >> 4);
+      }
+    }
+
+    /**
+     * @brief Reads 2 * sizeof(U) hex digits written by to_hex()
+     * @throws std::runtime_error on a character that is not a hex digit
+     */
+    template <typename U>
+    U from_hex(const char *in) {
+      static_assert(std::is_unsigned<U>::value, "from_hex requires an unsigned type");
+      U value = 0;
+      for (size_t i = 0; i < 2 * sizeof(U); ++i) {
+        char c = in[i];
+        unsigned digit;
+        if (c >= '0' && c <= '9') {
+          digit = static_cast<unsigned>(c - '0');
+        } else if (c >= 'a' && c <= 'f') {
+          digit = static_cast<unsigned>(c - 'a' + 10);
+        } else {
+          throw std::runtime_error("text::from_hex: invalid hex digit");
+        }
+        value = static_cast<U>((value << 4) | digit);
+      }
+      return value;
+    }
+
+    /**
+     * @brief Writes an unsigned integer as lowercase hex without leading
+     *        zeros ("0" for zero)
+     */
+    template <typename U>
+    std::string to_short_hex(U value) {
+      static_assert(std::is_unsigned<U>::value, "to_short_hex requires an unsigned type");
+      char digits[2 * sizeof(U)];
+      to_hex(value, digits);
+      size_t first = 0;
+      while (first + 1 < sizeof(digits) && digits[first] == '0') {
+        ++first;
+      }
+      return std::string(digits + first, sizeof(digits) - first);
+    }
+
+    /**
+     * @brief Reads hex written by to_short_hex()
+     * @throws std::runtime_error if `in` is empty, too long for U or not hex
+     */
+    template <typename U>
+    U from_short_hex(const std::string &in) {
+      static_assert(std::is_unsigned<U>::value, "from_short_hex requires an unsigned type");
+      if (in.empty() || in.size() > 2 * sizeof(U)) {
+        throw std::runtime_error("text::from_short_hex: expected 1 to " + std::to_string(2 * sizeof(U)) +
+                                 " hex digits, got " + std::to_string(in.size()));
+      }
+      std::string padded(2 * sizeof(U) - in.size(), '0');
+      padded += in;
+      return from_hex<U>(padded.data());
+    }
+
+    /**
+     * @brief Encodes bytes as base64 (RFC 4648, with padding)
+     */
+    inline std::string to_base64(const std::string &bytes) {
+      static const char kAlphabet[] =
+          "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+      std::string out;
+      out.reserve((bytes.size() + 2) / 3 * 4);
+      size_t i = 0;
+      for (; i + 3 <= bytes.size(); i += 3) {
+        uint32_t n = (static_cast<uint8_t>(bytes[i]) << 16) |
+                     (static_cast<uint8_t>(bytes[i + 1]) << 8) | static_cast<uint8_t>(bytes[i + 2]);
+        out.push_back(kAlphabet[(n >> 18) & 0x3f]);
+        out.push_back(kAlphabet[(n >> 12) & 0x3f]);
+        out.push_back(kAlphabet[(n >> 6) & 0x3f]);
+        out.push_back(kAlphabet[n & 0x3f]);
+      }
+      if (i < bytes.size()) {
+        uint32_t n = static_cast<uint8_t>(bytes[i]) << 16;
+        if (i + 1 < bytes.size()) {
+          n |= static_cast<uint8_t>(bytes[i + 1]) << 8;
+        }
+        out.push_back(kAlphabet[(n >> 18) & 0x3f]);
+        out.push_back(kAlphabet[(n >> 12) & 0x3f]);
+        out.push_back(i + 1 < bytes.size() ? kAlphabet[(n >> 6) & 0x3f] : '=');
+        out.push_back('=');
+      }
+      return out;
+    }
+
+    /**
+     * @brief Decodes base64 written by to_base64()
+     * @throws std::runtime_error on malformed input
+     */
+    inline std::string from_base64(const std::string &text) {
+      auto value = [](char c) -> int {
+        if (c >= 'A' && c <= 'Z') return c - 'A';
+        if (c >= 'a' && c <= 'z') return c - 'a' + 26;
+        if (c >= '0' && c <= '9') return c - '0' + 52;
+        if (c == '+') return 62;
+        if (c == '/') return 63;
+        return -1;
+      };
+      if (text.size() % 4 != 0) {
+        throw std::runtime_error("text::from_base64: length is not a multiple of 4");
+      }
+      std::string out;
+      out.reserve(text.size() / 4 * 3);
+      for (size_t i = 0; i < text.size(); i += 4) {
+        size_t pad = 0;
+        uint32_t n = 0;
+        for (size_t j = 0; j < 4; ++j) {
+          char c = text[i + j];
+          int v = value(c);
+          if (c == '=' && i + 4 == text.size() && j >= 2) {
+            pad++;
+            v = 0;
+          } else if (v < 0 || pad) {
+            throw std::runtime_error("text::from_base64: invalid character");
+          }
+          n = (n << 6) | static_cast<uint32_t>(v);
+        }
+        out.push_back(static_cast<char>((n >> 16) & 0xff));
+        if (pad < 2) out.push_back(static_cast<char>((n >> 8) & 0xff));
+        if (pad < 1) out.push_back(static_cast<char>(n & 0xff));
+      }
+      return out;
+    }
+  } // namespace text
+} // namespace collections
+
+#endif // TEXT_HPP
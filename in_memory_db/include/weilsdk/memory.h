@@ -2,6 +2,7 @@
 #define MEMORY_H
 
 #include "external/nlohmann.hpp"
+#include "weilsdk/stats.h"
 #include <memory>
 #include <optional>
 #include <string>
@@ -18,22 +19,135 @@ class Memory {
         static std::pair<int, std::string> deleteCollection(std::string key);
         static std::pair<int, std::string> readCollection(std::string key);
 
-        // Unimplemented
-        /*
+        // Batched readCollection/writeCollection/deleteCollection. Reads come
+        // back in key order with the same (status, value) shape as
+        // readCollection; deletes return nothing, missing keys are skipped. Hosts
+        // that serve a batch in one crossing define WEILSDK_BATCH_MEMORY;
+        // elsewhere these fall back to one call per key.
+        static std::vector<std::pair<int, std::string>>
+        readCollections(const std::vector<std::string> &keys);
+        static void
+        writeCollections(const std::vector<std::pair<std::string, std::string>> &entries);
+        static void
+        deleteCollections(const std::vector<std::string> &keys);
+
+        // Reads every entry whose key starts with `prefix` in one host call
+        // and decodes the buffer as T. The host returns the entries as a JSON
+        // array of [key, value] pairs, keys in full, so keys and values must
+        // be text; the collections' codecs and key encoding guarantee it.
         template <typename T>
-        static std::optional<T> readPrefixForTrie(std::string_view prefix) {
-            try {
-                std::string buffer = Memory::readBulkCollection(prefix);
-                return nlohmann::json::parse(buffer).get<T>();
-            } catch (const std::runtime_error& e) {
-                if
-        (std::string(e.what()).find("EntriesNotFoundInCollectionForKeysWithPrefix") !=
-        std::string::npos) { return std::nullopt;
-                }
-                throw e;
+        static std::optional<T> readPrefixForTrie(const std::string &prefix) {
+            std::pair<int, std::string> res = Memory::readBulkCollection(prefix);
+            Stats::onBulkRead(prefix.size(), res.first ? 0 : res.second.size());
+            if (res.first) {
+                // EntriesNotFoundInCollectionForKeysWithPrefix
+                return std::nullopt;
+            }
+            return nlohmann::json::parse(res.second).get<T>();
+        }
+    };
+
+#ifndef WEILSDK_BATCH_MEMORY
+    inline std::vector<std::pair<int, std::string>>
+    Memory::readCollections(const std::vector<std::string> &keys) {
+        std::vector<std::pair<int, std::string>> out;
+        out.reserve(keys.size());
+        for (const std::string &key : keys) {
+            out.push_back(Memory::readCollection(key));
+        }
+        return out;
+    }
+
+    inline void
+    Memory::writeCollections(const std::vector<std::pair<std::string, std::string>> &entries) {
+        for (const auto &entry : entries) {
+            Memory::writeCollection(entry.first, entry.second);
+        }
+    }
+
+    inline void
+    Memory::deleteCollections(const std::vector<std::string> &keys) {
+        for (const std::string &key : keys) {
+            Memory::deleteCollection(key);
+        }
+    }
+#endif
+
+    // Memory as the SDK collections call it: each call forwards to the host
+    // binding and reports the crossing to Stats. The bindings live in the
+    // prebuilt library (natively, in the emulator) and count nothing, so
+    // counting here is what makes `__stats` work on-chain.
+    class CountedMemory {
+    public:
+        static std::pair<int, std::string> readCollection(const std::string &key) {
+            std::pair<int, std::string> res = Memory::readCollection(key);
+            Stats::onRead(key.size(), res.first ? 0 : res.second.size());
+            return res;
+        }
+
+        static void writeCollection(const std::string &key, const std::string &val) {
+            Stats::onWrite(key.size(), val.size());
+            Memory::writeCollection(key, val);
+        }
+
+        static std::pair<int, std::string> deleteCollection(const std::string &key) {
+            std::pair<int, std::string> res = Memory::deleteCollection(key);
+            Stats::onDelete(key.size(), res.first ? 0 : res.second.size());
+            return res;
+        }
+
+        static std::vector<std::pair<int, std::string>>
+        readCollections(const std::vector<std::string> &keys) {
+#ifdef WEILSDK_BATCH_MEMORY
+            std::vector<std::pair<int, std::string>> out = Memory::readCollections(keys);
+            size_t key_bytes = 0, val_bytes = 0;
+            for (size_t i = 0; i < keys.size(); ++i) {
+                key_bytes += keys[i].size();
+                if (!out[i].first) val_bytes += out[i].second.size();
+            }
+            Stats::onReadBatch(keys.size(), key_bytes, val_bytes);
+            return out;
+#else
+            std::vector<std::pair<int, std::string>> out;
+            out.reserve(keys.size());
+            for (const std::string &key : keys) {
+                out.push_back(readCollection(key));
+            }
+            return out;
+#endif
+        }
+
+        static void
+        writeCollections(const std::vector<std::pair<std::string, std::string>> &entries) {
+#ifdef WEILSDK_BATCH_MEMORY
+            size_t bytes = 0;
+            for (const auto &entry : entries) {
+                bytes += entry.first.size() + entry.second.size();
+            }
+            Stats::onWriteBatch(entries.size(), bytes);
+            Memory::writeCollections(entries);
+#else
+            for (const auto &entry : entries) {
+                writeCollection(entry.first, entry.second);
+            }
+#endif
+        }
+
+        static void
+        deleteCollections(const std::vector<std::string> &keys) {
+#ifdef WEILSDK_BATCH_MEMORY
+            size_t key_bytes = 0;
+            for (const std::string &key : keys) {
+                key_bytes += key.size();
+            }
+            Stats::onDeleteBatch(keys.size(), key_bytes);
+            Memory::deleteCollections(keys);
+#else
+            for (const std::string &key : keys) {
+                deleteCollection(key);
             }
+#endif
         }
-        */
     };
 } // namespace weilsdk
 #endif
\ No newline at end of file
@@ -5,6 +5,8 @@
 #include <memory>
 #include <optional>
 #include <string>
+#include <string_view>
+#include <utility>
 #include <variant>
 #include <vector>
 #include "error.h"
@@ -19,6 +21,14 @@ namespace weilsdk {
     std::string args;
   };
 
+  // Non-owning views of the invocation's state and args. The buffers belong
+  // to the runtime and stay valid until the next stateAndArgsView() call,
+  // so an exported method can parse them without copying
+  struct StateArgsView {
+    std::string_view state;
+    std::string_view args;
+  };
+
   struct StateResultValue{
     std::string state;
     std::string value;
@@ -65,18 +75,18 @@ namespace weilsdk {
 
     WeilValue(): state("null"), ok_val(""){};
     WeilValue(std::string _state, std::string _ok_val){
-        this->state = _state;
-        this->ok_val = _ok_val;
+        this->state = std::move(_state);
+        this->ok_val = std::move(_ok_val);
     }
 
     void new_with_ok_value(std::string _val){
       this->state = "null";
-      this->ok_val = _val;
+      this->ok_val = std::move(_val);
     }
 
     void new_with_state_and_ok_value(std::string _state, std::string _val){
-      this->state = _state;
-      this->ok_val = _val;
+      this->state = std::move(_state);
+      this->ok_val = std::move(_val);
     }
 
     bool has_state(){
@@ -119,6 +129,7 @@ namespace weilsdk {
       static std::string state();
       static std::string args();
       static std::pair<std::string,std::string> stateAndArgs();
+      static StateArgsView stateAndArgsView();
       static std::string sender();
       static std::string ledgerContractId();
       static uint64_t blockHeight();
@@ -140,6 +151,16 @@ namespace weilsdk {
       static void debugLog(std::string log);
   };
 
+#ifndef WEILSDK_RUNTIME_VIEWS
+  // Hosts without native views: keep the strings stateAndArgs() hands back,
+  // moved rather than copied, and lend them out
+  inline StateArgsView Runtime::stateAndArgsView() {
+    static std::pair<std::string, std::string> buffers;
+    buffers = stateAndArgs();
+    return {buffers.first, buffers.second};
+  }
+#endif
+
 } // namespace weilsdk
 
 #endif
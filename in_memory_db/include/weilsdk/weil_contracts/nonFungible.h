@@ -3,9 +3,9 @@
 
 #include "external/nlohmann.hpp"
 #include "weilsdk/collections/map.hpp"
+#include "weilsdk/collections/set.hpp"
 #include "weilsdk/ledger.h"
 #include "weilsdk/runtime.h"
-#include <set>
 #include <variant>
 #include <string>
 #include <vector>
@@ -50,11 +50,11 @@ namespace weilcontracts{
         m.setStateId(j["state_id"]);
     }
 
-    inline void to_json(nlohmann::json& j, const collections::WeilMap<Address, std::set<TokenId>>& m) {
+    inline void to_json(nlohmann::json& j, const collections::WeilMultiMap<Address, TokenId>& m) {
         j = nlohmann::json::object();
         j["state_id"] = m.getStateId();
     }
-    inline void from_json(const nlohmann::json& j, collections::WeilMap<Address, std::set<TokenId>>& m) {
+    inline void from_json(const nlohmann::json& j, collections::WeilMultiMap<Address, TokenId>& m) {
         m.setStateId(j["state_id"]);
     }
 
@@ -81,7 +81,9 @@ namespace weilcontracts{
         Address creator;
         collections::WeilMap<TokenId, Token> tokens;
         collections::WeilMap<TokenId, Address> owners;
-        collections::WeilMap<Address, std::set<TokenId>> owned;
+        // One host key per (owner, token), so mint and transfer cost O(1)
+        // host calls however many tokens the owner holds
+        collections::WeilMultiMap<Address, TokenId> owned;
         collections::WeilMap<std::string, Address> allowances;
 
         std::pair<bool, std::string> doTransfer(std::string tokenId, Address fromAddr, Address toAddr);
@@ -106,12 +108,12 @@ namespace weilcontracts{
 
         collections::WeilMap<TokenId, Token> getTokens() const {return tokens;};
         collections::WeilMap<TokenId, Address> getOwners() const {return owners;};
-        collections::WeilMap<Address, std::set<TokenId>> getOwned() const {return owned;};
+        collections::WeilMultiMap<Address, TokenId> getOwned() const {return owned;};
         collections::WeilMap<std::string, Address> getAllowances() const {return allowances;};
 
         void setTokens(collections::WeilMap<TokenId, Token> _tokens);
         void setOwners(collections::WeilMap<TokenId, Address> _owners);
-        void setOwned( collections::WeilMap<Address, std::set<TokenId>> _owned);
+        void setOwned( collections::WeilMultiMap<Address, TokenId> _owned);
         void setAllowances(collections::WeilMap<std::string, Address> _allowances);
     };
 
@@ -122,7 +124,7 @@ namespace weilcontracts{
         nlohmann::json j4;
         collections::WeilMap<TokenId, Token> token_map = tkn.getTokens();
         collections::WeilMap<TokenId, Address> owners_map = tkn.getOwners();
-        collections::WeilMap<Address, std::set<TokenId>> owned_map = tkn.getOwned();
+        collections::WeilMultiMap<Address, TokenId> owned_map = tkn.getOwned();
         collections::WeilMap<std::string, Address> allowances_map = tkn.getAllowances();
 
         to_json(j1,token_map);
@@ -163,7 +165,7 @@ namespace weilcontracts{
 
         std::string str3 = j.at("owned");
         nlohmann::json j3 = nlohmann::json::parse(str3);
-        collections::WeilMap<Address, std::set<TokenId>> owned;
+        collections::WeilMultiMap<Address, TokenId> owned;
         from_json(j3,owned);
 
         std::string str4 = j.at("allowances");
@@ -0,0 +1,47 @@
+#!/usr/bin/env bash
+# Sweeps table sizes through the native runner and prints the simulated gas
+# of every method at each size, to show which ones grow with the table.
+#
+#   native/gas_report.sh <runner> [sizes...]
+#
+# <runner> is the native in_memory_db executable, built without Emscripten:
+#
+#   cmake -S . -B build-native && cmake --build build-native
+#   native/gas_report.sh build-native/in_memory_db
+#
+# Extra runner options such as --gas-limit or --cost can be passed through
+# GAS_OPTS.
+set -euo pipefail
+
+if (($# < 1)); then
+  echo "usage: $0 <runner> [sizes...]" >&2
+  exit 2
+fi
+
+runner=$1
+shift
+sizes=${*:-100 1000 2000 5000}
+
+for n in $sizes; do
+  script=$(mktemp)
+  {
+    echo 'create_table {"table_name":"t"}'
+    printf 'insert_records {"table":"t","records":['
+    for ((i = 0; i < n; i++)); do
+      ((i > 0)) && printf ','
+      printf '["k%d",[["name","n%d"],["v","%d"]]]' "$i" "$i" "$i"
+    done
+    echo ']}'
+    echo 'table_size {"table_name":"t"}'
+    echo 'get_all_fields {"table":"t","key":"k0"}'
+    echo 'insert {"table":"t","key":"extra","field":"name","value":"x"}'
+    echo 'remove_record {"table":"t","key":"k0"}'
+    echo 'select_records {"table":"t","where":"{\"prefix\":[\"name\",\"n1\"]}","fields":["v"],"limit":10}'
+    echo 'drop_table {"table_name":"t"}'
+    echo 'reclaim {"max_records":500}'
+  } >"$script"
+  echo "== $n records"
+  # shellcheck disable=SC2086
+  "$runner" --quiet --gas ${GAS_OPTS:-} "$script" 2>&1
+  rm -f "$script"
+done
@@ -0,0 +1,419 @@
+/**
+ * @file weil_host.cpp
+ * @brief Native implementation of the weilsdk host bindings
+ * @details Provides the symbols libweilsdk_static.a provides in the wasm build
+ *          so that unmodified contract sources link into a regular Linux
+ *          binary. Errors are serialized the way the node serializes its
+ *          WeilError enum: a single-key object naming the variant.
+ */
+
+#include "weil_host.h"
+
+#include "weilsdk/error.h"
+#include "weilsdk/ledger.h"
+#include "weilsdk/memory.h"
+#include "weilsdk/runtime.h"
+#include "external/nlohmann.hpp"
+
+#include <cstdlib>
+#include <iostream>
+
+namespace {
+
+  struct HostEnv {
+    std::map<std::string, std::string> key_space;
+    std::map<std::string, uint64_t> balances; // "symbol$addr" -> amount
+    std::string contract_state = "null";
+    std::string args = "{}";
+    std::string contract_id = "native_contract";
+    std::string sender = "native_sender";
+    std::string ledger_contract_id = "native_ledger";
+    uint64_t block_height = 0;
+    std::string block_timestamp = "1970-01-01T00:00:00Z";
+    bool debug_log = false;
+    weilsdk::host::CallHandler call_handler;
+    weilsdk::host::Outcome outcome;
+    weilsdk::host::CostModel cost;
+  };
+
+  HostEnv &env() {
+    static HostEnv instance;
+    return instance;
+  }
+
+  // Levels of a hex-nibble trie holding `keys` keys: enough nibbles to tell
+  // them apart, plus the root
+  uint64_t trie_depth(size_t keys) {
+    uint64_t depth = 1;
+    for (size_t reach = 1; reach < keys; reach *= 16) {
+      depth++;
+    }
+    return depth;
+  }
+
+  // Bills one host crossing against the invocation in flight. `trie_walks`
+  // is the number of storage keys the call looks up or updates
+  void charge(size_t trie_walks, size_t bytes_read, size_t bytes_written) {
+    HostEnv &e = env();
+    const weilsdk::host::CostModel &c = e.cost;
+    e.outcome.gas_used += c.per_call + c.per_byte_read * bytes_read +
+                          c.per_byte_written * bytes_written +
+                          c.per_trie_level * trie_depth(e.key_space.size()) * trie_walks;
+    if (c.gas_limit != 0 && e.outcome.gas_used > c.gas_limit) {
+      e.outcome.out_of_gas = true;
+    }
+  }
+
+  std::string variant(const std::string &name, nlohmann::json payload) {
+    nlohmann::json j;
+    j[name] = std::move(payload);
+    // Binary collection keys are not valid UTF-8; don't let an error message throw
+    return j.dump(-1, ' ', false, nlohmann::json::error_handler_t::replace);
+  }
+
+  nlohmann::json method_error(const weilsdk::MethodError &error) {
+    return {{"method_name", error.method_name}, {"err_msg", error.err_msg}};
+  }
+
+  nlohmann::json contract_call_error(const weilsdk::ContractCallError &error) {
+    return {{"contract_id", error.contract_id},
+            {"method_name", error.method_name},
+            {"err_msg", error.err_msg}};
+  }
+
+  std::string balance_key(const std::string &addr, const std::string &symbol) {
+    return symbol + "$" + addr;
+  }
+
+} // namespace
+
+namespace weilsdk {
+
+  // ---- Errors ----
+
+  MethodError::MethodError(std::string method_name, std::string err_msg)
+      : method_name(std::move(method_name)), err_msg(std::move(err_msg)) {}
+
+  ContractCallError::ContractCallError(std::string contract_id,
+                                       std::string method_name,
+                                       std::string err_msg)
+      : contract_id(std::move(contract_id)),
+        method_name(std::move(method_name)), err_msg(std::move(err_msg)) {}
+
+  WeilError::WeilError(const std::string &message)
+      : std::runtime_error(message) {}
+
+  std::string
+  WeilError::MethodArgumentDeserializationError(const MethodError &error) {
+    return variant("MethodArgumentDeserializationError", method_error(error));
+  }
+  std::string WeilError::FunctionReturnedWithError(const MethodError &error) {
+    return variant("FunctionReturnedWithError", method_error(error));
+  }
+  std::string
+  WeilError::TrapOccuredWhileWasmModuleExecution(const MethodError &error) {
+    return variant("TrapOccuredWhileWasmModuleExecution", method_error(error));
+  }
+  std::string WeilError::KeyNotFoundInCollection(const std::string &key) {
+    return variant("KeyNotFoundInCollection", key);
+  }
+  std::string
+  WeilError::NoValueReturnedFromDeletingCollectionItem(const std::string &key) {
+    return variant("NoValueReturnedFromDeletingCollectionItem", key);
+  }
+  std::string WeilError::EntriesNotFoundInCollectionForKeysWithPrefix(
+      const std::string &prefix) {
+    return variant("EntriesNotFoundInCollectionForKeysWithPrefix", prefix);
+  }
+  std::string
+  WeilError::ContractMethodExecutionError(const ContractCallError &error) {
+    return variant("ContractMethodExecutionError", contract_call_error(error));
+  }
+  std::string
+  WeilError::InvalidCrossContractCallError(const ContractCallError &error) {
+    return variant("InvalidCrossContractCallError", contract_call_error(error));
+  }
+  std::string WeilError::CrossContractCallResultDeserializationError(
+      const ContractCallError &error) {
+    return variant("CrossContractCallResultDeserializationError",
+                   contract_call_error(error));
+  }
+  std::string WeilError::LLMClusterError(const std::string &message) {
+    return variant("LLMClusterError", message);
+  }
+  std::string
+  WeilError::StreamingResponseDeserializationError(const std::string &message) {
+    return variant("StreamingResponseDeserializationError", message);
+  }
+  std::string WeilError::OutcallError(const std::string &message) {
+    return variant("OutcallError", message);
+  }
+  std::string WeilError::InvalidDataReceivedError(const std::string &message) {
+    return variant("InvalidDataReceivedError", message);
+  }
+  std::string WeilError::InvalidWasmModuleError(const std::string &message) {
+    return variant("InvalidWasmModuleError", message);
+  }
+
+  // ---- Runtime ----
+
+  uint8_t *Runtime::allocate(size_t len) {
+    return static_cast<uint8_t *>(std::malloc(len ? len : 1));
+  }
+
+  void Runtime::deallocate(size_t ptr, size_t len) {
+    (void)len;
+    std::free(reinterpret_cast<void *>(ptr));
+  }
+
+  std::string Runtime::contractId() { return env().contract_id; }
+
+  std::string Runtime::state() {
+    charge(0, env().contract_state.size(), 0);
+    return env().contract_state;
+  }
+
+  std::string Runtime::args() {
+    charge(0, env().args.size(), 0);
+    return env().args;
+  }
+
+  std::pair<std::string, std::string> Runtime::stateAndArgs() {
+    charge(0, env().contract_state.size() + env().args.size(), 0);
+    return {env().contract_state, env().args};
+  }
+
+  // Views straight into the emulator's buffers; nothing is copied
+  StateArgsView Runtime::stateAndArgsView() {
+    charge(0, env().contract_state.size() + env().args.size(), 0);
+    return {env().contract_state, env().args};
+  }
+
+  std::string Runtime::sender() { return env().sender; }
+  std::string Runtime::ledgerContractId() { return env().ledger_contract_id; }
+  uint64_t Runtime::blockHeight() { return env().block_height; }
+  std::string Runtime::blockTimestamp() { return env().block_timestamp; }
+
+  void Runtime::setState(std::string state) {
+    charge(0, 0, state.size());
+    env().contract_state = std::move(state);
+    env().outcome.state_written = true;
+  }
+
+  void Runtime::setResult(std::string result, int error) {
+    charge(0, 0, result.size());
+    env().outcome.result = std::move(result);
+    env().outcome.error = error;
+  }
+
+  void Runtime::setStateAndResult(
+      std::variant<weilsdk::WeilValue, std::string> result) {
+    HostEnv &e = env();
+    if (std::holds_alternative<std::string>(result)) {
+      std::string &err = std::get<std::string>(result);
+      charge(0, 0, err.size());
+      e.outcome.result = std::move(err);
+      e.outcome.error = 1;
+      return;
+    }
+    weilsdk::WeilValue &wv = std::get<weilsdk::WeilValue>(result);
+    charge(0, 0, (wv.has_state() ? wv.state.size() : 0) + wv.ok_val.size());
+    if (wv.has_state()) {
+      e.contract_state = std::move(wv.state);
+      e.outcome.state_written = true;
+    }
+    e.outcome.result = std::move(wv.ok_val);
+    e.outcome.error = 0;
+  }
+
+  std::pair<int, std::string>
+  Runtime::callContract(const std::string contractId,
+                        const std::string methodName,
+                        const std::string methodArgs) {
+    if (!env().call_handler) {
+      return {1, WeilError::InvalidCrossContractCallError(ContractCallError(
+                     contractId, methodName, "no call handler installed"))};
+    }
+    return env().call_handler(contractId, methodName, methodArgs);
+  }
+
+  std::pair<int, std::string>
+  Runtime::callXpodContract(const std::string contractId,
+                            const std::string methodName,
+                            const std::string methodArgs) {
+    return callContract(contractId, methodName, methodArgs);
+  }
+
+  void Runtime::debugLog(std::string log) {
+    if (env().debug_log) {
+      std::cerr << "[debug] " << log << std::endl;
+    }
+  }
+
+  // ---- Memory ----
+
+  std::pair<int, std::string>
+  Memory::readBulkCollection(const std::string prefix) {
+    const auto &ks = env().key_space;
+    nlohmann::json entries = nlohmann::json::array();
+    for (auto it = ks.lower_bound(prefix);
+         it != ks.end() && it->first.compare(0, prefix.size(), prefix) == 0;
+         ++it) {
+      entries.push_back({it->first, it->second});
+    }
+    if (entries.empty()) {
+      charge(1, 0, prefix.size());
+      return {1, WeilError::EntriesNotFoundInCollectionForKeysWithPrefix(prefix)};
+    }
+    std::string buffer = entries.dump();
+    charge(1, buffer.size(), prefix.size());
+    return {0, std::move(buffer)};
+  }
+
+  void Memory::writeCollection(std::string key, std::string val) {
+    charge(1, 0, key.size() + val.size());
+    env().key_space[std::move(key)] = std::move(val);
+  }
+
+  std::pair<int, std::string> Memory::deleteCollection(std::string key) {
+    auto &ks = env().key_space;
+    auto it = ks.find(key);
+    if (it == ks.end()) {
+      charge(1, 0, key.size());
+      return {1, WeilError::NoValueReturnedFromDeletingCollectionItem(key)};
+    }
+    std::string val = std::move(it->second);
+    ks.erase(it);
+    charge(1, val.size(), key.size());
+    return {0, std::move(val)};
+  }
+
+  std::pair<int, std::string> Memory::readCollection(std::string key) {
+    const auto &ks = env().key_space;
+    auto it = ks.find(key);
+    if (it == ks.end()) {
+      charge(1, 0, key.size());
+      return {1, WeilError::KeyNotFoundInCollection(key)};
+    }
+    charge(1, it->second.size(), key.size());
+    return {0, it->second};
+  }
+
+  std::vector<std::pair<int, std::string>>
+  Memory::readCollections(const std::vector<std::string> &keys) {
+    const auto &ks = env().key_space;
+    std::vector<std::pair<int, std::string>> out;
+    out.reserve(keys.size());
+    size_t key_bytes = 0, val_bytes = 0;
+    for (const std::string &key : keys) {
+      key_bytes += key.size();
+      auto it = ks.find(key);
+      if (it == ks.end()) {
+        out.emplace_back(1, WeilError::KeyNotFoundInCollection(key));
+      } else {
+        val_bytes += it->second.size();
+        out.emplace_back(0, it->second);
+      }
+    }
+    charge(keys.size(), val_bytes, key_bytes);
+    return out;
+  }
+
+  void Memory::writeCollections(
+      const std::vector<std::pair<std::string, std::string>> &entries) {
+    auto &ks = env().key_space;
+    size_t bytes = 0;
+    for (const auto &entry : entries) {
+      bytes += entry.first.size() + entry.second.size();
+      ks[entry.first] = entry.second;
+    }
+    charge(entries.size(), 0, bytes);
+  }
+
+  void Memory::deleteCollections(const std::vector<std::string> &keys) {
+    auto &ks = env().key_space;
+    size_t key_bytes = 0;
+    for (const std::string &key : keys) {
+      key_bytes += key.size();
+      ks.erase(key);
+    }
+    charge(keys.size(), 0, key_bytes);
+  }
+
+  // ---- Ledger ----
+
+  bool Ledger::balanceExistsFor(std::string addr, std::string symbol) {
+    return env().balances.count(balance_key(addr, symbol)) != 0;
+  }
+
+  uint64_t Ledger::balanceFor(std::string addr, std::string symbol) {
+    auto it = env().balances.find(balance_key(addr, symbol));
+    return it == env().balances.end() ? 0 : it->second;
+  }
+
+  std::pair<bool, std::string> Ledger::mint(std::string symbol,
+                                            std::string fromAddr,
+                                            uint64_t amount) {
+    env().balances[balance_key(fromAddr, symbol)] += amount;
+    return {true, ""};
+  }
+
+  std::pair<bool, std::string> Ledger::transfer(std::string symbol,
+                                                std::string fromAddr,
+                                                std::string toAddr,
+                                                uint64_t amount) {
+    uint64_t &from = env().balances[balance_key(fromAddr, symbol)];
+    if (from < amount) {
+      return {false, "insufficient balance"};
+    }
+    from -= amount;
+    env().balances[balance_key(toAddr, symbol)] += amount;
+    return {true, ""};
+  }
+
+  // ---- Host control ----
+
+  namespace host {
+
+    void Host::reset() {
+      HostEnv &e = env();
+      e.key_space.clear();
+      e.balances.clear();
+      e.contract_state = "null";
+      e.args = "{}";
+      e.outcome = Outcome{};
+    }
+
+    std::map<std::string, std::string> &Host::keySpace() {
+      return env().key_space;
+    }
+
+    std::string &Host::contractState() { return env().contract_state; }
+
+    void Host::setContractId(std::string id) { env().contract_id = std::move(id); }
+    void Host::setSender(std::string sender) { env().sender = std::move(sender); }
+    void Host::setLedgerContractId(std::string id) {
+      env().ledger_contract_id = std::move(id);
+    }
+    void Host::setBlockHeight(uint64_t height) { env().block_height = height; }
+    void Host::setBlockTimestamp(std::string timestamp) {
+      env().block_timestamp = std::move(timestamp);
+    }
+    void Host::setDebugLog(bool enabled) { env().debug_log = enabled; }
+    void Host::setCallHandler(CallHandler handler) {
+      env().call_handler = std::move(handler);
+    }
+    void Host::setCostModel(const CostModel &model) { env().cost = model; }
+    const CostModel &Host::costModel() { return env().cost; }
+
+    Outcome Host::invoke(void (*method)(), const std::string &args) {
+      HostEnv &e = env();
+      e.args = args;
+      e.outcome = Outcome{};
+      method();
+      return e.outcome;
+    }
+
+  } // namespace host
+
+} // namespace weilsdk
@@ -6,12 +6,16 @@
 #include <optional>
 #include <vector>
 #include <algorithm> // std::remove, std::find
+#include <map>
+#include <set>
 #include <utility>   // std::pair, std::tuple
 
 // Necessary includes for the implementation logic
 #include "weilsdk/runtime.h"
 #include "weilsdk/collections/map.hpp"
 #include "weilsdk/collections/vector.hpp"
+#include "weilsdk/collections/set.hpp"
+#include "weilsdk/collections/sorted_map.hpp"
 #include "external/nlohmann.hpp"
 
 // Define Option as an alias for std::optional
@@ -38,6 +42,123 @@ void from_json(const nlohmann::ordered_json& j, Option<T>& opt) {
 }
 
 
+// Per-table metadata, one host key per table. `id` is assigned from a
+// counter at creation and never reused; `flags` holds the kTable* bits;
+// `indexes` lists the fields with a secondary index and `building` those
+// of them still being backfilled by a job; `moves` counts the records
+// remove_record has relocated, see `move_log`.
+constexpr uint32_t kTableColumnar = 1;     // one host key per field, see `columns`
+constexpr uint32_t kTableOrdered = 2;      // keys also kept in `key_order`
+constexpr uint32_t kTableOrderPending = 4; // `key_order` still being backfilled
+
+struct TableMeta {
+    uint64_t id = 0;
+    uint64_t count = 0;
+    uint32_t flags = 0;
+    std::vector<std::string> indexes;
+    uint64_t moves = 0;
+    std::vector<std::string> building;
+};
+
+inline void to_json(nlohmann::json& j, const TableMeta& m) {
+    j = nlohmann::json{{"i", m.id}, {"c", m.count}, {"f", m.flags}};
+    if (!m.indexes.empty()) {
+        j["x"] = m.indexes;
+    }
+    if (m.moves != 0) {
+        j["m"] = m.moves;
+    }
+    if (!m.building.empty()) {
+        j["b"] = m.building;
+    }
+}
+
+inline void from_json(const nlohmann::json& j, TableMeta& m) {
+    j.at("i").get_to(m.id);
+    j.at("c").get_to(m.count);
+    j.at("f").get_to(m.flags);
+    if (j.contains("x")) {
+        j.at("x").get_to(m.indexes);
+    }
+    if (j.contains("m")) {
+        j.at("m").get_to(m.moves);
+    }
+    if (j.contains("b")) {
+        j.at("b").get_to(m.building);
+    }
+}
+
+// A bulk operation split over several calls by a work budget, see `jobs`.
+// Inserts keep their remaining records in `job_items` and `next` is the
+// first one not inserted yet; index backfills walk the table's positions
+// downwards and have done every position >= `next`.
+constexpr uint32_t kJobInsert = 0;
+constexpr uint32_t kJobIndex = 1;
+constexpr uint32_t kJobKeyIndex = 2;
+
+struct Job {
+    uint32_t kind = kJobInsert;
+    std::string table;
+    uint64_t table_id = 0;
+    uint64_t generation = 0;
+    std::string field;
+    uint64_t next = 0;
+    uint64_t total = 0;
+};
+
+inline void to_json(nlohmann::json& j, const Job& job) {
+    j = nlohmann::json{{"k", job.kind}, {"t", job.table}, {"i", job.table_id}, {"g", job.generation},
+                       {"f", job.field}, {"n", job.next}, {"c", job.total}};
+}
+
+inline void from_json(const nlohmann::json& j, Job& job) {
+    j.at("k").get_to(job.kind);
+    j.at("t").get_to(job.table);
+    j.at("i").get_to(job.table_id);
+    j.at("g").get_to(job.generation);
+    j.at("f").get_to(job.field);
+    j.at("n").get_to(job.next);
+    j.at("c").get_to(job.total);
+}
+
+// A parsed select_records() condition. Leaves compare a field's value with
+// `values` (one value, or the candidates of kIn); kAnd and kOr combine
+// `children`; kAll matches every record.
+struct Predicate {
+    enum Op { kAll, kEq, kNe, kLt, kGt, kPrefix, kIn, kAnd, kOr };
+    Op op = kAll;
+    std::string field;
+    std::vector<std::string> values;
+    std::vector<Predicate> children;
+};
+
+// The keys of a dropped or truncated table, waiting for reclaim().
+// `meta.count` is the number of records not yet deleted.
+struct RetiredSpace {
+    std::string table;
+    std::string space;
+    TableMeta meta;
+};
+
+inline void to_json(nlohmann::ordered_json& j, const RetiredSpace& r) {
+    j = nlohmann::ordered_json{{"t", r.table}, {"s", r.space}, {"c", r.meta.count}, {"m", r.meta.moves}, {"f", r.meta.flags}};
+    if (!r.meta.indexes.empty()) {
+        j["x"] = r.meta.indexes;
+    }
+}
+
+inline void from_json(const nlohmann::ordered_json& j, RetiredSpace& r) {
+    j.at("t").get_to(r.table);
+    j.at("s").get_to(r.space);
+    j.at("c").get_to(r.meta.count);
+    j.at("m").get_to(r.meta.moves);
+    j.at("f").get_to(r.meta.flags);
+    if (j.contains("x")) {
+        j.at("x").get_to(r.meta.indexes);
+    }
+}
+
+
 class in_memory_db_ContractState {
     private:
     /*
@@ -46,345 +167,2320 @@ class in_memory_db_ContractState {
      * -------------------------------------------------------------------------
      */
     
-    // 1. Metadata: Master list of table names
-    collections::WeilMap<std::string, std::vector<std::string>> metadata_registry =
-        collections::WeilMap<std::string, std::vector<std::string>>(static_cast<uint8_t>(1));
-
-    // 2. Data Store: key = "table|record_key" -> JSON string
-    collections::WeilMap<std::string, std::string> store =
-        collections::WeilMap<std::string, std::string>(static_cast<uint8_t>(2));
-
-    // 3. Counts: key = "table" -> count (uint64_t)
-    collections::WeilMap<std::string, uint64_t> table_counts =
-        collections::WeilMap<std::string, uint64_t>(static_cast<uint8_t>(3));
-
-    // 4. Index-to-Key: key = "table|index" -> "record_key"
-    collections::WeilMap<std::string, std::string> index_to_key =
-        collections::WeilMap<std::string, std::string>(static_cast<uint8_t>(4));
-
-    // 5. Key-to-Index: key = "table|record_key" -> index (uint64_t)
-    collections::WeilMap<std::string, uint64_t> key_to_index =
-        collections::WeilMap<std::string, uint64_t>(static_cast<uint8_t>(5));
+    // Values use the cheapest codec that fits: records are already JSON text
+    // and are stored raw, counters and positions as short hex integers.
+    // Per-record keys are (key space, ...) tuples; their encoding keeps each
+    // table's keys contiguous and positions in numeric order. A table's key
+    // space is its name, or "name|<generation>" once a table of that name
+    // has been dropped or truncated, so retiring a table's keys is O(1).
+    using RecordKey = std::pair<std::string, std::string>;
+    using IndexKey = std::pair<std::string, uint64_t>;
+    using FieldKey = std::tuple<std::string, std::string, std::string>;
+    using IndexedValue = std::tuple<std::string, std::string, std::string>; // (table, field, value)
+
+    // 1. Metadata: key = "table" -> TableMeta (id, record count, flags).
+    // Existence checks are one small read; the table list is a prefix scan.
+    collections::WeilMap<std::string, TableMeta, collections::BinaryCodec<TableMeta>> table_meta =
+        collections::WeilMap<std::string, TableMeta, collections::BinaryCodec<TableMeta>>(static_cast<uint8_t>(1));
+
+    // 2. Data Store: key = (table, record_key) -> JSON string. In columnar
+    // tables, the record's field names instead (a JSON array, in insertion
+    // order); the values are in `columns`.
+    collections::WeilMap<RecordKey, std::string, collections::RawCodec> store =
+        collections::WeilMap<RecordKey, std::string, collections::RawCodec>(static_cast<uint8_t>(2));
+
+    // 3. Retired: record counts live in TableMeta
+
+    // 4. Index-to-Key: key = (table, index) -> "record_key"
+    collections::WeilMap<IndexKey, std::string, collections::RawCodec> index_to_key =
+        collections::WeilMap<IndexKey, std::string, collections::RawCodec>(static_cast<uint8_t>(4));
+
+    // 5. Key-to-Index: key = (table, record_key) -> index (uint64_t)
+    collections::WeilMap<RecordKey, uint64_t, collections::HexIntCodec<uint64_t>> key_to_index =
+        collections::WeilMap<RecordKey, uint64_t, collections::HexIntCodec<uint64_t>>(static_cast<uint8_t>(5));
+
+    // 6. Columns: key = (table, record_key, field) -> value, for columnar
+    // tables only. Reading or writing one field touches only its own bytes.
+    collections::WeilMap<FieldKey, std::string, collections::RawCodec> columns =
+        collections::WeilMap<FieldKey, std::string, collections::RawCodec>(static_cast<uint8_t>(6));
+
+    // 7. Secondary indexes: key = (table, field, value) -> set of record
+    // keys, for the fields in TableMeta::indexes. Lookups page through one
+    // value's set, so they cost O(matches) host reads.
+    collections::WeilMultiMap<IndexedValue, std::string, collections::RawCodec> field_index =
+        collections::WeilMultiMap<IndexedValue, std::string, collections::RawCodec>(static_cast<uint8_t>(7));
+
+    // 8. Ordered key index: B+tree of (table, record_key), for tables with
+    // kTableOrdered. Range and prefix scans cost O(log N + k) host reads.
+    collections::WeilSortedMap<RecordKey, uint8_t> key_order =
+        collections::WeilSortedMap<RecordKey, uint8_t>(static_cast<uint8_t>(8));
+
+    // 9. Move log: key = (table, move number) -> (old position, new
+    // position, record_key) for the last kMoveLogSize records remove_record
+    // moved, so that scan cursors can tell which records they have already
+    // returned.
+    static constexpr uint64_t kMoveLogSize = 4096;
+    using Move = std::tuple<uint64_t, uint64_t, std::string>;
+    collections::WeilMap<IndexKey, Move, collections::BinaryCodec<Move>> move_log =
+        collections::WeilMap<IndexKey, Move, collections::BinaryCodec<Move>>(static_cast<uint8_t>(9));
+
+    // 10. Jobs: key = token -> Job, for bulk operations that ran out of
+    // budget and wait for resume()
+    collections::WeilMap<std::string, Job, collections::BinaryCodec<Job>> jobs =
+        collections::WeilMap<std::string, Job, collections::BinaryCodec<Job>>(static_cast<uint8_t>(10));
+
+    // 11. Job items: key = (token, n) -> record, the records a kJobInsert
+    // job has still to insert
+    using Record = std::tuple<std::string, std::vector<std::tuple<std::string, std::string>>>;
+    collections::WeilMap<IndexKey, Record, collections::BinaryCodec<Record>> job_items =
+        collections::WeilMap<IndexKey, Record, collections::BinaryCodec<Record>>(static_cast<uint8_t>(11));
+
+    // 12. Versions: key = (table, record_key) -> number of writes to the
+    // record since it was created, for cas(). Read in the same batch as the
+    // record, so keeping it costs no extra host call.
+    collections::WeilMap<RecordKey, uint64_t, collections::HexIntCodec<uint64_t>> versions =
+        collections::WeilMap<RecordKey, uint64_t, collections::HexIntCodec<uint64_t>>(static_cast<uint8_t>(12));
+
+    // Ids of the next table to be created and the next job; kept in the
+    // contract state itself
+    uint64_t next_table_id = 1;
+    uint64_t next_job_id = 1;
+
+    // Current generation of each table name that has had keys retired, and
+    // the retired key spaces still holding records, oldest first. Both live
+    // in the contract state, so finding a table's key space costs no read;
+    // entries go away once reclaim() has emptied a name's old key spaces.
+    std::map<std::string, uint64_t> generations;
+    std::vector<RetiredSpace> retired;
 
     // --- Helpers ---
     
-    std::vector<std::string> get_tables_list_internal() {
-        if (metadata_registry.contains(std::string("__list__"))) {
-            return metadata_registry.get(std::string("__list__"));
+    // Table names in creation order
+    std::vector<std::string> get_tables_list_internal() const {
+        std::vector<std::pair<uint64_t, std::string>> by_id;
+        for (const auto& entry : table_meta.entries_with_prefix("")) {
+            by_id.emplace_back(entry.second.id, entry.first);
         }
-        return std::vector<std::string>{};
-    }
-
-    void set_tables_list_internal(const std::vector<std::string>& names) {
-        metadata_registry.insert(std::string("__list__"), names);
+        std::sort(by_id.begin(), by_id.end());
+        std::vector<std::string> names;
+        names.reserve(by_id.size());
+        for (auto& t : by_id) {
+            names.push_back(std::move(t.second));
+        }
+        return names;
     }
 
     bool table_exists_persisted(const std::string& table_name) {
-        std::vector<std::string> list = get_tables_list_internal();
-        return std::find(list.begin(), list.end(), table_name) != list.end();
+        return table_meta.contains(table_name);
     }
 
-    static std::string make_record_key(const std::string& table, const std::string& key) {
-        return table + "|" + key;
+    uint64_t generation(const std::string& table) const {
+        auto it = generations.find(table);
+        return it == generations.end() ? 0 : it->second;
     }
 
-    static std::string make_index_key(const std::string& table, uint64_t index) {
-        return table + "|" + std::to_string(index);
-    }
-    
-    static bool is_safe(const std::string& s) {
-        return s.find('|') == std::string::npos;
+    // Prefix of the table's current per-record keys; '|' is not allowed in
+    // table names
+    std::string key_space(const std::string& table) const {
+        uint64_t gen = generation(table);
+        return gen == 0 ? table : table + "|" + std::to_string(gen);
     }
 
-    public:
-    in_memory_db_ContractState() = default;
-
-    // Mutate
-    int32_t create_table(const std::string &table_name) {
-        if (!is_safe(table_name)) return 400;
-        
-        std::vector<std::string> master = get_tables_list_internal();
-        if (std::find(master.begin(), master.end(), table_name) != master.end()) {
-            return 409; // Already exists
-        }
-        master.push_back(table_name);
-        set_tables_list_internal(master);
-        table_counts.insert(table_name, 0);
-        return 200;
+    RecordKey make_record_key(const std::string& table, const std::string& key) const {
+        return {key_space(table), key};
     }
 
-    // Mutate
-// Mutate - O(N) - Reclaims Storage
-    int32_t drop_table(const std::string &table_name) {
-        if (!table_exists_persisted(table_name)) return 404;
+    IndexKey make_index_key(const std::string& table, uint64_t index) const {
+        return {key_space(table), index};
+    }
 
-        uint64_t count = 0;
-        if (table_counts.contains(table_name)) {
-            count = table_counts.get(table_name);
-        }
+    FieldKey make_field_key(const std::string& table, const std::string& key, const std::string& field) const {
+        return FieldKey(key_space(table), key, field);
+    }
 
-        // --- DANGER ZONE: GAS LIMIT ---
-        // If 'count' is huge (e.g. > 2000), this loop might cause the transaction 
-        // to fail (Out of Gas). If that happens, you must delete records manually 
-        // using remove_record() before calling drop_table().
-        for (uint64_t i = 0; i < count; ++i) {
-            std::string idx_key = make_index_key(table_name, i);
-            
-            // We need the user_key to find the other map entries
-            if (index_to_key.contains(idx_key)) {
-                std::string user_key = index_to_key.get(idx_key);
-                std::string composite = make_record_key(table_name, user_key);
+    static bool is_columnar(const TableMeta& meta) {
+        return (meta.flags & kTableColumnar) != 0;
+    }
 
-                // 1. Delete the Data Record
-                store.remove(composite);
+    static std::vector<std::string> parse_field_list(const std::string& raw) {
+        std::vector<std::string> names;
+        try { weilsdk::CountedJson::parse<nlohmann::json>(raw).get_to(names); } catch (...) {}
+        return names;
+    }
 
-                // 2. Delete the Lookup (Key -> Index)
-                key_to_index.remove(composite);
-            }
+    static bool is_indexed(const TableMeta& meta, const std::string& field) {
+        return std::find(meta.indexes.begin(), meta.indexes.end(), field) != meta.indexes.end();
+    }
 
-            // 3. Delete the Index (Index -> Key)
-            index_to_key.remove(idx_key);
-        }
-        // ------------------------------
+    // Field values as get_value returns them
+    static std::string field_text(const nlohmann::ordered_json& v) {
+        return v.is_string() ? v.get<std::string>() : weilsdk::CountedJson::dump(v);
+    }
 
-        // Final Metadata Cleanup
-        std::vector<std::string> master = get_tables_list_internal();
-        auto it = std::remove(master.begin(), master.end(), table_name);
-        if (it != master.end()) {
-            master.erase(it, master.end());
-            set_tables_list_internal(master);
+    // The listed fields of a row record, in the order asked for. Members
+    // not asked for are dropped by the parser instead of being built
+    static std::vector<std::tuple<std::string, std::string>> project_row(const std::string& raw,
+                                                                         const std::vector<std::string>& fields) {
+        std::vector<std::tuple<std::string, std::string>> out;
+        nlohmann::ordered_json j;
+        try {
+            j = weilsdk::CountedJson::parse<nlohmann::ordered_json>(raw, [&fields](int depth, nlohmann::ordered_json::parse_event_t event,
+                                                             nlohmann::ordered_json& parsed) {
+                return depth != 1 || event != nlohmann::ordered_json::parse_event_t::key ||
+                       std::find(fields.begin(), fields.end(), parsed.get_ref<const std::string&>()) != fields.end();
+            });
+        } catch (...) { return out; }
+        if (!j.is_object()) return out;
+        for (const auto& f : fields) {
+            auto it = j.find(f);
+            if (it != j.end()) out.emplace_back(f, field_text(*it));
         }
-        
-        // Remove the count
-        table_counts.remove(table_name);
-
-        return 200;
+        return out;
     }
 
-    // Query
-    std::vector<std::string> list_tables() {
-        return get_tables_list_internal();
+    // Moves a record from the index entry of a field's old value to that of
+    // its new one; nullopt stands for "field absent"
+    void reindex(const std::string& table, const std::string& field, const std::string& key,
+                 const std::optional<std::string>& old_value, const std::optional<std::string>& new_value) {
+        if (old_value == new_value) return;
+        if (old_value) field_index.erase(IndexedValue(key_space(table), field, *old_value), key);
+        if (new_value) field_index.insert(IndexedValue(key_space(table), field, *new_value), key);
     }
 
-    // Query
-    int32_t table_size(const std::string &table_name) {
-        if (table_counts.contains(table_name)) {
-            return static_cast<int32_t>(table_counts.get(table_name));
+    // Takes a record out of every index of its table, given the table's
+    // key space so that it also works for retired ones
+    void unindex_record(const std::string& space, const TableMeta& meta, const std::string& key, const std::string& raw) {
+        if (meta.indexes.empty()) return;
+        if (is_columnar(meta)) {
+            collections::ReadBatch batch;
+            for (const auto& field : meta.indexes) {
+                batch.add(columns, FieldKey(space, key, field));
+            }
+            batch.fetch();
+            for (const auto& field : meta.indexes) {
+                if (std::optional<std::string> v = columns.try_get(FieldKey(space, key, field))) {
+                    field_index.erase(IndexedValue(space, field, *v), key);
+                }
+            }
+            return;
+        }
+        nlohmann::ordered_json j;
+        try { j = weilsdk::CountedJson::parse<nlohmann::ordered_json>(raw); } catch(...) { return; }
+        for (const auto& field : meta.indexes) {
+            if (j.contains(field)) {
+                field_index.erase(IndexedValue(space, field, field_text(j[field])), key);
+            }
         }
-        return 0;
     }
 
-    // Mutate
-    int32_t insert(const std::string &table, const std::string &key, const std::string &field, const std::string &value) {
-        if (!table_exists_persisted(table)) return 404;
-        if (!is_safe(key)) return 400;
+    // All fields of a record given its `store` entry, in stored order
+    std::vector<std::tuple<std::string, std::string>> record_fields(const std::string& table, const TableMeta& meta,
+                                                                    const std::string& key, const std::string& raw) {
+        std::vector<std::tuple<std::string, std::string>> out;
+        if (is_columnar(meta)) {
+            std::vector<std::string> names = parse_field_list(raw);
+            collections::ReadBatch batch;
+            for (const auto& f : names) {
+                batch.add(columns, make_field_key(table, key, f));
+            }
+            batch.fetch();
+            for (auto& f : names) {
+                std::optional<std::string> v = columns.try_get(make_field_key(table, key, f));
+                out.emplace_back(std::move(f), v.value_or(std::string()));
+            }
+            return out;
+        }
 
-        std::string composite = make_record_key(table, key);
+        try {
+            nlohmann::ordered_json j = weilsdk::CountedJson::parse<nlohmann::ordered_json>(raw);
+            for (auto& el : j.items()) {
+                out.emplace_back(el.key(), field_text(el.value()));
+            }
+        } catch (...) {}
+        return out;
+    }
 
-        // O(1) Indexing logic
-        if (!store.contains(composite)) {
-            uint64_t count = 0;
-            if (table_counts.contains(table)) count = table_counts.get(table);
+    // Gives a new record the next position in the table's index
+    void register_record(const std::string& table, const std::string& key, TableMeta& meta) {
+        uint64_t count = meta.count++;
 
-            index_to_key.insert(make_index_key(table, count), key);
-            key_to_index.insert(composite, count);
-            table_counts.insert(table, count + 1);
+        index_to_key.insert(make_index_key(table, count), key);
+        key_to_index.insert(make_record_key(table, key), count);
+        if (meta.flags & kTableOrdered) {
+            key_order.insert(make_record_key(table, key), 0);
         }
+    }
 
-        nlohmann::ordered_json j;
-        if (store.contains(composite)) {
-            try { j = nlohmann::ordered_json::parse(store.get(composite)); } catch(...) { j = nlohmann::ordered_json::object(); }
-        } else {
-            j = nlohmann::ordered_json::object();
+    // Keys of an ordered table, in order, from the first one not less than
+    // `start` and for as long as `keep` accepts them
+    template <typename Keep>
+    std::vector<std::string> ordered_keys(const std::string& table, const std::string& start, int32_t limit, Keep keep) const {
+        std::vector<std::string> keys;
+        const std::string space = key_space(table);
+        for (auto it = key_order.lower_bound(RecordKey(space, start));
+             it != key_order.end() && static_cast<int64_t>(keys.size()) < limit; ++it) {
+            const RecordKey& k = it.key();
+            if (k.first != space || !keep(k.second)) break;
+            keys.push_back(k.second);
         }
-
-        j[field] = value;
-        store.insert(composite, j.dump());
-        return 200;
+        return keys;
     }
 
-    // Mutate
-    int32_t update(const std::string &table, const std::string &key, const std::string &field, const std::string &value) {
-        if (!table_exists_persisted(table)) return 404;
-        std::string composite = make_record_key(table, key);
-        
-        if (!store.contains(composite)) return 404; // Should return 404 if record doesn't exist
-
-        std::string raw = store.get(composite);
-        nlohmann::ordered_json j;
-        try { j = nlohmann::ordered_json::parse(raw); } catch(...) { return 500; }
+    // The requested fields of each record, in the order asked for; with no
+    // fields, just the keys. Costs one batched read (none without fields)
+    std::vector<std::tuple<std::string, std::vector<std::tuple<std::string, std::string>>>> project_records(
+            const std::string& table, const TableMeta& meta, std::vector<std::string> keys, const std::vector<std::string>& fields) {
+        std::vector<std::tuple<std::string, std::vector<std::tuple<std::string, std::string>>>> out;
+        out.reserve(keys.size());
+        if (fields.empty()) {
+            for (auto& key : keys) {
+                out.emplace_back(std::move(key), std::vector<std::tuple<std::string, std::string>>());
+            }
+            return out;
+        }
 
-        j[field] = value;
-        store.insert(composite, j.dump());
-        return 200;
+        collections::ReadBatch batch;
+        for (const auto& key : keys) {
+            if (is_columnar(meta)) {
+                for (const auto& f : fields) batch.add(columns, make_field_key(table, key, f));
+            } else {
+                batch.add(store, make_record_key(table, key));
+            }
+        }
+        batch.fetch();
+
+        for (auto& key : keys) {
+            std::vector<std::tuple<std::string, std::string>> projected;
+            if (is_columnar(meta)) {
+                for (const auto& f : fields) {
+                    if (std::optional<std::string> v = columns.try_get(make_field_key(table, key, f))) {
+                        projected.emplace_back(f, std::move(*v));
+                    }
+                }
+            } else if (std::optional<std::string> raw = store.try_get(make_record_key(table, key))) {
+                projected = project_row(*raw, fields);
+            }
+            out.emplace_back(std::move(key), std::move(projected));
+        }
+        return out;
     }
 
-    // Query
-    std::optional<std::string> get_value(const std::string &table, const std::string &key, const std::string &field) {
-        if (!table_exists_persisted(table)) return std::nullopt;
-        std::string composite = make_record_key(table, key);
-        if (!store.contains(composite)) return std::nullopt;
-
-        try {
-            nlohmann::ordered_json j = nlohmann::ordered_json::parse(store.get(composite));
-            if (j.contains(field)) {
-                auto v = j[field];
-                return v.is_string() ? std::optional<std::string>(v.get<std::string>()) : std::optional<std::string>(v.dump());
+    // Writes fields of a columnar record. `list` is the record's stored
+    // field list, or nullopt if the record is new
+    void write_columns(const std::string& table, const TableMeta& meta, const std::string& key,
+                       const std::optional<std::string>& list,
+                       const std::vector<std::tuple<std::string, std::string>>& fields) {
+        std::vector<std::string> names;
+        if (list) names = parse_field_list(*list);
+        bool names_changed = !list;
+        for (const auto& f : fields) {
+            const std::string& name = std::get<0>(f);
+            bool is_new = std::find(names.begin(), names.end(), name) == names.end();
+            if (is_new) {
+                names.push_back(name);
+                names_changed = true;
             }
-        } catch (...) {}
-        return std::nullopt;
+            if (is_indexed(meta, name)) {
+                std::optional<std::string> old_value;
+                if (!is_new) old_value = columns.try_get(make_field_key(table, key, name));
+                reindex(table, name, key, old_value, std::get<1>(f));
+            }
+            columns.insert(make_field_key(table, key, name), std::get<1>(f));
+        }
+        if (names_changed) {
+            store.insert(make_record_key(table, key), weilsdk::CountedJson::dump(nlohmann::json(names)));
+        }
     }
 
-    // Mutate
-    int32_t remove_field(const std::string &table, const std::string &key, const std::string &field) {
-        if (!table_exists_persisted(table)) return 404;
-        std::string composite = make_record_key(table, key);
-        if (!store.contains(composite)) return 404;
+    // Sets fields of an existing record given its `store` entry; a row
+    // record is parsed and written once whatever the number of fields
+    int32_t apply_fields(const std::string& table, const TableMeta& meta, const std::string& key, const std::string& raw,
+                         const std::vector<std::tuple<std::string, std::string>>& fields) {
+        if (is_columnar(meta)) {
+            write_columns(table, meta, key, raw, fields);
+            bump_version(table, key);
+            return 200;
+        }
 
         nlohmann::ordered_json j;
-        try { j = nlohmann::ordered_json::parse(store.get(composite)); } catch(...) { return 500; }
+        try { j = weilsdk::CountedJson::parse<nlohmann::ordered_json>(raw); } catch(...) { return 500; }
 
-        if (j.contains(field)) {
-            j.erase(field);
-            if (j.empty()) {
-                return remove_record(table, key);
+        for (const auto& f : fields) {
+            const std::string& name = std::get<0>(f);
+            if (is_indexed(meta, name)) {
+                reindex(table, name, key, j.contains(name) ? std::optional<std::string>(field_text(j[name])) : std::nullopt, std::get<1>(f));
             }
-            store.insert(composite, j.dump());
+            j[name] = std::get<1>(f);
         }
+        store.insert(make_record_key(table, key), weilsdk::CountedJson::dump(j));
+        bump_version(table, key);
         return 200;
     }
 
-    // Mutate - O(1) via Swap-and-Pop
-    int32_t remove_record(const std::string &table, const std::string &key) {
-        if (!table_exists_persisted(table)) return 404;
-        std::string composite = make_record_key(table, key);
-        if (!store.contains(composite)) return 404;
+    // Reads the indexed fields of columnar records in one batch, so that
+    // keeping the indexes up to date costs no further read per record
+    void prefetch_indexed_columns(const std::string& table, const TableMeta& meta, const std::vector<std::string>& keys) {
+        if (!is_columnar(meta) || meta.indexes.empty()) return;
+        collections::ReadBatch batch;
+        for (const auto& key : keys) {
+            for (const auto& field : meta.indexes) {
+                batch.add(columns, make_field_key(table, key, field));
+            }
+        }
+        batch.fetch();
+    }
 
+    // Swap-and-pop removal of an existing record; the caller writes `meta`
+    void remove_one(const std::string &table, TableMeta &meta, const std::string &key, const std::string &raw) {
+        RecordKey composite = make_record_key(table, key);
         // 1. Remove Data
-        store.remove(composite);
+        unindex_record(key_space(table), meta, key, raw);
+        if (is_columnar(meta)) {
+            for (const auto& field : parse_field_list(raw)) {
+                columns.erase(make_field_key(table, key, field));
+            }
+        }
+        store.erase(composite);
+        versions.erase(composite);
+        if (meta.flags & kTableOrdered) {
+            key_order.remove(composite);
+        }
 
         // 2. Fix Index
-        uint64_t count = table_counts.get(table);
+        uint64_t count = meta.count;
         uint64_t index_to_remove = key_to_index.get(composite);
         uint64_t last_index = count - 1;
 
         if (index_to_remove != last_index) {
-            std::string last_key_idx_str = make_index_key(table, last_index);
-            std::string last_key = index_to_key.get(last_key_idx_str);
-            std::string last_key_composite = make_record_key(table, last_key);
+            // Phase 2: the record to move into the freed slot
+            IndexKey last_key_idx = make_index_key(table, last_index);
+            std::string last_key = index_to_key.get(last_key_idx);
+            RecordKey last_key_composite = make_record_key(table, last_key);
 
             // Move last key to the empty slot
             index_to_key.insert(make_index_key(table, index_to_remove), last_key);
             key_to_index.insert(last_key_composite, index_to_remove);
+
+            // Log the move for open scan cursors, dropping the oldest entry
+            uint64_t move = meta.moves++;
+            move_log.insert(make_index_key(table, move), Move(last_index, index_to_remove, last_key));
+            if (move >= kMoveLogSize) {
+                move_log.erase(make_index_key(table, move - kMoveLogSize));
+            }
         }
 
         // Cleanup tail
-        index_to_key.remove(make_index_key(table, last_index));
-        key_to_index.remove(composite);
-        table_counts.insert(table, last_index); // count - 1
+        index_to_key.erase(make_index_key(table, last_index));
+        key_to_index.erase(composite);
+        meta.count = last_index; // count - 1
+    }
+
+    // Read-modify-write of one field in a single call. `modify` gets the
+    // field's value (nullopt if absent) and returns the new one, or nullopt
+    // to leave the record alone. A missing record is created. Returns the
+    // new value and the record's new version; nullopt if the table does not
+    // exist, the key is not allowed or `modify` declined.
+    template <typename Modify>
+    std::optional<std::pair<std::string, uint64_t>> modify_field(const std::string& table, const std::string& key,
+                                                                 const std::string& field, Modify modify) {
+        // One round trip; the column is read in case the table is columnar
+        RecordKey composite = make_record_key(table, key);
+        collections::ReadBatch()
+            .add(table_meta, table)
+            .add(store, composite)
+            .add(versions, composite)
+            .add(columns, make_field_key(table, key, field))
+            .fetch();
+        std::optional<TableMeta> meta = table_meta.try_get(table);
+        if (!meta || !is_safe(key)) return std::nullopt;
+        std::optional<std::string> raw = store.try_get(composite);
+
+        std::optional<std::string> current;
+        nlohmann::ordered_json j = nlohmann::ordered_json::object();
+        if (raw && is_columnar(*meta)) {
+            current = columns.try_get(make_field_key(table, key, field));
+        } else if (raw) {
+            try { j = weilsdk::CountedJson::parse<nlohmann::ordered_json>(*raw); } catch(...) { return std::nullopt; }
+            if (j.contains(field)) current = field_text(j[field]);
+        }
+        std::optional<std::string> value = modify(current);
+        if (!value) return std::nullopt;
+
+        if (!raw) {
+            register_record(table, key, *meta);
+            table_meta.insert(table, *meta);
+        }
+        if (is_columnar(*meta)) {
+            write_columns(table, *meta, key, raw, {{field, *value}});
+        } else {
+            if (is_indexed(*meta, field)) reindex(table, field, key, current, *value);
+            j[field] = *value;
+            store.insert(composite, weilsdk::CountedJson::dump(j));
+        }
+        return std::make_pair(std::move(*value), bump_version(table, key));
+    }
 
+    int32_t create_table_internal(const std::string& table_name, uint32_t flags) {
+        if (!is_safe(table_name)) return 400;
+        
+        if (table_exists_persisted(table_name)) {
+            return 409; // Already exists
+        }
+        TableMeta meta;
+        meta.id = next_table_id++;
+        meta.flags = flags;
+        table_meta.insert(table_name, meta);
         return 200;
     }
+    
+    // Moves a deployment made before per-table metadata onto this layout.
+    // Its state listed the tables under "tables"; records were kept as
+    // JSON-encoded strings under "2_table|key", their positions under
+    // "4_table|index" and the counts under "3_table". Each table gets its
+    // metadata, its records keep their positions, and the legacy keys are
+    // deleted. Deletes go through the WriteBuffer like every other write,
+    // so a query that sees the legacy state migrates it for its own reads
+    // and drops the lot; the first mutation persists it and writes back a
+    // state without "tables". O(total records), as legacy drop_table was.
+    void migrate_legacy(const std::vector<std::string>& tables) {
+        using Raw = std::vector<std::pair<std::string, std::string>>;
+        auto legacy_string = [](const std::string& encoded) {
+            nlohmann::json j = weilsdk::CountedJson::parse<nlohmann::json>(encoded, nullptr, false);
+            return j.is_string() ? j.get<std::string>() : std::string();
+        };
+
+        for (const auto& table : tables) {
+            if (!is_safe(table) || table_exists_persisted(table)) continue;
+            const std::string prefix = table + "|";
+
+            std::map<std::string, std::string> records;
+            for (const auto& e : weilsdk::Memory::readPrefixForTrie<Raw>("2_" + prefix).value_or(Raw{})) {
+                records[e.first.substr(2 + prefix.size())] = legacy_string(e.second);
+            }
+            std::vector<std::pair<uint64_t, std::string>> positions;
+            for (const auto& e : weilsdk::Memory::readPrefixForTrie<Raw>("4_" + prefix).value_or(Raw{})) {
+                const std::string index = e.first.substr(2 + prefix.size());
+                if (index.empty() || index.find_first_not_of("0123456789") != std::string::npos) continue;
+                positions.emplace_back(std::stoull(index), legacy_string(e.second));
+                collections::WriteBuffer::erase<std::string>(e.first);
+            }
+            std::sort(positions.begin(), positions.end());
+
+            TableMeta meta;
+            meta.id = next_table_id++;
+            for (const auto& position : positions) {
+                const std::string& key = position.second;
+                auto it = records.find(key);
+                if (it == records.end()) continue;
+                store.insert(make_record_key(table, key), it->second);
+                register_record(table, key, meta);
+                bump_version(table, key);
+                records.erase(it);
+                collections::WriteBuffer::erase<std::string>("2_" + prefix + key);
+                collections::WriteBuffer::erase<uint64_t>("5_" + prefix + key);
+            }
+            // Records without a position were unreachable before as well
+            for (const auto& orphan : records) {
+                collections::WriteBuffer::erase<std::string>("2_" + prefix + orphan.first);
+                collections::WriteBuffer::erase<uint64_t>("5_" + prefix + orphan.first);
+            }
+            table_meta.insert(table, meta);
+            collections::WriteBuffer::erase<uint64_t>("3_" + table);
+        }
+        collections::WriteBuffer::erase<TableMeta>("1___list__");
+    }
 
-    // Mutate
-    int32_t insert_record(const std::string &table, const std::string &key, const std::vector<std::tuple<std::string, std::string>> &fields) {
-        std::vector<std::tuple<std::string, std::vector<std::tuple<std::string, std::string>>>> batch;
-        batch.push_back({key, fields});
-        return insert_records(table, batch) > 0 ? 200 : 500;
+    // Reads the table metadata and one record in a single host round trip,
+    // with the record's version if it is going to be written
+    void prefetch_record(const std::string& table, const RecordKey& composite, bool for_write = false) {
+        collections::ReadBatch batch;
+        batch.add(table_meta, table).add(store, composite);
+        if (for_write) batch.add(versions, composite);
+        batch.fetch();
     }
 
-    // Mutate
-    int32_t insert_records(const std::string &table, const std::vector<std::tuple<std::string, std::vector<std::tuple<std::string, std::string>>>> &records) {
-        if (!table_exists_persisted(table)) return 0;
-        int32_t success = 0;
+    // Counts a write to a record; returns its new version
+    uint64_t bump_version(const std::string& table, const std::string& key) {
+        RecordKey composite = make_record_key(table, key);
+        uint64_t version = versions.try_get(composite).value_or(0) + 1;
+        versions.insert(composite, version);
+        return version;
+    }
 
-        for (const auto& rec : records) {
-            std::string key = std::get<0>(rec);
-            if (!is_safe(key)) continue;
+    // Hands the table's records over to reclaim() and moves its name to a
+    // fresh key space. A table that never held a record has nothing to hand
+    // over and keeps its key space
+    void retire_key_space(const std::string& table, const TableMeta& meta) {
+        if (meta.count == 0 && meta.moves == 0) return;
+        retired.push_back(RetiredSpace{table, key_space(table), meta});
+        generations[table] = generation(table) + 1;
+    }
 
-            std::string composite = make_record_key(table, key);
-            
-            // Register Index if new
-            if (!store.contains(composite)) {
-                uint64_t count = 0;
-                if (table_counts.contains(table)) count = table_counts.get(table);
-                
-                index_to_key.insert(make_index_key(table, count), key);
-                key_to_index.insert(composite, count);
-                table_counts.insert(table, count + 1);
+    // Lets a name go back to generation 0 once no table uses it and its old
+    // key spaces are empty
+    void forget_generation(const std::string& table) {
+        if (generations.count(table) == 0 || table_meta.contains(table)) return;
+        for (const auto& r : retired) {
+            if (r.table == table) return;
+        }
+        generations.erase(table);
+    }
+
+    // Deletes the keys of the last `n` records of a retired key space, in
+    // two batched reads
+    void reclaim_records(RetiredSpace& r, uint64_t n) {
+        const TableMeta& meta = r.meta;
+        std::vector<IndexKey> positions;
+        for (uint64_t pos = meta.count - n; pos < meta.count; ++pos) {
+            positions.push_back(IndexKey(r.space, pos));
+        }
+        std::vector<std::optional<std::string>> keys = index_to_key.get_many(positions);
+
+        // Record contents are only needed to find columns and index entries
+        const bool need_contents = is_columnar(meta) || !meta.indexes.empty();
+        if (need_contents) {
+            collections::ReadBatch batch;
+            for (const auto& key : keys) {
+                if (key) batch.add(store, RecordKey(r.space, *key));
             }
+            batch.fetch();
+        }
 
-            // Build JSON
-            nlohmann::ordered_json j;
-            if (store.contains(composite)) {
-                 try { j = nlohmann::ordered_json::parse(store.get(composite)); } catch(...) {}
-            } else { j = nlohmann::ordered_json::object(); }
+        for (size_t i = 0; i < keys.size(); ++i) {
+            index_to_key.erase(positions[i]);
+            if (!keys[i]) continue;
+            const std::string& key = *keys[i];
+            RecordKey composite(r.space, key);
+            if (need_contents) {
+                if (std::optional<std::string> raw = store.try_get(composite)) {
+                    unindex_record(r.space, meta, key, *raw);
+                    if (is_columnar(meta)) {
+                        for (const auto& field : parse_field_list(*raw)) {
+                            columns.erase(FieldKey(r.space, key, field));
+                        }
+                    }
+                }
+            }
+            store.erase(composite);
+            versions.erase(composite);
+            key_to_index.erase(composite);
+            if (meta.flags & kTableOrdered) {
+                key_order.remove(composite);
+            }
+        }
+        r.meta.count -= n;
+    }
 
-            for (const auto& f : std::get<1>(rec)) {
-                j[std::get<0>(f)] = std::get<1>(f);
+    static bool is_building(const TableMeta& meta, const std::string& field) {
+        return std::find(meta.building.begin(), meta.building.end(), field) != meta.building.end();
+    }
+
+    // Saves a new job and returns its token
+    std::string start_job(Job job) {
+        std::string token = std::to_string(next_job_id++);
+        jobs.insert(token, job);
+        return token;
+    }
+
+    // Does up to `max_ops` records of a job's work. Returns (200, "") once
+    // the job is done and forgotten, (202, token) while work is left, and
+    // (404, "") if its table has been dropped, which ends the job.
+    std::tuple<int32_t, std::string> run_job(const std::string& token, Job& job, uint64_t max_ops) {
+        std::optional<TableMeta> meta = table_meta.try_get(job.table);
+        bool done = true;
+        int32_t status = 200;
+        if (!meta || meta->id != job.table_id) {
+            status = 404;
+            for (uint64_t n = job.next; n < job.total; ++n) {
+                job_items.erase(IndexKey(token, n));
             }
+        } else if (job.kind == kJobInsert) {
+            done = insert_step(token, job, max_ops);
+        } else {
+            done = backfill_step(job, *meta, max_ops);
+        }
 
-            store.insert(composite, j.dump());
-            success++;
+        if (!done) {
+            jobs.insert(token, job);
+            return std::make_tuple(202, token);
         }
-        return success;
+        jobs.erase(token);
+        return std::make_tuple(status, std::string());
     }
 
-    // Query
-    std::vector<std::tuple<std::string, std::string>> get_fields(const std::string &table, const std::string &key, const std::vector<std::string> &fields) {
-        std::vector<std::tuple<std::string, std::string>> out;
-        if (!table_exists_persisted(table)) return out;
+    // Inserts the job's next `max_ops` records, read in one batch
+    bool insert_step(const std::string& token, Job& job, uint64_t max_ops) {
+        uint64_t end = job.next + std::min(max_ops, job.total - job.next);
+        std::vector<IndexKey> ids;
+        for (uint64_t n = job.next; n < end; ++n) {
+            ids.push_back(IndexKey(token, n));
+        }
+        std::vector<Record> records;
+        for (auto& item : job_items.get_many(ids)) {
+            if (item) records.push_back(std::move(*item));
+        }
+        insert_records(job.table, records);
+        for (const auto& id : ids) {
+            job_items.erase(id);
+        }
+        job.next = end;
+        return job.next == job.total;
+    }
 
-        std::string composite = make_record_key(table, key);
-        if (!store.contains(composite)) return out;
+    // Adds the records at the next `max_ops` positions below job.next to
+    // the index being built. Going downwards, swap-and-pop can only move a
+    // record to a position not visited yet if it was visited already, and
+    // records written meanwhile are indexed by the write itself, so none is
+    // missed.
+    bool backfill_step(Job& job, TableMeta& meta, uint64_t max_ops) {
+        const std::string& table = job.table;
+        bool pending = job.kind == kJobIndex ? is_building(meta, job.field) : (meta.flags & kTableOrderPending) != 0;
+        // A dropped index needs nothing more; after a truncate every record
+        // in the new key space was indexed when written
+        if (pending && job.generation == generation(table)) {
+            uint64_t next = std::min(job.next, meta.count);
+            uint64_t lo = next - std::min(next, max_ops);
+            std::vector<IndexKey> positions;
+            for (uint64_t pos = lo; pos < next; ++pos) {
+                positions.push_back(make_index_key(table, pos));
+            }
+            std::vector<std::optional<std::string>> keys = index_to_key.get_many(positions);
+
+            if (job.kind == kJobKeyIndex) {
+                for (const auto& key : keys) {
+                    if (key) key_order.insert(make_record_key(table, *key), 0);
+                }
+            } else {
+                collections::ReadBatch batch;
+                for (const auto& key : keys) {
+                    if (!key) continue;
+                    if (is_columnar(meta)) {
+                        batch.add(columns, make_field_key(table, *key, job.field));
+                    } else {
+                        batch.add(store, make_record_key(table, *key));
+                    }
+                }
+                batch.fetch();
+                for (const auto& key : keys) {
+                    if (!key) continue;
+                    std::optional<std::string> value;
+                    if (is_columnar(meta)) {
+                        value = columns.try_get(make_field_key(table, *key, job.field));
+                    } else if (std::optional<std::string> raw = store.try_get(make_record_key(table, *key))) {
+                        try {
+                            nlohmann::ordered_json j = weilsdk::CountedJson::parse<nlohmann::ordered_json>(*raw);
+                            if (j.contains(job.field)) value = field_text(j[job.field]);
+                        } catch (...) {}
+                    }
+                    if (value) field_index.insert(IndexedValue(key_space(table), job.field, *value), *key);
+                }
+            }
+            job.next = lo;
+            if (lo > 0) return false;
+        }
 
-        nlohmann::ordered_json j;
-        try { j = nlohmann::ordered_json::parse(store.get(composite)); } catch(...) { return out; }
+        if (pending) {
+            if (job.kind == kJobIndex) {
+                meta.building.erase(std::find(meta.building.begin(), meta.building.end(), job.field));
+            } else {
+                meta.flags &= ~kTableOrderPending;
+            }
+            table_meta.insert(table, meta);
+        }
+        return true;
+    }
 
-        for (const auto& f : fields) {
-            if (j.contains(f)) {
-                auto val = j[f];
-                out.emplace_back(f, val.is_string() ? val.get<std::string>() : val.dump());
+    // Parses {"eq": [field, value]} (likewise ne, lt, gt, prefix),
+    // {"in": [field, [values]]} and {"and" | "or": [conditions]}
+    static bool parse_predicate(const nlohmann::json& j, Predicate& p, int depth = 0) {
+        static const std::pair<const char*, Predicate::Op> kOps[] = {
+            {"eq", Predicate::kEq}, {"ne", Predicate::kNe}, {"lt", Predicate::kLt}, {"gt", Predicate::kGt},
+            {"prefix", Predicate::kPrefix}, {"in", Predicate::kIn}, {"and", Predicate::kAnd}, {"or", Predicate::kOr}};
+        if (depth > 32 || !j.is_object() || j.size() != 1) return false;
+        const std::string& name = j.begin().key();
+        const nlohmann::json& arg = j.begin().value();
+        auto op = std::find_if(std::begin(kOps), std::end(kOps), [&](const auto& o) { return name == o.first; });
+        if (op == std::end(kOps) || !arg.is_array()) return false;
+        p.op = op->second;
+
+        if (p.op == Predicate::kAnd || p.op == Predicate::kOr) {
+            if (arg.empty()) return false;
+            for (const auto& child : arg) {
+                p.children.emplace_back();
+                if (!parse_predicate(child, p.children.back(), depth + 1)) return false;
             }
+            return true;
         }
-        return out;
+        if (arg.size() != 2 || !arg[0].is_string()) return false;
+        p.field = arg[0].get<std::string>();
+        if (p.op != Predicate::kIn) {
+            if (!arg[1].is_string()) return false;
+            p.values.push_back(arg[1].get<std::string>());
+            return true;
+        }
+        if (!arg[1].is_array()) return false;
+        for (const auto& v : arg[1]) {
+            if (!v.is_string()) return false;
+            p.values.push_back(v.get<std::string>());
+        }
+        return true;
     }
 
-    // Query
-    std::vector<std::tuple<std::string, std::string>> get_all_fields(const std::string &table, const std::string &key) {
-        std::vector<std::tuple<std::string, std::string>> out;
-        if (!table_exists_persisted(table)) return out;
+    // Comparisons are on the field's text; a missing field matches none
+    template <typename Lookup>
+    static bool matches(const Predicate& p, const Lookup& lookup) {
+        switch (p.op) {
+            case Predicate::kAll:
+                return true;
+            case Predicate::kAnd:
+                for (const auto& c : p.children) {
+                    if (!matches(c, lookup)) return false;
+                }
+                return true;
+            case Predicate::kOr:
+                for (const auto& c : p.children) {
+                    if (matches(c, lookup)) return true;
+                }
+                return false;
+            default:
+                break;
+        }
+        const std::string* v = lookup(p.field);
+        if (!v) return false;
+        switch (p.op) {
+            case Predicate::kEq: return *v == p.values[0];
+            case Predicate::kNe: return *v != p.values[0];
+            case Predicate::kLt: return *v < p.values[0];
+            case Predicate::kGt: return *v > p.values[0];
+            case Predicate::kPrefix: return v->compare(0, p.values[0].size(), p.values[0]) == 0;
+            case Predicate::kIn: return std::find(p.values.begin(), p.values.end(), *v) != p.values.end();
+            default: return false;
+        }
+    }
 
-        std::string composite = make_record_key(table, key);
-        if (!store.contains(composite)) return out;
+    static void predicate_fields(const Predicate& p, std::vector<std::string>& out) {
+        if (!p.field.empty() && std::find(out.begin(), out.end(), p.field) == out.end()) {
+            out.push_back(p.field);
+        }
+        for (const auto& c : p.children) {
+            predicate_fields(c, out);
+        }
+    }
 
-        try {
-            nlohmann::ordered_json j = nlohmann::ordered_json::parse(store.get(composite));
-            for (auto& el : j.items()) {
-                out.emplace_back(el.key(), el.value().is_string() ? el.value().get<std::string>() : el.value().dump());
+    // An eq or in condition on a ready secondary index that every match
+    // must satisfy, so candidates can come from the index instead of a scan
+    static const Predicate* index_condition(const Predicate& p, const TableMeta& meta) {
+        if ((p.op == Predicate::kEq || p.op == Predicate::kIn) && is_indexed(meta, p.field) && !is_building(meta, p.field)) {
+            return &p;
+        }
+        if (p.op == Predicate::kAnd) {
+            for (const auto& c : p.children) {
+                if (const Predicate* found = index_condition(c, meta)) return found;
             }
-        } catch (...) {}
-        return out;
+        }
+        return nullptr;
+    }
+
+    // Evaluates `where` on a batch of candidate keys and adds the matches,
+    // projected, to `out` until it holds `limit` records. One batched read
+    // for row tables; columnar tables read the fields involved, then the
+    // rest of the matches' fields if all are returned
+    void select_batch(const std::string& table, const TableMeta& meta, const Predicate& where,
+                      const std::vector<std::string>& fields, const std::vector<std::string>& keys, size_t limit,
+                      std::vector<std::tuple<std::string, std::vector<std::tuple<std::string, std::string>>>>& out) {
+        std::vector<std::string> needed;
+        predicate_fields(where, needed);
+        for (const auto& f : fields) {
+            if (std::find(needed.begin(), needed.end(), f) == needed.end()) needed.push_back(f);
+        }
+
+        collections::ReadBatch batch;
+        for (const auto& key : keys) {
+            if (!is_columnar(meta) || fields.empty()) batch.add(store, make_record_key(table, key));
+            if (is_columnar(meta)) {
+                for (const auto& f : needed) batch.add(columns, make_field_key(table, key, f));
+            }
+        }
+        batch.fetch();
+
+        std::vector<std::pair<const std::string*, std::string>> hits;
+        for (const auto& key : keys) {
+            if (out.size() + hits.size() >= limit) break;
+            std::vector<std::tuple<std::string, std::string>> values;
+            std::optional<std::string> raw;
+            if (!is_columnar(meta) || fields.empty()) {
+                raw = store.try_get(make_record_key(table, key));
+                if (!raw) continue;
+            }
+            if (is_columnar(meta)) {
+                for (const auto& f : needed) {
+                    if (std::optional<std::string> v = columns.try_get(make_field_key(table, key, f))) {
+                        values.emplace_back(f, std::move(*v));
+                    }
+                }
+            } else {
+                values = fields.empty() ? record_fields(table, meta, key, *raw) : project_row(*raw, needed);
+            }
+            auto lookup = [&values](const std::string& f) -> const std::string* {
+                for (const auto& v : values) {
+                    if (std::get<0>(v) == f) return &std::get<1>(v);
+                }
+                return nullptr;
+            };
+            if (!matches(where, lookup)) continue;
+
+            if (fields.empty() && is_columnar(meta)) {
+                hits.emplace_back(&key, std::move(*raw));
+                continue;
+            }
+            std::vector<std::tuple<std::string, std::string>> projected;
+            if (fields.empty()) {
+                projected = std::move(values);
+            } else {
+                for (const auto& f : fields) {
+                    if (const std::string* v = lookup(f)) projected.emplace_back(f, *v);
+                }
+            }
+            out.emplace_back(key, std::move(projected));
+        }
+
+        // Columnar matches returned whole: all their columns in one batch
+        if (!hits.empty()) {
+            for (const auto& hit : hits) {
+                for (const auto& f : parse_field_list(hit.second)) batch.add(columns, make_field_key(table, *hit.first, f));
+            }
+            batch.fetch();
+            for (const auto& hit : hits) {
+                out.emplace_back(*hit.first, record_fields(table, meta, *hit.first, hit.second));
+            }
+        }
+    }
+
+    // Scan cursors are "<table id>.<generation>.<next position>.<moves>",
+    // then ".<hex key>" for every returned record that a move has put below
+    // the next position, so that later pages skip it
+    static std::string make_scan_cursor(uint64_t id, uint64_t gen, uint64_t next, uint64_t moves,
+                                        const std::set<std::string>& seen) {
+        static const char digits[] = "0123456789abcdef";
+        std::string cursor = std::to_string(id) + "." + std::to_string(gen) + "." + std::to_string(next) + "." +
+                             std::to_string(moves);
+        for (const auto& key : seen) {
+            cursor += '.';
+            for (unsigned char c : key) {
+                cursor += digits[c >> 4];
+                cursor += digits[c & 15];
+            }
+        }
+        return cursor;
+    }
+
+    static bool parse_scan_cursor(const std::string& cursor, uint64_t& id, uint64_t& gen, uint64_t& next,
+                                  uint64_t& moves, std::set<std::string>& seen) {
+        std::vector<std::string> parts;
+        size_t start = 0;
+        for (size_t dot; (dot = cursor.find('.', start)) != std::string::npos; start = dot + 1) {
+            parts.push_back(cursor.substr(start, dot - start));
+        }
+        parts.push_back(cursor.substr(start));
+        if (parts.size() < 4) return false;
+        uint64_t* numbers[] = {&id, &gen, &next, &moves};
+        for (size_t i = 0; i < 4; ++i) {
+            const std::string& part = parts[i];
+            if (part.empty() || part.size() > 19 || part.find_first_not_of("0123456789") != std::string::npos) {
+                return false;
+            }
+            *numbers[i] = std::stoull(part);
+        }
+        for (size_t i = 4; i < parts.size(); ++i) {
+            const std::string& part = parts[i];
+            if (part.size() % 2 != 0 || part.find_first_not_of("0123456789abcdef") != std::string::npos) {
+                return false;
+            }
+            std::string key;
+            for (size_t k = 0; k < part.size(); k += 2) {
+                key += static_cast<char>(std::stoi(part.substr(k, 2), nullptr, 16));
+            }
+            seen.insert(std::move(key));
+        }
+        return true;
+    }
+
+    static bool is_safe(const std::string& s) {
+        return s.find('|') == std::string::npos;
+    }
+
+    public:
+    // Every method re-reads the same few keys (table metadata, the record it
+    // works on) and batch methods rewrite them once per record, so all maps
+    // go through the per-invocation read cache and write-back buffer.
+    in_memory_db_ContractState() {
+        table_meta.enable_cache();
+        table_meta.enable_write_back();
+        store.enable_cache();
+        store.enable_write_back();
+        index_to_key.enable_cache();
+        index_to_key.enable_write_back();
+        key_to_index.enable_cache();
+        key_to_index.enable_write_back();
+        columns.enable_cache();
+        columns.enable_write_back();
+        field_index.enable_cache();
+        field_index.enable_write_back();
+        key_order.enable_cache();
+        key_order.enable_write_back();
+        move_log.enable_cache();
+        move_log.enable_write_back();
+        jobs.enable_cache();
+        jobs.enable_write_back();
+        job_items.enable_cache();
+        job_items.enable_write_back();
+        versions.enable_cache();
+        versions.enable_write_back();
+    }
+
+    // Mutate
+    int32_t create_table(const std::string &table_name) {
+        return create_table_internal(table_name, 0);
+    }
+
+    // Mutate
+    int32_t create_table_with_storage(const std::string &table_name, const std::string &storage) {
+        if (storage == "row") return create_table_internal(table_name, 0);
+        if (storage == "columnar") return create_table_internal(table_name, kTableColumnar);
+        return 400;
+    }
+
+    // Mutate - O(1) - The table's records stay in storage until reclaim()
+    // deletes them
+    int32_t drop_table(const std::string &table_name) {
+        std::optional<TableMeta> meta = table_meta.try_get(table_name);
+        if (!meta) return 404;
+
+        retire_key_space(table_name, *meta);
+        table_meta.erase(table_name);
+        forget_generation(table_name);
+        return 200;
+    }
+
+    // Mutate - O(1) - Removes every record but keeps the table, its storage
+    // mode and its indexes. The old records are left to reclaim()
+    int32_t truncate_table(const std::string &table_name) {
+        std::optional<TableMeta> meta = table_meta.try_get(table_name);
+        if (!meta) return 404;
+
+        retire_key_space(table_name, *meta);
+        meta->count = 0;
+        meta->moves = 0;
+        table_meta.insert(table_name, *meta);
+        return 200;
+    }
+
+    // Mutate - O(max_records) - Deletes the keys of up to max_records
+    // records of dropped or truncated tables, oldest first. Returns how many
+    // such records are left (capped at INT32_MAX); call it until it
+    // returns 0. With max_records <= 0, only reports.
+    int32_t reclaim(int32_t max_records) {
+        uint64_t budget = max_records > 0 ? static_cast<uint64_t>(max_records) : 0;
+        while (budget > 0 && !retired.empty()) {
+            RetiredSpace& r = retired.front();
+            uint64_t n = std::min(budget, r.meta.count);
+            if (n > 0) {
+                reclaim_records(r, n);
+                budget -= n;
+            }
+            if (r.meta.count > 0) break;
+
+            if (r.meta.moves != 0) {
+                for (const auto& entry : move_log.entries_with_key_prefix(r.space)) {
+                    move_log.erase(entry.first);
+                }
+            }
+            std::string table = r.table;
+            retired.erase(retired.begin());
+            forget_generation(table);
+        }
+
+        uint64_t left = 0;
+        for (const auto& r : retired) {
+            left += r.meta.count;
+        }
+        return static_cast<int32_t>(std::min<uint64_t>(left, INT32_MAX));
+    }
+
+    // Query
+    std::vector<std::string> list_tables() {
+        return get_tables_list_internal();
+    }
+
+    // Query
+    int32_t table_size(const std::string &table_name) {
+        std::optional<TableMeta> meta = table_meta.try_get(table_name);
+        return meta ? static_cast<int32_t>(meta->count) : 0;
+    }
+
+    // Mutate
+    int32_t insert(const std::string &table, const std::string &key, const std::string &field, const std::string &value) {
+        RecordKey composite = make_record_key(table, key);
+        prefetch_record(table, composite, true);
+        std::optional<TableMeta> meta = table_meta.try_get(table);
+        if (!meta) return 404;
+        if (!is_safe(key)) return 400;
+
+        std::optional<std::string> existing = store.try_get(composite);
+
+        // O(1) Indexing logic
+        if (!existing) {
+            register_record(table, key, *meta);
+            table_meta.insert(table, *meta);
+        }
+
+        if (is_columnar(*meta)) {
+            write_columns(table, *meta, key, existing, {{field, value}});
+            bump_version(table, key);
+            return 200;
+        }
+
+        nlohmann::ordered_json j;
+        if (existing) {
+            try { j = weilsdk::CountedJson::parse<nlohmann::ordered_json>(*existing); } catch(...) { j = nlohmann::ordered_json::object(); }
+        } else {
+            j = nlohmann::ordered_json::object();
+        }
+
+        if (is_indexed(*meta, field)) {
+            reindex(table, field, key, j.contains(field) ? std::optional<std::string>(field_text(j[field])) : std::nullopt, value);
+        }
+        j[field] = value;
+        store.insert(composite, weilsdk::CountedJson::dump(j));
+        bump_version(table, key);
+        return 200;
+    }
+
+    // Mutate
+    int32_t update(const std::string &table, const std::string &key, const std::string &field, const std::string &value) {
+        RecordKey composite = make_record_key(table, key);
+        prefetch_record(table, composite, true);
+        std::optional<TableMeta> meta = table_meta.try_get(table);
+        if (!meta) return 404;
+
+        std::optional<std::string> raw = store.try_get(composite);
+        if (!raw) return 404; // Should return 404 if record doesn't exist
+
+        return apply_fields(table, *meta, key, *raw, {{field, value}});
+    }
+
+    // Mutate - Sets many fields of an existing record with one parse and
+    // one write
+    int32_t update_fields(const std::string &table, const std::string &key, const std::vector<std::tuple<std::string, std::string>> &fields) {
+        RecordKey composite = make_record_key(table, key);
+        prefetch_record(table, composite, true);
+        std::optional<TableMeta> meta = table_meta.try_get(table);
+        if (!meta) return 404;
+        std::optional<std::string> raw = store.try_get(composite);
+        if (!raw) return 404;
+
+        prefetch_indexed_columns(table, *meta, {key});
+        return apply_fields(table, *meta, key, *raw, fields);
+    }
+
+    // Mutate - update_fields for many records; records that do not exist
+    // are skipped. Returns how many were updated
+    int32_t update_records(const std::string &table, const std::vector<std::tuple<std::string, std::vector<std::tuple<std::string, std::string>>>> &records) {
+        // The table metadata and every record in one round trip
+        collections::ReadBatch batch;
+        batch.add(table_meta, table);
+        for (const auto& rec : records) {
+            RecordKey composite = make_record_key(table, std::get<0>(rec));
+            batch.add(store, composite).add(versions, composite);
+        }
+        batch.fetch();
+        std::optional<TableMeta> meta = table_meta.try_get(table);
+        if (!meta) return 0;
+
+        std::vector<std::string> keys;
+        for (const auto& rec : records) {
+            keys.push_back(std::get<0>(rec));
+        }
+        prefetch_indexed_columns(table, *meta, keys);
+
+        int32_t updated = 0;
+        for (const auto& rec : records) {
+            const std::string& key = std::get<0>(rec);
+            std::optional<std::string> raw = store.try_get(make_record_key(table, key));
+            if (raw && apply_fields(table, *meta, key, *raw, std::get<1>(rec)) == 200) {
+                updated++;
+            }
+        }
+        return updated;
+    }
+
+    // Query
+    std::optional<std::string> get_value(const std::string &table, const std::string &key, const std::string &field) {
+        prefetch_record(table, make_record_key(table, key));
+        std::optional<TableMeta> meta = table_meta.try_get(table);
+        if (!meta) return std::nullopt;
+        if (is_columnar(*meta)) {
+            return columns.try_get(make_field_key(table, key, field));
+        }
+        std::optional<std::string> raw = store.try_get(make_record_key(table, key));
+        if (!raw) return std::nullopt;
+
+        try {
+            nlohmann::ordered_json j = weilsdk::CountedJson::parse<nlohmann::ordered_json>(*raw);
+            if (j.contains(field)) {
+                auto v = j[field];
+                return v.is_string() ? std::optional<std::string>(v.get<std::string>()) : std::optional<std::string>(weilsdk::CountedJson::dump(v));
+            }
+        } catch (...) {}
+        return std::nullopt;
+    }
+
+    // Mutate
+    int32_t remove_field(const std::string &table, const std::string &key, const std::string &field) {
+        RecordKey composite = make_record_key(table, key);
+        prefetch_record(table, composite, true);
+        std::optional<TableMeta> meta = table_meta.try_get(table);
+        if (!meta) return 404;
+        std::optional<std::string> raw = store.try_get(composite);
+        if (!raw) return 404;
+
+        if (is_columnar(*meta)) {
+            std::vector<std::string> names = parse_field_list(*raw);
+            auto it = std::find(names.begin(), names.end(), field);
+            if (it != names.end()) {
+                names.erase(it);
+                if (is_indexed(*meta, field)) {
+                    reindex(table, field, key, columns.try_get(make_field_key(table, key, field)), std::nullopt);
+                }
+                columns.erase(make_field_key(table, key, field));
+                if (names.empty()) {
+                    return remove_record(table, key);
+                }
+                store.insert(composite, weilsdk::CountedJson::dump(nlohmann::json(names)));
+                bump_version(table, key);
+            }
+            return 200;
+        }
+
+        nlohmann::ordered_json j;
+        try { j = weilsdk::CountedJson::parse<nlohmann::ordered_json>(*raw); } catch(...) { return 500; }
+
+        if (j.contains(field)) {
+            if (is_indexed(*meta, field)) {
+                reindex(table, field, key, field_text(j[field]), std::nullopt);
+            }
+            j.erase(field);
+            if (j.empty()) {
+                return remove_record(table, key);
+            }
+            store.insert(composite, weilsdk::CountedJson::dump(j));
+            bump_version(table, key);
+        }
+        return 200;
+    }
+
+    // Mutate - Adds delta to an integer field in one call; a missing
+    // record or field counts as 0. Returns the new value, or nullopt if the
+    // table does not exist or the field does not hold a 64-bit integer
+    std::optional<std::string> incr(const std::string &table, const std::string &key, const std::string &field, int32_t delta) {
+        auto result = modify_field(table, key, field, [delta](const std::optional<std::string>& current) -> std::optional<std::string> {
+            int64_t n = 0;
+            if (current) {
+                const std::string& text = *current;
+                size_t digits = text.size() - (!text.empty() && text[0] == '-');
+                if (digits == 0 || digits > 19 || text.find_first_not_of("0123456789", text.size() - digits) != std::string::npos) {
+                    return std::nullopt;
+                }
+                try { n = std::stoll(text); } catch (...) { return std::nullopt; }
+            }
+            if (__builtin_add_overflow(n, static_cast<int64_t>(delta), &n)) return std::nullopt;
+            return std::to_string(n);
+        });
+        if (!result) return std::nullopt;
+        return result->first;
+    }
+
+    // Mutate - Appends a value to a field holding a JSON array of strings
+    // in one call; a missing record or field counts as []. Returns the new
+    // length, or nullopt if the table does not exist or the field does not
+    // hold an array
+    std::optional<int32_t> append(const std::string &table, const std::string &key, const std::string &field, const std::string &value) {
+        size_t length = 0;
+        auto result = modify_field(table, key, field, [&](const std::optional<std::string>& current) -> std::optional<std::string> {
+            nlohmann::json list = nlohmann::json::array();
+            if (current) {
+                try { list = weilsdk::CountedJson::parse<nlohmann::json>(*current); } catch (...) { return std::nullopt; }
+                if (!list.is_array()) return std::nullopt;
+            }
+            list.push_back(value);
+            length = list.size();
+            return weilsdk::CountedJson::dump(list);
+        });
+        if (!result) return std::nullopt;
+        return static_cast<int32_t>(std::min<size_t>(length, INT32_MAX));
+    }
+
+    // Query - The record's version: 0 if there is no record, otherwise the
+    // number of writes to it since it was created. nullopt if the table does
+    // not exist
+    std::optional<uint64_t> get_version(const std::string &table, const std::string &key) {
+        RecordKey composite = make_record_key(table, key);
+        collections::ReadBatch().add(table_meta, table).add(versions, composite).fetch();
+        if (!table_meta.contains(table)) return std::nullopt;
+        return versions.try_get(composite).value_or(0);
+    }
+
+    // Mutate - Compare-and-set: sets the field only if the record is still
+    // at version `expected` (0: the record must not exist yet, and is
+    // created). Returns (200, new version) on success, (409, current
+    // version) if the record changed in between, (404, 0) if the table does
+    // not exist and (400, 0) for a key that is not allowed
+    std::tuple<int32_t, uint64_t> cas(const std::string &table, const std::string &key, const std::string &field, uint64_t expected, const std::string &new_value) {
+        uint64_t seen = 0;
+        auto result = modify_field(table, key, field, [&](const std::optional<std::string>&) -> std::optional<std::string> {
+            seen = versions.try_get(make_record_key(table, key)).value_or(0);
+            if (seen != expected) return std::nullopt;
+            return new_value;
+        });
+        if (result) return std::make_tuple(200, result->second);
+        if (!table_meta.contains(table)) return std::make_tuple(404, uint64_t(0));
+        if (!is_safe(key)) return std::make_tuple(400, uint64_t(0));
+        return std::make_tuple(409, seen);
+    }
+
+    // Mutate - O(1) via Swap-and-Pop
+    int32_t remove_record(const std::string &table, const std::string &key) {
+        RecordKey composite = make_record_key(table, key);
+        // Phase 1: every key that does not depend on the record's position
+        collections::ReadBatch()
+            .add(table_meta, table)
+            .add(store, composite)
+            .add(key_to_index, composite)
+            .fetch();
+        std::optional<TableMeta> meta = table_meta.try_get(table);
+        if (!meta) return 404;
+        std::optional<std::string> raw = store.try_get(composite);
+        if (!raw) return 404;
+
+        remove_one(table, *meta, key, *raw);
+        table_meta.insert(table, *meta);
+        return 200;
+    }
+
+    // Mutate - remove_record for many keys, with the reads batched and the
+    // table metadata written once. Keys without a record are skipped.
+    // Returns how many records were removed
+    int32_t remove_records(const std::string &table, const std::vector<std::string> &keys) {
+        // Phase 1: the metadata and every record and position
+        collections::ReadBatch batch;
+        batch.add(table_meta, table);
+        for (const auto& key : keys) {
+            batch.add(store, make_record_key(table, key)).add(key_to_index, make_record_key(table, key));
+        }
+        batch.fetch();
+        std::optional<TableMeta> meta = table_meta.try_get(table);
+        if (!meta) return 0;
+
+        std::vector<std::pair<std::string, std::string>> found;
+        std::set<std::string> seen;
+        for (const auto& key : keys) {
+            std::optional<std::string> raw = store.try_get(make_record_key(table, key));
+            if (raw && seen.insert(key).second) found.emplace_back(key, std::move(*raw));
+        }
+        if (found.empty()) return 0;
+
+        // Phase 2: the records that will be moved into freed slots all come
+        // from the last found.size() positions
+        std::vector<IndexKey> tail;
+        for (uint64_t pos = meta->count - std::min<uint64_t>(meta->count, found.size()); pos < meta->count; ++pos) {
+            tail.push_back(make_index_key(table, pos));
+        }
+        index_to_key.get_many(tail);
+        std::vector<std::string> removed;
+        for (const auto& rec : found) {
+            removed.push_back(rec.first);
+        }
+        prefetch_indexed_columns(table, *meta, removed);
+
+        for (const auto& rec : found) {
+            remove_one(table, *meta, rec.first, rec.second);
+        }
+        table_meta.insert(table, *meta);
+        return static_cast<int32_t>(found.size());
+    }
+
+
+    // Mutate
+    int32_t insert_record(const std::string &table, const std::string &key, const std::vector<std::tuple<std::string, std::string>> &fields) {
+        std::vector<std::tuple<std::string, std::vector<std::tuple<std::string, std::string>>>> batch;
+        batch.push_back({key, fields});
+        return insert_records(table, batch) > 0 ? 200 : 500;
+    }
+
+    // Mutate
+    int32_t insert_records(const std::string &table, const std::vector<std::tuple<std::string, std::vector<std::tuple<std::string, std::string>>>> &records) {
+        // The table metadata and every existing record in one round trip
+        collections::ReadBatch batch;
+        batch.add(table_meta, table);
+        for (const auto& rec : records) {
+            RecordKey composite = make_record_key(table, std::get<0>(rec));
+            batch.add(store, composite).add(versions, composite);
+        }
+        batch.fetch();
+        std::optional<TableMeta> meta = table_meta.try_get(table);
+        if (!meta) return 0;
+        const uint64_t initial_count = meta->count;
+        int32_t success = 0;
+
+        for (const auto& rec : records) {
+            std::string key = std::get<0>(rec);
+            if (!is_safe(key)) continue;
+
+            RecordKey composite = make_record_key(table, key);
+            
+            std::optional<std::string> existing = store.try_get(composite);
+
+            // Register Index if new
+            if (!existing) {
+                register_record(table, key, *meta);
+            }
+
+            if (is_columnar(*meta)) {
+                write_columns(table, *meta, key, existing, std::get<1>(rec));
+                bump_version(table, key);
+                success++;
+                continue;
+            }
+
+            // Build JSON
+            nlohmann::ordered_json j;
+            if (existing) {
+                 try { j = weilsdk::CountedJson::parse<nlohmann::ordered_json>(*existing); } catch(...) {}
+            } else { j = nlohmann::ordered_json::object(); }
+
+            for (const auto& f : std::get<1>(rec)) {
+                const std::string& name = std::get<0>(f);
+                if (is_indexed(*meta, name)) {
+                    reindex(table, name, key, j.contains(name) ? std::optional<std::string>(field_text(j[name])) : std::nullopt, std::get<1>(f));
+                }
+                j[name] = std::get<1>(f);
+            }
+
+            store.insert(composite, weilsdk::CountedJson::dump(j));
+            bump_version(table, key);
+            success++;
+        }
+        if (meta->count != initial_count) {
+            table_meta.insert(table, *meta);
+        }
+        return success;
+    }
+
+    // Query
+    std::vector<std::tuple<std::string, std::string>> get_fields(const std::string &table, const std::string &key, const std::vector<std::string> &fields) {
+        std::vector<std::tuple<std::string, std::string>> out;
+        prefetch_record(table, make_record_key(table, key));
+        std::optional<TableMeta> meta = table_meta.try_get(table);
+        if (!meta) return out;
+
+        if (is_columnar(*meta)) {
+            collections::ReadBatch batch;
+            for (const auto& f : fields) {
+                batch.add(columns, make_field_key(table, key, f));
+            }
+            batch.fetch();
+            for (const auto& f : fields) {
+                if (std::optional<std::string> v = columns.try_get(make_field_key(table, key, f))) {
+                    out.emplace_back(f, std::move(*v));
+                }
+            }
+            return out;
+        }
+
+        std::optional<std::string> raw = store.try_get(make_record_key(table, key));
+        if (!raw) return out;
+
+        return project_row(*raw, fields);
+    }
+
+    // Query
+    std::vector<std::tuple<std::string, std::string>> get_all_fields(const std::string &table, const std::string &key) {
+        std::vector<std::tuple<std::string, std::string>> out;
+        prefetch_record(table, make_record_key(table, key));
+        std::optional<TableMeta> meta = table_meta.try_get(table);
+        if (!meta) return out;
+
+        std::optional<std::string> raw = store.try_get(make_record_key(table, key));
+        if (!raw) return out;
+
+        return record_fields(table, *meta, key, *raw);
+    }
+
+    // Query - O(keys) - The records with the given keys, in the order asked
+    // for, each with the listed fields (all of them if empty); keys without
+    // a record are left out. The table metadata and the records come in one
+    // batched read, plus one for a columnar table's values. nullopt if the
+    // table does not exist.
+    std::optional<std::vector<std::tuple<std::string, std::vector<std::tuple<std::string, std::string>>>>>
+    multi_get(const std::string &table, const std::vector<std::string> &keys, const std::vector<std::string> &fields) {
+        collections::ReadBatch batch;
+        batch.add(table_meta, table);
+        for (const auto& key : keys) {
+            batch.add(store, make_record_key(table, key));
+        }
+        batch.fetch();
+        std::optional<TableMeta> meta = table_meta.try_get(table);
+        if (!meta) return std::nullopt;
+
+        std::vector<std::pair<const std::string*, std::string>> found;
+        for (const auto& key : keys) {
+            if (std::optional<std::string> raw = store.try_get(make_record_key(table, key))) {
+                found.emplace_back(&key, std::move(*raw));
+            }
+        }
+        if (is_columnar(*meta)) {
+            for (const auto& rec : found) {
+                for (const auto& f : fields.empty() ? parse_field_list(rec.second) : fields) {
+                    batch.add(columns, make_field_key(table, *rec.first, f));
+                }
+            }
+            batch.fetch();
+        }
+
+        std::vector<std::tuple<std::string, std::vector<std::tuple<std::string, std::string>>>> out;
+        out.reserve(found.size());
+        for (const auto& rec : found) {
+            const std::string& key = *rec.first;
+            if (fields.empty()) {
+                out.emplace_back(key, record_fields(table, *meta, key, rec.second));
+            } else if (is_columnar(*meta)) {
+                std::vector<std::tuple<std::string, std::string>> projected;
+                for (const auto& f : fields) {
+                    if (std::optional<std::string> v = columns.try_get(make_field_key(table, key, f))) {
+                        projected.emplace_back(f, std::move(*v));
+                    }
+                }
+                out.emplace_back(key, std::move(projected));
+            } else {
+                out.emplace_back(key, project_row(rec.second, fields));
+            }
+        }
+        return out;
+    }
+
+    // Mutate - O(N) - Backfills the index from every record of the table
+    int32_t create_index(const std::string &table, const std::string &field) {
+        std::optional<TableMeta> meta = table_meta.try_get(table);
+        if (!meta) return 404;
+        if (is_indexed(*meta, field)) return 409;
+
+        // Gas grows with the table: one bulk read, then an index insert per
+        // record that has the field.
+        const std::string space = key_space(table);
+        if (is_columnar(*meta)) {
+            for (const auto& entry : columns.entries_with_key_prefix(space)) {
+                if (std::get<2>(entry.first) == field) {
+                    field_index.insert(IndexedValue(space, field, entry.second), std::get<1>(entry.first));
+                }
+            }
+        } else {
+            for (const auto& entry : store.entries_with_key_prefix(space)) {
+                try {
+                    nlohmann::ordered_json j = weilsdk::CountedJson::parse<nlohmann::ordered_json>(entry.second);
+                    if (j.contains(field)) {
+                        field_index.insert(IndexedValue(space, field, field_text(j[field])), entry.first.second);
+                    }
+                } catch (...) {}
+            }
+        }
+
+        meta->indexes.push_back(field);
+        table_meta.insert(table, *meta);
+        return 200;
+    }
+
+    // Mutate
+    int32_t drop_index(const std::string &table, const std::string &field) {
+        std::optional<TableMeta> meta = table_meta.try_get(table);
+        if (!meta) return 404;
+        auto it = std::find(meta->indexes.begin(), meta->indexes.end(), field);
+        if (it == meta->indexes.end()) return 404;
+
+        if (is_building(*meta, field)) return 409; // resume its job first
+
+        field_index.erase_with_key_prefix(std::make_tuple(key_space(table), field));
+        meta->indexes.erase(it);
+        table_meta.insert(table, *meta);
+        return 200;
+    }
+
+    // Mutate - O(N log N) - Backfills the ordered key index of a table
+    int32_t create_key_index(const std::string &table) {
+        std::optional<TableMeta> meta = table_meta.try_get(table);
+        if (!meta) return 404;
+        if (meta->flags & kTableOrdered) return 409;
+
+        for (const auto& entry : index_to_key.entries_with_key_prefix(key_space(table))) {
+            key_order.insert(make_record_key(table, entry.second), 0);
+        }
+        meta->flags |= kTableOrdered;
+        table_meta.insert(table, *meta);
+        return 200;
+    }
+
+    // Mutate - O(N log N)
+    int32_t drop_key_index(const std::string &table) {
+        std::optional<TableMeta> meta = table_meta.try_get(table);
+        if (!meta) return 404;
+        if (!(meta->flags & kTableOrdered)) return 404;
+        if (meta->flags & kTableOrderPending) return 409; // resume its job first
+
+        for (const auto& key : ordered_keys(table, std::string(), INT32_MAX, [](const std::string&) { return true; })) {
+            key_order.remove(make_record_key(table, key));
+        }
+        meta->flags &= ~kTableOrdered;
+        table_meta.insert(table, *meta);
+        return 200;
+    }
+
+    // Mutate - O(max_ops) - insert_records for batches too large for one
+    // call: inserts the first max_ops records and keeps the rest for
+    // resume(). Returns (200, "") when all were inserted, (202, token) while
+    // records are left, (404, "") if the table does not exist and (400, "")
+    // if max_ops is not positive.
+    std::tuple<int32_t, std::string> insert_records_budgeted(const std::string &table,
+            const std::vector<std::tuple<std::string, std::vector<std::tuple<std::string, std::string>>>> &records,
+            int32_t max_ops) {
+        if (max_ops <= 0) return std::make_tuple(400, std::string());
+        std::optional<TableMeta> meta = table_meta.try_get(table);
+        if (!meta) return std::make_tuple(404, std::string());
+
+        size_t now = std::min(records.size(), static_cast<size_t>(max_ops));
+        insert_records(table, std::vector<Record>(records.begin(), records.begin() + now));
+        if (now == records.size()) return std::make_tuple(200, std::string());
+
+        Job job;
+        job.kind = kJobInsert;
+        job.table = table;
+        job.table_id = meta->id;
+        job.generation = generation(table);
+        job.total = records.size() - now;
+        std::string token = start_job(job);
+        for (size_t i = now; i < records.size(); ++i) {
+            job_items.insert(IndexKey(token, i - now), records[i]);
+        }
+        return std::make_tuple(202, token);
+    }
+
+    // Mutate - O(max_ops) - create_index that backfills at most max_ops
+    // records per call. The index is maintained by writes right away but
+    // query_by_field only answers once the backfill is done. Returns like
+    // insert_records_budgeted, or (409, "") if the index exists.
+    std::tuple<int32_t, std::string> create_index_budgeted(const std::string &table, const std::string &field, int32_t max_ops) {
+        if (max_ops <= 0) return std::make_tuple(400, std::string());
+        std::optional<TableMeta> meta = table_meta.try_get(table);
+        if (!meta) return std::make_tuple(404, std::string());
+        if (is_indexed(*meta, field)) return std::make_tuple(409, std::string());
+
+        meta->indexes.push_back(field);
+        meta->building.push_back(field);
+        table_meta.insert(table, *meta);
+
+        Job job;
+        job.kind = kJobIndex;
+        job.table = table;
+        job.table_id = meta->id;
+        job.generation = generation(table);
+        job.field = field;
+        job.next = meta->count;
+        std::string token = start_job(job);
+        return run_job(token, job, static_cast<uint64_t>(max_ops));
+    }
+
+    // Mutate - O(max_ops log N) - create_key_index that backfills at most
+    // max_ops keys per call; scan_range and scan_prefix answer once it is
+    // done. Returns like create_index_budgeted.
+    std::tuple<int32_t, std::string> create_key_index_budgeted(const std::string &table, int32_t max_ops) {
+        if (max_ops <= 0) return std::make_tuple(400, std::string());
+        std::optional<TableMeta> meta = table_meta.try_get(table);
+        if (!meta) return std::make_tuple(404, std::string());
+        if (meta->flags & kTableOrdered) return std::make_tuple(409, std::string());
+
+        meta->flags |= kTableOrdered | kTableOrderPending;
+        table_meta.insert(table, *meta);
+
+        Job job;
+        job.kind = kJobKeyIndex;
+        job.table = table;
+        job.table_id = meta->id;
+        job.generation = generation(table);
+        job.next = meta->count;
+        std::string token = start_job(job);
+        return run_job(token, job, static_cast<uint64_t>(max_ops));
+    }
+
+    // Mutate - O(max_ops) - Continues a job returned by one of the
+    // *_budgeted methods. Returns like them; (404, "") for an unknown or
+    // finished token.
+    std::tuple<int32_t, std::string> resume(const std::string &token, int32_t max_ops) {
+        if (max_ops <= 0) return std::make_tuple(400, std::string());
+        std::optional<Job> job = jobs.try_get(token);
+        if (!job) return std::make_tuple(404, std::string());
+        return run_job(token, *job, static_cast<uint64_t>(max_ops));
+    }
+
+    // Query - O(N) at worst - Up to `limit` records matching `where`, with
+    // only the listed fields (all of them if empty). `where` is a JSON
+    // condition: {"eq": [field, value]} and likewise "ne", "lt", "gt" (text
+    // order) and "prefix"; {"in": [field, [values]]}; {"and": [...]} and
+    // {"or": [...]} to combine them; "" matches every record. A missing
+    // field fails every comparison. Records are streamed in batches, the
+    // first the size of `limit` and doubling up to kSelectBatch, evaluated
+    // in the contract, and the scan stops once `limit` records matched. An
+    // eq or in condition on an indexed field that every match must meet is
+    // answered from the index instead of a scan. nullopt if the table does
+    // not exist or `where` is invalid.
+    static constexpr uint64_t kSelectBatch = 256;
+    std::optional<std::vector<std::tuple<std::string, std::vector<std::tuple<std::string, std::string>>>>>
+    select_records(const std::string &table, const std::string &where, const std::vector<std::string> &fields, int32_t limit) {
+        Predicate predicate;
+        if (!where.empty()) {
+            nlohmann::json j = weilsdk::CountedJson::parse<nlohmann::json>(where, nullptr, false);
+            if (j.is_discarded() || !parse_predicate(j, predicate)) return std::nullopt;
+        }
+        std::optional<TableMeta> meta = table_meta.try_get(table);
+        if (!meta) return std::nullopt;
+
+        std::vector<std::tuple<std::string, std::vector<std::tuple<std::string, std::string>>>> out;
+        const size_t want = limit > 0 ? static_cast<size_t>(limit) : 0;
+        const uint64_t first = std::min<uint64_t>(kSelectBatch, std::max<uint64_t>(want, 16));
+
+        if (const Predicate* indexed = index_condition(predicate, *meta)) {
+            std::set<std::string> values(indexed->values.begin(), indexed->values.end());
+            for (auto value = values.begin(); value != values.end() && out.size() < want; ++value) {
+                IndexedValue entry(key_space(table), indexed->field, *value);
+                for (uint64_t offset = 0, n = first; out.size() < want; offset += n, n = std::min(n * 2, kSelectBatch)) {
+                    std::vector<std::string> keys = field_index.page(entry, offset, n);
+                    select_batch(table, *meta, predicate, fields, keys, want, out);
+                    if (keys.size() < n) break;
+                }
+            }
+            return out;
+        }
+
+        for (uint64_t pos = 0, n = first; pos < meta->count && out.size() < want; pos += n, n = std::min(n * 2, kSelectBatch)) {
+            std::vector<IndexKey> positions;
+            for (uint64_t p = pos; p < std::min(meta->count, pos + n); ++p) {
+                positions.push_back(make_index_key(table, p));
+            }
+            std::vector<std::string> keys;
+            for (auto& key : index_to_key.get_many(positions)) {
+                if (key) keys.push_back(std::move(*key));
+            }
+            select_batch(table, *meta, predicate, fields, keys, want, out);
+        }
+        return out;
+    }
+
+    // Query - O(limit) - One page of a table's records, from the highest
+    // position down. Pass "" for the first page and then the returned
+    // cursor, which is "" once the whole table was visited. Records present
+    // for the whole scan are returned exactly once even when remove_record
+    // moves records between pages; records inserted meanwhile may or may not
+    // be. The cursor grows by one key per returned record that a removal
+    // moves ahead of it. Only the listed fields are returned (keys only if
+    // empty). nullopt if the table does not exist, or the cursor is invalid
+    // or more than kMoveLogSize moves old.
+    std::optional<std::tuple<std::vector<std::tuple<std::string, std::vector<std::tuple<std::string, std::string>>>>, std::string>>
+    scan(const std::string &table, const std::string &cursor, int32_t limit, const std::vector<std::string> &fields) {
+        std::optional<TableMeta> meta = table_meta.try_get(table);
+        if (!meta) return std::nullopt;
+
+        // Positions >= `next` had been visited when `moves` moves were logged;
+        // `seen` holds returned records that have been moved below `next`
+        uint64_t next = meta->count;
+        uint64_t moves = meta->moves;
+        std::set<std::string> seen;
+        if (!cursor.empty()) {
+            uint64_t id, gen;
+            if (!parse_scan_cursor(cursor, id, gen, next, moves, seen) || id != meta->id ||
+                gen != generation(table) || moves > meta->moves ||
+                meta->moves - moves > kMoveLogSize) {
+                return std::nullopt;
+            }
+        }
+
+        // So does any record moved since then from a visited position to an
+        // unvisited one. Records only move down, so each one is passed at
+        // most once more; one moved within visited positions never is, and
+        // is left out so that the cursor does not carry it to the end
+        if (moves < meta->moves) {
+            std::vector<IndexKey> log_keys;
+            for (uint64_t m = moves; m < meta->moves; ++m) {
+                log_keys.push_back(make_index_key(table, m));
+            }
+            for (const auto& move : move_log.get_many(log_keys)) {
+                if (move && std::get<0>(*move) >= next && std::get<1>(*move) < next) {
+                    seen.insert(std::get<2>(*move));
+                }
+            }
+        }
+
+        // One batched read per pass; another pass only if skips left the
+        // page short
+        std::vector<std::string> keys;
+        const uint64_t want = limit > 0 ? static_cast<uint64_t>(limit) : 0;
+        next = std::min(next, meta->count);
+        while (next > 0 && keys.size() < want) {
+            uint64_t lo = next - std::min<uint64_t>(next, want - keys.size());
+            std::vector<IndexKey> positions;
+            for (uint64_t pos = next; pos-- > lo;) {
+                positions.push_back(make_index_key(table, pos));
+            }
+            for (auto& key : index_to_key.get_many(positions)) {
+                if (!key) continue;
+                if (!seen.erase(*key)) keys.push_back(std::move(*key));
+            }
+            next = lo;
+        }
+
+        std::string next_cursor;
+        if (next > 0) {
+            next_cursor = make_scan_cursor(meta->id, generation(table), next, meta->moves, seen);
+        }
+        return std::make_tuple(project_records(table, *meta, std::move(keys), fields), std::move(next_cursor));
+    }
+
+    // Query - O(log N + limit) - Records with start <= key < end, in key
+    // order; an empty `end` means no upper bound. Only the listed fields are
+    // returned. nullopt if the table has no ordered key index.
+    std::optional<std::vector<std::tuple<std::string, std::vector<std::tuple<std::string, std::string>>>>>
+    scan_range(const std::string &table, const std::string &start, const std::string &end, int32_t limit, const std::vector<std::string> &fields) {
+        std::optional<TableMeta> meta = table_meta.try_get(table);
+        if (!meta || (meta->flags & (kTableOrdered | kTableOrderPending)) != kTableOrdered) return std::nullopt;
+        std::vector<std::string> keys = ordered_keys(table, start, limit, [&end](const std::string& key) {
+            return end.empty() || key < end;
+        });
+        return project_records(table, *meta, std::move(keys), fields);
+    }
+
+    // Query - O(log N + limit) - Records whose key starts with `prefix`, in
+    // key order, as scan_range
+    std::optional<std::vector<std::tuple<std::string, std::vector<std::tuple<std::string, std::string>>>>>
+    scan_prefix(const std::string &table, const std::string &prefix, int32_t limit, const std::vector<std::string> &fields) {
+        std::optional<TableMeta> meta = table_meta.try_get(table);
+        if (!meta || (meta->flags & (kTableOrdered | kTableOrderPending)) != kTableOrdered) return std::nullopt;
+        std::vector<std::string> keys = ordered_keys(table, prefix, limit, [&prefix](const std::string& key) {
+            return key.compare(0, prefix.size(), prefix) == 0;
+        });
+        return project_records(table, *meta, std::move(keys), fields);
+    }
+
+    // Query - O(limit) - Records whose indexed `field` equals `value`. The
+    // cursor is the position to resume from ("" for the first page) and the
+    // returned one is "" once all matches were returned. Records removed
+    // between pages may cause a later match to be skipped. nullopt if the
+    // table or the index does not exist, or the cursor is invalid.
+    std::optional<std::tuple<std::vector<std::tuple<std::string, std::vector<std::tuple<std::string, std::string>>>>, std::string>>
+    query_by_field(const std::string &table, const std::string &field, const std::string &value, int32_t limit, const std::string &cursor) {
+        std::optional<TableMeta> meta = table_meta.try_get(table);
+        if (!meta || !is_indexed(*meta, field) || is_building(*meta, field)) return std::nullopt;
+        if (cursor.find_first_not_of("0123456789") != std::string::npos || cursor.size() > 19) return std::nullopt;
+        uint64_t offset = cursor.empty() ? 0 : std::stoull(cursor);
+
+        IndexedValue indexed(key_space(table), field, value);
+        std::vector<std::string> keys = field_index.page(indexed, offset, limit > 0 ? static_cast<uint64_t>(limit) : 0);
+
+        // The matching records in one round trip (two for columnar tables)
+        collections::ReadBatch batch;
+        for (const auto& key : keys) {
+            batch.add(store, make_record_key(table, key));
+        }
+        batch.fetch();
+        if (is_columnar(*meta)) {
+            for (const auto& key : keys) {
+                if (std::optional<std::string> raw = store.try_get(make_record_key(table, key))) {
+                    for (const auto& f : parse_field_list(*raw)) {
+                        batch.add(columns, make_field_key(table, key, f));
+                    }
+                }
+            }
+            batch.fetch();
+        }
+
+        std::vector<std::tuple<std::string, std::vector<std::tuple<std::string, std::string>>>> records;
+        records.reserve(keys.size());
+        for (auto& key : keys) {
+            std::optional<std::string> raw = store.try_get(make_record_key(table, key));
+            std::vector<std::tuple<std::string, std::string>> fields;
+            if (raw) fields = record_fields(table, *meta, key, *raw);
+            records.emplace_back(std::move(key), std::move(fields));
+        }
+
+        uint64_t next = offset + records.size();
+        std::string next_cursor = next < field_index.count(indexed) ? std::to_string(next) : std::string();
+        return std::make_tuple(std::move(records), std::move(next_cursor));
+    }
+
+
+        std::string tools() const {
+        return R"JSON(        [
+  {
+    "type": "function",
+    "function": {
+      "name": "create_table",
+      "description": "creates a table (returns 200 success, 409 already exists, 400 invalid name)\n",
+      "parameters": {
+        "type": "object",
+        "properties": {
+          "table_name": {
+            "type": "string",
+            "description": "name of the table to be created\n"
+          }
+        },
+        "required": [
+          "table_name"
+        ]
+      }
+    }
+  },
+  {
+    "type": "function",
+    "function": {
+      "name": "create_table_with_storage",
+      "description": "creates a table with the given storage layout (returns 200 success, 409 already exists, 400 invalid name or storage)\n",
+      "parameters": {
+        "type": "object",
+        "properties": {
+          "table_name": {
+            "type": "string",
+            "description": "name of the table to be created\n"
+          },
+          "storage": {
+            "type": "string",
+            "description": "\"row\" stores each record as one JSON value; \"columnar\" stores each field under its own key, so single-field reads and writes only touch that field\n"
+          }
+        },
+        "required": [
+          "table_name",
+          "storage"
+        ]
+      }
+    }
+  },
+  {
+    "type": "function",
+    "function": {
+      "name": "drop_table",
+      "description": "drops/deletes a table in constant time; its records are deleted later by reclaim (returns 200 success, 404 table not found)\n",
+      "parameters": {
+        "type": "object",
+        "properties": {
+          "table_name": {
+            "type": "string",
+            "description": "name of the table to be deleted\n"
+          }
+        },
+        "required": [
+          "table_name"
+        ]
+      }
+    }
+  },
+  {
+    "type": "function",
+    "function": {
+      "name": "list_tables",
+      "description": "list all the tables present in db now (returns list of table names, empty if none)\n",
+      "parameters": {
+        "type": "object",
+        "properties": {},
+        "required": []
+      }
+    }
+  },
+  {
+    "type": "function",
+    "function": {
+      "name": "table_size",
+      "description": "gives size of any table (returns record count, 404 table not found)\n",
+      "parameters": {
+        "type": "object",
+        "properties": {
+          "table_name": {
+            "type": "string",
+            "description": "name of the table\n"
+          }
+        },
+        "required": [
+          "table_name"
+        ]
+      }
+    }
+  },
+  {
+    "type": "function",
+    "function": {
+      "name": "insert",
+      "description": "inserts field-value pair for a given key (returns 200 success, 404 table missing, 400 invalid input)\n",
+      "parameters": {
+        "type": "object",
+        "properties": {
+          "table": {
+            "type": "string",
+            "description": "name of the table\n"
+          },
+          "key": {
+            "type": "string",
+            "description": "the key / primary key of the record\n"
+          },
+          "field": {
+            "type": "string",
+            "description": "the field name inside the record\n"
+          },
+          "value": {
+            "type": "string",
+            "description": "the value associated with the field\n"
+          }
+        },
+        "required": [
+          "table",
+          "key",
+          "field",
+          "value"
+        ]
+      }
+    }
+  },
+  {
+    "type": "function",
+    "function": {
+      "name": "update",
+      "description": "updates a field value for a given key (returns 200 success, 404 table or record missing)\n",
+      "parameters": {
+        "type": "object",
+        "properties": {
+          "table": {
+            "type": "string",
+            "description": "name of the table\n"
+          },
+          "key": {
+            "type": "string",
+            "description": "the key / primary key of the record\n"
+          },
+          "field": {
+            "type": "string",
+            "description": "the field name to update\n"
+          },
+          "value": {
+            "type": "string",
+            "description": "the new value of the field\n"
+          }
+        },
+        "required": [
+          "table",
+          "key",
+          "field",
+          "value"
+        ]
+      }
+    }
+  },
+  {
+    "type": "function",
+    "function": {
+      "name": "get_value",
+      "description": "get a single field value (returns Some(value) if found, None otherwise)\n",
+      "parameters": {
+        "type": "object",
+        "properties": {
+          "table": {
+            "type": "string",
+            "description": "name of the table\n"
+          },
+          "key": {
+            "type": "string",
+            "description": "the key / primary key of the record\n"
+          },
+          "field": {
+            "type": "string",
+            "description": "the field name whose value is requested\n"
+          }
+        },
+        "required": [
+          "table",
+          "key",
+          "field"
+        ]
+      }
+    }
+  },
+  {
+    "type": "function",
+    "function": {
+      "name": "remove_field",
+      "description": "removes a field from a record (returns 200 success, 404 table or record missing)\n",
+      "parameters": {
+        "type": "object",
+        "properties": {
+          "table": {
+            "type": "string",
+            "description": "name of the table\n"
+          },
+          "key": {
+            "type": "string",
+            "description": "the key / primary key of the record\n"
+          },
+          "field": {
+            "type": "string",
+            "description": "the field name to be removed\n"
+          }
+        },
+        "required": [
+          "table",
+          "key",
+          "field"
+        ]
+      }
+    }
+  },
+  {
+    "type": "function",
+    "function": {
+      "name": "remove_record",
+      "description": "removes a complete record (returns 200 success, 404 table missing)\n",
+      "parameters": {
+        "type": "object",
+        "properties": {
+          "table": {
+            "type": "string",
+            "description": "name of the table\n"
+          },
+          "key": {
+            "type": "string",
+            "description": "the key / primary key of the record\n"
+          }
+        },
+        "required": [
+          "table",
+          "key"
+        ]
+      }
+    }
+  },
+  {
+    "type": "function",
+    "function": {
+      "name": "get_fields",
+      "description": "retrieve multiple fields from a record (returns list of existing field-value pairs)\n",
+      "parameters": {
+        "type": "object",
+        "properties": {
+          "table": {
+            "type": "string",
+            "description": "name of the table\n"
+          },
+          "key": {
+            "type": "string",
+            "description": "the key / primary key of the record\n"
+          },
+          "fields": {
+            "type": "array",
+            "description": "list of field names to retrieve\n"
+          }
+        },
+        "required": [
+          "table",
+          "key",
+          "fields"
+        ]
+      }
+    }
+  },
+  {
+    "type": "function",
+    "function": {
+      "name": "get_all_fields",
+      "description": "retrieve the full record (returns all field-value pairs, empty if record missing)\n",
+      "parameters": {
+        "type": "object",
+        "properties": {
+          "table": {
+            "type": "string",
+            "description": "name of the table\n"
+          },
+          "key": {
+            "type": "string",
+            "description": "the key / primary key of the record\n"
+          }
+        },
+        "required": [
+          "table",
+          "key"
+        ]
+      }
+    }
+  },
+  {
+    "type": "function",
+    "function": {
+      "name": "create_index",
+      "description": "indexes a field of a table so query_by_field can look records up by its value (returns 200 success, 404 table missing, 409 already indexed)\n",
+      "parameters": {
+        "type": "object",
+        "properties": {
+          "table": {
+            "type": "string",
+            "description": "name of the table\n"
+          },
+          "field": {
+            "type": "string",
+            "description": "the field name to index\n"
+          }
+        },
+        "required": [
+          "table",
+          "field"
+        ]
+      }
+    }
+  },
+  {
+    "type": "function",
+    "function": {
+      "name": "drop_index",
+      "description": "removes the index of a field (returns 200 success, 404 table or index missing, 409 index still being built)\n",
+      "parameters": {
+        "type": "object",
+        "properties": {
+          "table": {
+            "type": "string",
+            "description": "name of the table\n"
+          },
+          "field": {
+            "type": "string",
+            "description": "the indexed field name\n"
+          }
+        },
+        "required": [
+          "table",
+          "field"
+        ]
+      }
+    }
+  },
+  {
+    "type": "function",
+    "function": {
+      "name": "query_by_field",
+      "description": "records whose indexed field equals a value, a page at a time (returns (records as (key, fields), next cursor; empty when done), None if table or index missing or still being built)\n",
+      "parameters": {
+        "type": "object",
+        "properties": {
+          "table": {
+            "type": "string",
+            "description": "name of the table\n"
+          },
+          "field": {
+            "type": "string",
+            "description": "the indexed field name\n"
+          },
+          "value": {
+            "type": "string",
+            "description": "the value to match\n"
+          },
+          "limit": {
+            "type": "integer",
+            "description": "maximum number of records to return\n"
+          },
+          "cursor": {
+            "type": "string",
+            "description": "empty for the first page, otherwise the cursor returned by the previous page\n"
+          }
+        },
+        "required": [
+          "table",
+          "field",
+          "value",
+          "limit",
+          "cursor"
+        ]
+      }
+    }
+  },
+  {
+    "type": "function",
+    "function": {
+      "name": "create_key_index",
+      "description": "keeps the keys of a table in order so scan_range and scan_prefix can be used on it (returns 200 success, 404 table missing, 409 already ordered)\n",
+      "parameters": {
+        "type": "object",
+        "properties": {
+          "table": {
+            "type": "string",
+            "description": "name of the table\n"
+          }
+        },
+        "required": [
+          "table"
+        ]
+      }
+    }
+  },
+  {
+    "type": "function",
+    "function": {
+      "name": "drop_key_index",
+      "description": "removes the ordered key index of a table (returns 200 success, 404 table or index missing, 409 index still being built)\n",
+      "parameters": {
+        "type": "object",
+        "properties": {
+          "table": {
+            "type": "string",
+            "description": "name of the table\n"
+          }
+        },
+        "required": [
+          "table"
+        ]
+      }
     }
-
-
-        std::string tools() const {
-        return R"JSON(        [
+  },
   {
     "type": "function",
     "function": {
-      "name": "create_table",
-      "description": "creates a table (returns 200 success, 409 already exists, 400 invalid name)\n",
+      "name": "scan_range",
+      "description": "records with keys in [start, end) in key order, with the requested fields (returns list of (key, fields), None if the table has no ordered key index or it is still being built)\n",
       "parameters": {
         "type": "object",
         "properties": {
-          "table_name": {
+          "table": {
             "type": "string",
-            "description": "name of the table to be created\n"
+            "description": "name of the table\n"
+          },
+          "start": {
+            "type": "string",
+            "description": "smallest key to return\n"
+          },
+          "end": {
+            "type": "string",
+            "description": "return keys less than this; empty for no upper bound\n"
+          },
+          "limit": {
+            "type": "integer",
+            "description": "maximum number of records to return\n"
+          },
+          "fields": {
+            "type": "array",
+            "description": "fields to return for each record; empty for keys only\n"
           }
         },
         "required": [
-          "table_name"
+          "table",
+          "start",
+          "end",
+          "limit",
+          "fields"
         ]
       }
     }
@@ -392,18 +2488,33 @@ class in_memory_db_ContractState {
   {
     "type": "function",
     "function": {
-      "name": "drop_table",
-      "description": "drops/deletes a table (returns 200 success, 404 table not found)\n",
+      "name": "scan_prefix",
+      "description": "records whose key starts with a prefix in key order, with the requested fields (returns list of (key, fields), None if the table has no ordered key index or it is still being built)\n",
       "parameters": {
         "type": "object",
         "properties": {
-          "table_name": {
+          "table": {
             "type": "string",
-            "description": "name of the table to be deleted\n"
+            "description": "name of the table\n"
+          },
+          "prefix": {
+            "type": "string",
+            "description": "key prefix to match\n"
+          },
+          "limit": {
+            "type": "integer",
+            "description": "maximum number of records to return\n"
+          },
+          "fields": {
+            "type": "array",
+            "description": "fields to return for each record; empty for keys only\n"
           }
         },
         "required": [
-          "table_name"
+          "table",
+          "prefix",
+          "limit",
+          "fields"
         ]
       }
     }
@@ -411,20 +2522,42 @@ class in_memory_db_ContractState {
   {
     "type": "function",
     "function": {
-      "name": "list_tables",
-      "description": "list all the tables present in db now (returns list of table names, empty if none)\n",
+      "name": "scan",
+      "description": "one page of all records of a table; every record present for the whole scan is returned exactly once, even if records are removed between pages (returns (records as (key, fields), next cursor; empty when done), None if table missing or cursor invalid or expired)\n",
       "parameters": {
         "type": "object",
-        "properties": {},
-        "required": []
+        "properties": {
+          "table": {
+            "type": "string",
+            "description": "name of the table\n"
+          },
+          "cursor": {
+            "type": "string",
+            "description": "empty for the first page, otherwise the cursor returned by the previous page\n"
+          },
+          "limit": {
+            "type": "integer",
+            "description": "maximum number of records to return\n"
+          },
+          "fields": {
+            "type": "array",
+            "description": "fields to return for each record; empty for keys only\n"
+          }
+        },
+        "required": [
+          "table",
+          "cursor",
+          "limit",
+          "fields"
+        ]
       }
     }
   },
   {
     "type": "function",
     "function": {
-      "name": "table_size",
-      "description": "gives size of any table (returns record count, 404 table not found)\n",
+      "name": "truncate_table",
+      "description": "removes every record of a table in constant time, keeping the table, its storage mode and its indexes; the old records are deleted later by reclaim (returns 200 success, 404 table missing)\n",
       "parameters": {
         "type": "object",
         "properties": {
@@ -442,8 +2575,27 @@ class in_memory_db_ContractState {
   {
     "type": "function",
     "function": {
-      "name": "insert",
-      "description": "inserts field-value pair for a given key (returns 200 success, 404 table missing, 400 invalid input)\n",
+      "name": "reclaim",
+      "description": "deletes the stored records of dropped or truncated tables, at most max_records per call, oldest first (returns the number of such records still left; call until it returns 0)\n",
+      "parameters": {
+        "type": "object",
+        "properties": {
+          "max_records": {
+            "type": "integer",
+            "description": "maximum number of records to delete in this call\n"
+          }
+        },
+        "required": [
+          "max_records"
+        ]
+      }
+    }
+  },
+  {
+    "type": "function",
+    "function": {
+      "name": "insert_records_budgeted",
+      "description": "inserts records like insert_records but at most max_ops of them in this call; the rest are kept for resume (returns (200, \"\") when done, (202, token) to pass to resume while work is left, 400 non-positive max_ops, 404 table missing)\n",
       "parameters": {
         "type": "object",
         "properties": {
@@ -451,24 +2603,48 @@ class in_memory_db_ContractState {
             "type": "string",
             "description": "name of the table\n"
           },
-          "key": {
+          "records": {
+            "type": "array",
+            "description": "records as (key, list of (field, value))\n"
+          },
+          "max_ops": {
+            "type": "integer",
+            "description": "maximum number of records to process in this call\n"
+          }
+        },
+        "required": [
+          "table",
+          "records",
+          "max_ops"
+        ]
+      }
+    }
+  },
+  {
+    "type": "function",
+    "function": {
+      "name": "create_index_budgeted",
+      "description": "indexes a field like create_index but backfills at most max_ops records per call; query_by_field answers once the backfill is done (returns (200, \"\") when done, (202, token) to pass to resume while work is left, 400 non-positive max_ops, 404 table missing, 409 already indexed)\n",
+      "parameters": {
+        "type": "object",
+        "properties": {
+          "table": {
             "type": "string",
-            "description": "the key / primary key of the record\n"
+            "description": "name of the table\n"
           },
           "field": {
             "type": "string",
-            "description": "the field name inside the record\n"
+            "description": "field to index\n"
           },
-          "value": {
-            "type": "string",
-            "description": "the value associated with the field\n"
+          "max_ops": {
+            "type": "integer",
+            "description": "maximum number of records to process in this call\n"
           }
         },
         "required": [
           "table",
-          "key",
           "field",
-          "value"
+          "max_ops"
         ]
       }
     }
@@ -476,8 +2652,8 @@ class in_memory_db_ContractState {
   {
     "type": "function",
     "function": {
-      "name": "update",
-      "description": "updates a field value for a given key (returns 200 success, 404 table or record missing)\n",
+      "name": "create_key_index_budgeted",
+      "description": "adds the ordered key index like create_key_index but backfills at most max_ops keys per call; scan_range and scan_prefix answer once the backfill is done (returns (200, \"\") when done, (202, token) to pass to resume while work is left, 400 non-positive max_ops, 404 table missing, 409 already indexed)\n",
       "parameters": {
         "type": "object",
         "properties": {
@@ -485,24 +2661,96 @@ class in_memory_db_ContractState {
             "type": "string",
             "description": "name of the table\n"
           },
-          "key": {
+          "max_ops": {
+            "type": "integer",
+            "description": "maximum number of records to process in this call\n"
+          }
+        },
+        "required": [
+          "table",
+          "max_ops"
+        ]
+      }
+    }
+  },
+  {
+    "type": "function",
+    "function": {
+      "name": "resume",
+      "description": "continues a job returned by one of the *_budgeted methods, processing at most max_ops records (returns (200, \"\") when done, (202, token) to pass to resume while work is left, 400 non-positive max_ops, 404 unknown token or table dropped)\n",
+      "parameters": {
+        "type": "object",
+        "properties": {
+          "token": {
             "type": "string",
-            "description": "the key / primary key of the record\n"
+            "description": "token returned by the previous call\n"
           },
-          "field": {
+          "max_ops": {
+            "type": "integer",
+            "description": "maximum number of records to process in this call\n"
+          }
+        },
+        "required": [
+          "token",
+          "max_ops"
+        ]
+      }
+    }
+  },
+  {
+    "type": "function",
+    "function": {
+      "name": "multi_get",
+      "description": "records for many keys of one table in a single call, each with only the requested fields (all fields if the list is empty); keys without a record are left out (returns list of (key, fields) in the order asked for, None if table missing)\n",
+      "parameters": {
+        "type": "object",
+        "properties": {
+          "table": {
             "type": "string",
-            "description": "the field name to update\n"
+            "description": "name of the table\n"
           },
-          "value": {
+          "keys": {
+            "type": "array",
+            "description": "keys of the records\n"
+          },
+          "fields": {
+            "type": "array",
+            "description": "fields to return for each record; empty for all fields\n"
+          }
+        },
+        "required": [
+          "table",
+          "keys",
+          "fields"
+        ]
+      }
+    }
+  },
+  {
+    "type": "function",
+    "function": {
+      "name": "update_fields",
+      "description": "sets many fields of an existing record at once (returns 200 success, 404 table or record missing)\n",
+      "parameters": {
+        "type": "object",
+        "properties": {
+          "table": {
             "type": "string",
-            "description": "the new value of the field\n"
+            "description": "name of the table\n"
+          },
+          "key": {
+            "type": "string",
+            "description": "key of the record\n"
+          },
+          "fields": {
+            "type": "array",
+            "description": "list of (field, value) to set\n"
           }
         },
         "required": [
           "table",
           "key",
-          "field",
-          "value"
+          "fields"
         ]
       }
     }
@@ -510,8 +2758,56 @@ class in_memory_db_ContractState {
   {
     "type": "function",
     "function": {
-      "name": "get_value",
-      "description": "get a single field value (returns Some(value) if found, None otherwise)\n",
+      "name": "update_records",
+      "description": "sets fields of many existing records at once; records that do not exist are skipped (returns number of records updated)\n",
+      "parameters": {
+        "type": "object",
+        "properties": {
+          "table": {
+            "type": "string",
+            "description": "name of the table\n"
+          },
+          "records": {
+            "type": "array",
+            "description": "records as (key, list of (field, value))\n"
+          }
+        },
+        "required": [
+          "table",
+          "records"
+        ]
+      }
+    }
+  },
+  {
+    "type": "function",
+    "function": {
+      "name": "remove_records",
+      "description": "removes many records at once; keys without a record are skipped (returns number of records removed)\n",
+      "parameters": {
+        "type": "object",
+        "properties": {
+          "table": {
+            "type": "string",
+            "description": "name of the table\n"
+          },
+          "keys": {
+            "type": "array",
+            "description": "keys of the records to remove\n"
+          }
+        },
+        "required": [
+          "table",
+          "keys"
+        ]
+      }
+    }
+  },
+  {
+    "type": "function",
+    "function": {
+      "name": "incr",
+      "description": "adds delta to an integer field in one atomic call; a missing record or field counts as 0 (returns the new value, None if table missing or the field is not an integer)\n",
       "parameters": {
         "type": "object",
         "properties": {
@@ -521,17 +2817,22 @@ class in_memory_db_ContractState {
           },
           "key": {
             "type": "string",
-            "description": "the key / primary key of the record\n"
+            "description": "key of the record\n"
           },
           "field": {
             "type": "string",
-            "description": "the field name whose value is requested\n"
+            "description": "name of the field\n"
+          },
+          "delta": {
+            "type": "integer",
+            "description": "amount to add; may be negative\n"
           }
         },
         "required": [
           "table",
           "key",
-          "field"
+          "field",
+          "delta"
         ]
       }
     }
@@ -539,8 +2840,8 @@ class in_memory_db_ContractState {
   {
     "type": "function",
     "function": {
-      "name": "remove_field",
-      "description": "removes a field from a record (returns 200 success, 404 table or record missing)\n",
+      "name": "append",
+      "description": "appends a value to a field holding a JSON array of strings in one atomic call; a missing record or field counts as an empty array (returns the new length, None if table missing or the field is not an array)\n",
       "parameters": {
         "type": "object",
         "properties": {
@@ -550,17 +2851,22 @@ class in_memory_db_ContractState {
           },
           "key": {
             "type": "string",
-            "description": "the key / primary key of the record\n"
+            "description": "key of the record\n"
           },
           "field": {
             "type": "string",
-            "description": "the field name to be removed\n"
+            "description": "name of the field\n"
+          },
+          "value": {
+            "type": "string",
+            "description": "value to append\n"
           }
         },
         "required": [
           "table",
           "key",
-          "field"
+          "field",
+          "value"
         ]
       }
     }
@@ -568,8 +2874,8 @@ class in_memory_db_ContractState {
   {
     "type": "function",
     "function": {
-      "name": "remove_record",
-      "description": "removes a complete record (returns 200 success, 404 table missing)\n",
+      "name": "get_version",
+      "description": "version of a record, increased by every write to it (returns 0 if the record does not exist, None if table missing)\n",
       "parameters": {
         "type": "object",
         "properties": {
@@ -579,7 +2885,7 @@ class in_memory_db_ContractState {
           },
           "key": {
             "type": "string",
-            "description": "the key / primary key of the record\n"
+            "description": "key of the record\n"
           }
         },
         "required": [
@@ -592,8 +2898,8 @@ class in_memory_db_ContractState {
   {
     "type": "function",
     "function": {
-      "name": "get_fields",
-      "description": "retrieve multiple fields from a record (returns list of existing field-value pairs)\n",
+      "name": "cas",
+      "description": "compare-and-set: sets a field only if the record is still at the expected version, as returned by get_version; expected 0 creates the record (returns (200, new version) success, (409, current version) record changed, (404, 0) table missing, (400, 0) invalid key)\n",
       "parameters": {
         "type": "object",
         "properties": {
@@ -603,17 +2909,27 @@ class in_memory_db_ContractState {
           },
           "key": {
             "type": "string",
-            "description": "the key / primary key of the record\n"
+            "description": "key of the record\n"
           },
-          "fields": {
-            "type": "array",
-            "description": "list of field names to retrieve\n"
+          "field": {
+            "type": "string",
+            "description": "name of the field\n"
+          },
+          "expected": {
+            "type": "integer",
+            "description": "version the record must still have\n"
+          },
+          "new_value": {
+            "type": "string",
+            "description": "value to set\n"
           }
         },
         "required": [
           "table",
           "key",
-          "fields"
+          "field",
+          "expected",
+          "new_value"
         ]
       }
     }
@@ -621,8 +2937,8 @@ class in_memory_db_ContractState {
   {
     "type": "function",
     "function": {
-      "name": "get_all_fields",
-      "description": "retrieve the full record (returns all field-value pairs, empty if record missing)\n",
+      "name": "select_records",
+      "description": "records of a table matching a condition, evaluated inside the contract, with only the requested fields (all if empty) and at most limit of them; where is JSON: {\"eq\": [field, value]} and likewise ne, lt, gt, prefix; {\"in\": [field, [values]]}; {\"and\": [...]} / {\"or\": [...]}; empty matches all (returns list of (key, fields), None if table missing or condition invalid)\n",
       "parameters": {
         "type": "object",
         "properties": {
@@ -630,14 +2946,24 @@ class in_memory_db_ContractState {
             "type": "string",
             "description": "name of the table\n"
           },
-          "key": {
+          "where": {
             "type": "string",
-            "description": "the key / primary key of the record\n"
+            "description": "condition as JSON, empty for all records\n"
+          },
+          "fields": {
+            "type": "array",
+            "description": "fields to return for each record; empty for all fields\n"
+          },
+          "limit": {
+            "type": "integer",
+            "description": "maximum number of records to return\n"
           }
         },
         "required": [
           "table",
-          "key"
+          "where",
+          "fields",
+          "limit"
         ]
       }
     }
@@ -652,18 +2978,42 @@ class in_memory_db_ContractState {
 
 inline void to_json(nlohmann::ordered_json &j, const in_memory_db_ContractState &obj) {
     j = nlohmann::ordered_json::object();
-    // We only expose the list of tables to avoid massive dumps.
-    // NOTE: 'obj' is const, so we can't call non-const helper get_tables_list_internal().
-    // We access the map directly or cast away const (safer to access map directly if public, but map is private).
-    // However, since we are inside a friend function, we can access private members.
-    if (obj.metadata_registry.contains(std::string("__list__"))) {
-        j["tables"] = obj.metadata_registry.get(std::string("__list__"));
+    // Tables are enumerated with list_tables; the state only carries the id
+    // counter and key space bookkeeping so that serializing it costs no host
+    // reads.
+    j["next_table_id"] = obj.next_table_id;
+    if (obj.next_job_id != 1) {
+        j["next_job_id"] = obj.next_job_id;
+    }
+    if (!obj.generations.empty()) {
+        j["generations"] = obj.generations;
+    }
+    if (!obj.retired.empty()) {
+        j["retired"] = obj.retired;
     }
 }
 
 inline void from_json(const nlohmann::ordered_json &j, in_memory_db_ContractState &obj) {
-    if (j.contains("tables") && j["tables"].is_array()) {
-        obj.metadata_registry.insert(std::string("__list__"), j["tables"].get<std::vector<std::string>>());
+    // The instance outlives the invocation, and to_json leaves out fields at
+    // their defaults, so everything the state may omit is reset first.
+    obj.next_table_id = 1;
+    obj.next_job_id = 1;
+    obj.generations.clear();
+    obj.retired.clear();
+    if (j.contains("next_table_id")) {
+        obj.next_table_id = j["next_table_id"].get<uint64_t>();
+    } else if (j.contains("tables") && j["tables"].is_array()) {
+        obj.migrate_legacy(j["tables"].get<std::vector<std::string>>());
+        return;
+    }
+    if (j.contains("next_job_id")) {
+        obj.next_job_id = j["next_job_id"].get<uint64_t>();
+    }
+    if (j.contains("generations")) {
+        j.at("generations").get_to(obj.generations);
+    }
+    if (j.contains("retired")) {
+        j.at("retired").get_to(obj.retired);
     }
 }
 
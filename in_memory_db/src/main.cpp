@@ -8,6 +8,9 @@
 #include "weilsdk/utils.h"
 #include "weilsdk/runtime.h"
 #include "weilsdk/ledger.h"
+#include "weilsdk/arena.h"
+#include "weilsdk/stats.h"
+#include "weilsdk/collections/invocation.hpp"
 #include "contract.hpp"
 
 // Function declarations
@@ -16,6 +19,7 @@ extern "C" void __free(size_t ptr, size_t len) __attribute__((export_name("__fre
 extern "C" void init() __attribute__((export_name("init")));
 extern "C" void method_kind_data() __attribute__((export_name("method_kind_data")));
 extern "C" void create_table() __attribute__((export_name("create_table")));
+extern "C" void create_table_with_storage() __attribute__((export_name("create_table_with_storage")));
 extern "C" void drop_table() __attribute__((export_name("drop_table")));
 extern "C" void list_tables() __attribute__((export_name("list_tables")));
 extern "C" void table_size() __attribute__((export_name("table_size")));
@@ -28,7 +32,31 @@ extern "C" void insert_record() __attribute__((export_name("insert_record")));
 extern "C" void insert_records() __attribute__((export_name("insert_records")));
 extern "C" void get_fields() __attribute__((export_name("get_fields")));
 extern "C" void get_all_fields() __attribute__((export_name("get_all_fields")));
+extern "C" void create_index() __attribute__((export_name("create_index")));
+extern "C" void drop_index() __attribute__((export_name("drop_index")));
+extern "C" void query_by_field() __attribute__((export_name("query_by_field")));
+extern "C" void create_key_index() __attribute__((export_name("create_key_index")));
+extern "C" void drop_key_index() __attribute__((export_name("drop_key_index")));
+extern "C" void scan_range() __attribute__((export_name("scan_range")));
+extern "C" void scan_prefix() __attribute__((export_name("scan_prefix")));
+extern "C" void scan() __attribute__((export_name("scan")));
+extern "C" void truncate_table() __attribute__((export_name("truncate_table")));
+extern "C" void reclaim() __attribute__((export_name("reclaim")));
+extern "C" void insert_records_budgeted() __attribute__((export_name("insert_records_budgeted")));
+extern "C" void create_index_budgeted() __attribute__((export_name("create_index_budgeted")));
+extern "C" void create_key_index_budgeted() __attribute__((export_name("create_key_index_budgeted")));
+extern "C" void resume() __attribute__((export_name("resume")));
+extern "C" void multi_get() __attribute__((export_name("multi_get")));
+extern "C" void update_fields() __attribute__((export_name("update_fields")));
+extern "C" void update_records() __attribute__((export_name("update_records")));
+extern "C" void remove_records() __attribute__((export_name("remove_records")));
+extern "C" void incr() __attribute__((export_name("incr")));
+extern "C" void append() __attribute__((export_name("append")));
+extern "C" void get_version() __attribute__((export_name("get_version")));
+extern "C" void cas() __attribute__((export_name("cas")));
+extern "C" void select_records() __attribute__((export_name("select_records")));
 extern "C" void tools() __attribute__((export_name("tools")));
+extern "C" void __stats() __attribute__((export_name("__stats")));
 
 // Global contract state instance
 in_memory_db_ContractState in_memory_db_instance;
@@ -39,13 +67,13 @@ struct create_table_args {
     std::string table_name;
 
     
-    friend void to_json(nlohmann::ordered_json &j, const create_table_args &obj) {
-        j = nlohmann::ordered_json::object();
+    friend void to_json(weilsdk::scratch_json &j, const create_table_args &obj) {
+        j = weilsdk::scratch_json::object();
 
             j["table_name"] = obj.table_name;
     }
     
-    friend void from_json(const nlohmann::ordered_json &j, create_table_args &obj) {
+    friend void from_json(const weilsdk::scratch_json &j, create_table_args &obj) {
         try {
 
             if (!j.contains("table_name")) {
@@ -57,18 +85,49 @@ struct create_table_args {
         }
     }
     
+};
+struct create_table_with_storage_args {
+    std::string table_name;
+    std::string storage;
+
+    
+    friend void to_json(weilsdk::scratch_json &j, const create_table_with_storage_args &obj) {
+        j = weilsdk::scratch_json::object();
+
+            j["table_name"] = obj.table_name;
+
+            j["storage"] = obj.storage;
+    }
+    
+    friend void from_json(const weilsdk::scratch_json &j, create_table_with_storage_args &obj) {
+        try {
+
+            if (!j.contains("table_name")) {
+                throw std::runtime_error("Missing required field 'table_name'");
+            }
+            j.at("table_name").get_to(obj.table_name);
+
+            if (!j.contains("storage")) {
+                throw std::runtime_error("Missing required field 'storage'");
+            }
+            j.at("storage").get_to(obj.storage);
+        } catch (const std::exception& e) {
+            throw std::runtime_error("Invalid argument format");
+        }
+    }
+    
 };
 struct drop_table_args {
     std::string table_name;
 
     
-    friend void to_json(nlohmann::ordered_json &j, const drop_table_args &obj) {
-        j = nlohmann::ordered_json::object();
+    friend void to_json(weilsdk::scratch_json &j, const drop_table_args &obj) {
+        j = weilsdk::scratch_json::object();
 
             j["table_name"] = obj.table_name;
     }
     
-    friend void from_json(const nlohmann::ordered_json &j, drop_table_args &obj) {
+    friend void from_json(const weilsdk::scratch_json &j, drop_table_args &obj) {
         try {
 
             if (!j.contains("table_name")) {
@@ -85,13 +144,13 @@ struct table_size_args {
     std::string table_name;
 
     
-    friend void to_json(nlohmann::ordered_json &j, const table_size_args &obj) {
-        j = nlohmann::ordered_json::object();
+    friend void to_json(weilsdk::scratch_json &j, const table_size_args &obj) {
+        j = weilsdk::scratch_json::object();
 
             j["table_name"] = obj.table_name;
     }
     
-    friend void from_json(const nlohmann::ordered_json &j, table_size_args &obj) {
+    friend void from_json(const weilsdk::scratch_json &j, table_size_args &obj) {
         try {
 
             if (!j.contains("table_name")) {
@@ -111,8 +170,8 @@ struct insert_args {
     std::string value;
 
     
-    friend void to_json(nlohmann::ordered_json &j, const insert_args &obj) {
-        j = nlohmann::ordered_json::object();
+    friend void to_json(weilsdk::scratch_json &j, const insert_args &obj) {
+        j = weilsdk::scratch_json::object();
 
             j["table"] = obj.table;
 
@@ -123,7 +182,7 @@ struct insert_args {
             j["value"] = obj.value;
     }
     
-    friend void from_json(const nlohmann::ordered_json &j, insert_args &obj) {
+    friend void from_json(const weilsdk::scratch_json &j, insert_args &obj) {
         try {
 
             if (!j.contains("table")) {
@@ -158,8 +217,8 @@ struct update_args {
     std::string value;
 
     
-    friend void to_json(nlohmann::ordered_json &j, const update_args &obj) {
-        j = nlohmann::ordered_json::object();
+    friend void to_json(weilsdk::scratch_json &j, const update_args &obj) {
+        j = weilsdk::scratch_json::object();
 
             j["table"] = obj.table;
 
@@ -170,7 +229,7 @@ struct update_args {
             j["value"] = obj.value;
     }
     
-    friend void from_json(const nlohmann::ordered_json &j, update_args &obj) {
+    friend void from_json(const weilsdk::scratch_json &j, update_args &obj) {
         try {
 
             if (!j.contains("table")) {
@@ -204,8 +263,8 @@ struct get_value_args {
     std::string field;
 
     
-    friend void to_json(nlohmann::ordered_json &j, const get_value_args &obj) {
-        j = nlohmann::ordered_json::object();
+    friend void to_json(weilsdk::scratch_json &j, const get_value_args &obj) {
+        j = weilsdk::scratch_json::object();
 
             j["table"] = obj.table;
 
@@ -214,7 +273,7 @@ struct get_value_args {
             j["field"] = obj.field;
     }
     
-    friend void from_json(const nlohmann::ordered_json &j, get_value_args &obj) {
+    friend void from_json(const weilsdk::scratch_json &j, get_value_args &obj) {
         try {
 
             if (!j.contains("table")) {
@@ -243,8 +302,8 @@ struct remove_field_args {
     std::string field;
 
     
-    friend void to_json(nlohmann::ordered_json &j, const remove_field_args &obj) {
-        j = nlohmann::ordered_json::object();
+    friend void to_json(weilsdk::scratch_json &j, const remove_field_args &obj) {
+        j = weilsdk::scratch_json::object();
 
             j["table"] = obj.table;
 
@@ -253,7 +312,7 @@ struct remove_field_args {
             j["field"] = obj.field;
     }
     
-    friend void from_json(const nlohmann::ordered_json &j, remove_field_args &obj) {
+    friend void from_json(const weilsdk::scratch_json &j, remove_field_args &obj) {
         try {
 
             if (!j.contains("table")) {
@@ -281,15 +340,15 @@ struct remove_record_args {
     std::string key;
 
     
-    friend void to_json(nlohmann::ordered_json &j, const remove_record_args &obj) {
-        j = nlohmann::ordered_json::object();
+    friend void to_json(weilsdk::scratch_json &j, const remove_record_args &obj) {
+        j = weilsdk::scratch_json::object();
 
             j["table"] = obj.table;
 
             j["key"] = obj.key;
     }
     
-    friend void from_json(const nlohmann::ordered_json &j, remove_record_args &obj) {
+    friend void from_json(const weilsdk::scratch_json &j, remove_record_args &obj) {
         try {
 
             if (!j.contains("table")) {
@@ -313,8 +372,8 @@ struct insert_record_args {
     std::vector<std::tuple<std::string, std::string>> fields;
 
     
-    friend void to_json(nlohmann::ordered_json &j, const insert_record_args &obj) {
-        j = nlohmann::ordered_json::object();
+    friend void to_json(weilsdk::scratch_json &j, const insert_record_args &obj) {
+        j = weilsdk::scratch_json::object();
 
             j["table"] = obj.table;
 
@@ -323,7 +382,7 @@ struct insert_record_args {
             j["fields"] = obj.fields;
     }
     
-    friend void from_json(const nlohmann::ordered_json &j, insert_record_args &obj) {
+    friend void from_json(const weilsdk::scratch_json &j, insert_record_args &obj) {
         try {
 
             if (!j.contains("table")) {
@@ -351,15 +410,15 @@ struct insert_records_args {
     std::vector<std::tuple<std::string, std::vector<std::tuple<std::string, std::string>>>> records;
 
     
-    friend void to_json(nlohmann::ordered_json &j, const insert_records_args &obj) {
-        j = nlohmann::ordered_json::object();
+    friend void to_json(weilsdk::scratch_json &j, const insert_records_args &obj) {
+        j = weilsdk::scratch_json::object();
 
             j["table"] = obj.table;
 
             j["records"] = obj.records;
     }
     
-    friend void from_json(const nlohmann::ordered_json &j, insert_records_args &obj) {
+    friend void from_json(const weilsdk::scratch_json &j, insert_records_args &obj) {
         try {
 
             if (!j.contains("table")) {
@@ -383,8 +442,8 @@ struct get_fields_args {
     std::vector<std::string> fields;
 
     
-    friend void to_json(nlohmann::ordered_json &j, const get_fields_args &obj) {
-        j = nlohmann::ordered_json::object();
+    friend void to_json(weilsdk::scratch_json &j, const get_fields_args &obj) {
+        j = weilsdk::scratch_json::object();
 
             j["table"] = obj.table;
 
@@ -393,7 +452,7 @@ struct get_fields_args {
             j["fields"] = obj.fields;
     }
     
-    friend void from_json(const nlohmann::ordered_json &j, get_fields_args &obj) {
+    friend void from_json(const weilsdk::scratch_json &j, get_fields_args &obj) {
         try {
 
             if (!j.contains("table")) {
@@ -421,15 +480,15 @@ struct get_all_fields_args {
     std::string key;
 
     
-    friend void to_json(nlohmann::ordered_json &j, const get_all_fields_args &obj) {
-        j = nlohmann::ordered_json::object();
+    friend void to_json(weilsdk::scratch_json &j, const get_all_fields_args &obj) {
+        j = weilsdk::scratch_json::object();
 
             j["table"] = obj.table;
 
             j["key"] = obj.key;
     }
     
-    friend void from_json(const nlohmann::ordered_json &j, get_all_fields_args &obj) {
+    friend void from_json(const weilsdk::scratch_json &j, get_all_fields_args &obj) {
         try {
 
             if (!j.contains("table")) {
@@ -447,397 +506,2047 @@ struct get_all_fields_args {
     }
     
 };
-extern "C" {
+struct create_index_args {
+    std::string table;
+    std::string field;
 
-    int __new(size_t len, unsigned char _id) {
-        void *ptr = weilsdk::Runtime::allocate(len);
-        return reinterpret_cast<int>(ptr);
-    }
     
-    void __free(size_t ptr, size_t len) {
-        weilsdk::Runtime::deallocate(ptr, len);
+    friend void to_json(weilsdk::scratch_json &j, const create_index_args &obj) {
+        j = weilsdk::scratch_json::object();
+
+            j["table"] = obj.table;
+
+            j["field"] = obj.field;
     }
     
-    
-    // Initialize contract state
-    void init() {
-        in_memory_db_ContractState new_instance;
-        // TODO: Initialize contract state as needed
-    
-        nlohmann::ordered_json j = new_instance;
-        weilsdk::WeilValue wv;
-        wv.new_with_state_and_ok_value(j.dump(), "null");
-        weilsdk::Runtime::setStateAndResult(std::variant<weilsdk::WeilValue,std::string> {wv});
+    friend void from_json(const weilsdk::scratch_json &j, create_index_args &obj) {
+        try {
+
+            if (!j.contains("table")) {
+                throw std::runtime_error("Missing required field 'table'");
+            }
+            j.at("table").get_to(obj.table);
+
+            if (!j.contains("field")) {
+                throw std::runtime_error("Missing required field 'field'");
+            }
+            j.at("field").get_to(obj.field);
+        } catch (const std::exception& e) {
+            throw std::runtime_error("Invalid argument format");
+        }
     }
     
+};
+struct drop_index_args {
+    std::string table;
+    std::string field;
+
     
-    // Method kind data collection
-    void method_kind_data() {
-        std::map<std::string, std::string> method_kind_mapping;
-        
-        
-        method_kind_mapping["create_table"] = "mutate";    
-        method_kind_mapping["drop_table"] = "mutate";    
-        method_kind_mapping["list_tables"] = "query";    
-        method_kind_mapping["table_size"] = "query";    
-        method_kind_mapping["insert"] = "mutate";    
-        method_kind_mapping["update"] = "mutate";    
-        method_kind_mapping["get_value"] = "query";    
-        method_kind_mapping["remove_field"] = "mutate";    
-        method_kind_mapping["remove_record"] = "mutate";    
-        method_kind_mapping["insert_record"] = "mutate";    
-        method_kind_mapping["insert_records"] = "mutate";    
-        method_kind_mapping["get_fields"] = "query";    
-        method_kind_mapping["get_all_fields"] = "query";
-        method_kind_mapping["tools"] = "query";
-        nlohmann::ordered_json json_object = method_kind_mapping;
-        std::string serialized_string = json_object.dump();
-        weilsdk::Runtime::setResult(serialized_string, 0);
+    friend void to_json(weilsdk::scratch_json &j, const drop_index_args &obj) {
+        j = weilsdk::scratch_json::object();
+
+            j["table"] = obj.table;
+
+            j["field"] = obj.field;
     }
     
-    
-    void create_table() {
-        std::pair<std::string, std::string> p = weilsdk::Runtime::stateAndArgs();
-        std::string raw_args = p.second;
-        nlohmann::ordered_json j = nlohmann::ordered_json::parse(raw_args);
-        
-        if (j.is_discarded() || !j.contains("table_name")) {
-            weilsdk::MethodError me = weilsdk::MethodError("create_table", "invalid_args");
-            weilsdk::Runtime::setResult(weilsdk::WeilError::MethodArgumentDeserializationError(me), 1);
-            return;
-        }
-        
-        create_table_args args;
-        args = j.get<create_table_args>();
-        
-        std::string stateString = p.first;
-        nlohmann::ordered_json j1 = nlohmann::ordered_json::parse(stateString);
-        
-        from_json(j1, in_memory_db_instance);
-        
-        int32_t result = in_memory_db_instance.create_table(args.table_name);
-        nlohmann::ordered_json j2 = in_memory_db_instance;
-        weilsdk::WeilValue wv;
-        nlohmann::ordered_json j_result = result;
-        wv.new_with_state_and_ok_value(j2.dump(), j_result.dump());
-        weilsdk::Runtime::setStateAndResult(std::variant<weilsdk::WeilValue,std::string> {wv});
-    }
+    friend void from_json(const weilsdk::scratch_json &j, drop_index_args &obj) {
+        try {
 
+            if (!j.contains("table")) {
+                throw std::runtime_error("Missing required field 'table'");
+            }
+            j.at("table").get_to(obj.table);
 
-    void drop_table() {
-        std::pair<std::string, std::string> p = weilsdk::Runtime::stateAndArgs();
-        std::string raw_args = p.second;
-        nlohmann::ordered_json j = nlohmann::ordered_json::parse(raw_args);
-        
-        if (j.is_discarded() || !j.contains("table_name")) {
-            weilsdk::MethodError me = weilsdk::MethodError("drop_table", "invalid_args");
-            weilsdk::Runtime::setResult(weilsdk::WeilError::MethodArgumentDeserializationError(me), 1);
-            return;
+            if (!j.contains("field")) {
+                throw std::runtime_error("Missing required field 'field'");
+            }
+            j.at("field").get_to(obj.field);
+        } catch (const std::exception& e) {
+            throw std::runtime_error("Invalid argument format");
         }
-        
-        drop_table_args args;
-        args = j.get<drop_table_args>();
-        
-        std::string stateString = p.first;
-        nlohmann::ordered_json j1 = nlohmann::ordered_json::parse(stateString);
-        
-        from_json(j1, in_memory_db_instance);
-        
-        int32_t result = in_memory_db_instance.drop_table(args.table_name);
-        nlohmann::ordered_json j2 = in_memory_db_instance;
-        weilsdk::WeilValue wv;
-        nlohmann::ordered_json j_result = result;
-        wv.new_with_state_and_ok_value(j2.dump(), j_result.dump());
-        weilsdk::Runtime::setStateAndResult(std::variant<weilsdk::WeilValue,std::string> {wv});
     }
+    
+};
+struct query_by_field_args {
+    std::string table;
+    std::string field;
+    std::string value;
+    int32_t limit;
+    std::string cursor;
 
-
-    void list_tables() {    std::string stateString = weilsdk::Runtime::state();
     
-        nlohmann::ordered_json j1 = nlohmann::ordered_json::parse(stateString);
-        from_json(j1, in_memory_db_instance);
-        
-        std::vector<std::string> result = in_memory_db_instance.list_tables();
-        nlohmann::ordered_json j_result = result;
-        weilsdk::Runtime::setResult(j_result.dump(), 0);
-    }
+    friend void to_json(weilsdk::scratch_json &j, const query_by_field_args &obj) {
+        j = weilsdk::scratch_json::object();
 
+            j["table"] = obj.table;
 
-    void table_size() {
-            std::pair<std::string, std::string> p = weilsdk::Runtime::stateAndArgs();
-            std::string raw_args = p.second;
-            nlohmann::ordered_json j = nlohmann::ordered_json::parse(raw_args);
-        
-            if (j.is_discarded() || !j.contains("table_name")) {
-            weilsdk::MethodError me = weilsdk::MethodError("table_size", "invalid_args");
-            weilsdk::Runtime::setResult(weilsdk::WeilError::MethodArgumentDeserializationError(me), 1);
-            return;
-        }
-        
-        table_size_args args;
-        args = j.get<table_size_args>();
-        
-        std::string stateString = p.first;
-    
-        nlohmann::ordered_json j1 = nlohmann::ordered_json::parse(stateString);
-        from_json(j1, in_memory_db_instance);
-        
-        int32_t result = in_memory_db_instance.table_size(args.table_name);
-        nlohmann::ordered_json j_result = result;
-        weilsdk::Runtime::setResult(j_result.dump(), 0);
+            j["field"] = obj.field;
+
+            j["value"] = obj.value;
+
+            j["limit"] = obj.limit;
+
+            j["cursor"] = obj.cursor;
     }
+    
+    friend void from_json(const weilsdk::scratch_json &j, query_by_field_args &obj) {
+        try {
+
+            if (!j.contains("table")) {
+                throw std::runtime_error("Missing required field 'table'");
+            }
+            j.at("table").get_to(obj.table);
 
+            if (!j.contains("field")) {
+                throw std::runtime_error("Missing required field 'field'");
+            }
+            j.at("field").get_to(obj.field);
 
-    void insert() {
-        std::pair<std::string, std::string> p = weilsdk::Runtime::stateAndArgs();
-        std::string raw_args = p.second;
-        nlohmann::ordered_json j = nlohmann::ordered_json::parse(raw_args);
-        
-        if (j.is_discarded() || !j.contains("table") || !j.contains("key") || !j.contains("field") || !j.contains("value")) {
-            weilsdk::MethodError me = weilsdk::MethodError("insert", "invalid_args");
-            weilsdk::Runtime::setResult(weilsdk::WeilError::MethodArgumentDeserializationError(me), 1);
-            return;
+            if (!j.contains("value")) {
+                throw std::runtime_error("Missing required field 'value'");
+            }
+            j.at("value").get_to(obj.value);
+
+            if (!j.contains("limit")) {
+                throw std::runtime_error("Missing required field 'limit'");
+            }
+            j.at("limit").get_to(obj.limit);
+
+            if (!j.contains("cursor")) {
+                throw std::runtime_error("Missing required field 'cursor'");
+            }
+            j.at("cursor").get_to(obj.cursor);
+        } catch (const std::exception& e) {
+            throw std::runtime_error("Invalid argument format");
         }
-        
-        insert_args args;
-        args = j.get<insert_args>();
-        
-        std::string stateString = p.first;
-        nlohmann::ordered_json j1 = nlohmann::ordered_json::parse(stateString);
-        
-        from_json(j1, in_memory_db_instance);
-        
-        int32_t result = in_memory_db_instance.insert(args.table, args.key, args.field, args.value);
-        nlohmann::ordered_json j2 = in_memory_db_instance;
-        weilsdk::WeilValue wv;
-        nlohmann::ordered_json j_result = result;
-        wv.new_with_state_and_ok_value(j2.dump(), j_result.dump());
-        weilsdk::Runtime::setStateAndResult(std::variant<weilsdk::WeilValue,std::string> {wv});
     }
+    
+};
+struct create_key_index_args {
+    std::string table;
 
+    
+    friend void to_json(weilsdk::scratch_json &j, const create_key_index_args &obj) {
+        j = weilsdk::scratch_json::object();
 
-    void update() {
-        std::pair<std::string, std::string> p = weilsdk::Runtime::stateAndArgs();
-        std::string raw_args = p.second;
-        nlohmann::ordered_json j = nlohmann::ordered_json::parse(raw_args);
-        
-        if (j.is_discarded() || !j.contains("table") || !j.contains("key") || !j.contains("field") || !j.contains("value")) {
-            weilsdk::MethodError me = weilsdk::MethodError("update", "invalid_args");
-            weilsdk::Runtime::setResult(weilsdk::WeilError::MethodArgumentDeserializationError(me), 1);
-            return;
+            j["table"] = obj.table;
+    }
+    
+    friend void from_json(const weilsdk::scratch_json &j, create_key_index_args &obj) {
+        try {
+
+            if (!j.contains("table")) {
+                throw std::runtime_error("Missing required field 'table'");
+            }
+            j.at("table").get_to(obj.table);
+        } catch (const std::exception& e) {
+            throw std::runtime_error("Invalid argument format");
         }
-        
-        update_args args;
-        args = j.get<update_args>();
-        
-        std::string stateString = p.first;
-        nlohmann::ordered_json j1 = nlohmann::ordered_json::parse(stateString);
-        
-        from_json(j1, in_memory_db_instance);
-        
-        int32_t result = in_memory_db_instance.update(args.table, args.key, args.field, args.value);
-        nlohmann::ordered_json j2 = in_memory_db_instance;
-        weilsdk::WeilValue wv;
-        nlohmann::ordered_json j_result = result;
-        wv.new_with_state_and_ok_value(j2.dump(), j_result.dump());
-        weilsdk::Runtime::setStateAndResult(std::variant<weilsdk::WeilValue,std::string> {wv});
     }
+    
+};
+struct drop_key_index_args {
+    std::string table;
 
+    
+    friend void to_json(weilsdk::scratch_json &j, const drop_key_index_args &obj) {
+        j = weilsdk::scratch_json::object();
 
-    void get_value() {
-            std::pair<std::string, std::string> p = weilsdk::Runtime::stateAndArgs();
-            std::string raw_args = p.second;
-            nlohmann::ordered_json j = nlohmann::ordered_json::parse(raw_args);
-        
-            if (j.is_discarded() || !j.contains("table") || !j.contains("key") || !j.contains("field")) {
-            weilsdk::MethodError me = weilsdk::MethodError("get_value", "invalid_args");
-            weilsdk::Runtime::setResult(weilsdk::WeilError::MethodArgumentDeserializationError(me), 1);
-            return;
-        }
-        
-        get_value_args args;
-        args = j.get<get_value_args>();
-        
-        std::string stateString = p.first;
+            j["table"] = obj.table;
+    }
     
-        nlohmann::ordered_json j1 = nlohmann::ordered_json::parse(stateString);
-        from_json(j1, in_memory_db_instance);
-        
-        std::optional<std::string> result = in_memory_db_instance.get_value(args.table, args.key, args.field);
-        if (result.has_value()) {
-            nlohmann::ordered_json j_result = result.value();
-            weilsdk::Runtime::setResult(j_result.dump(), 0);
-        } else {
-            weilsdk::Runtime::setResult("null", 0);
+    friend void from_json(const weilsdk::scratch_json &j, drop_key_index_args &obj) {
+        try {
+
+            if (!j.contains("table")) {
+                throw std::runtime_error("Missing required field 'table'");
+            }
+            j.at("table").get_to(obj.table);
+        } catch (const std::exception& e) {
+            throw std::runtime_error("Invalid argument format");
+        }
+    }
+    
+};
+struct scan_range_args {
+    std::string table;
+    std::string start;
+    std::string end;
+    int32_t limit;
+    std::vector<std::string> fields;
+
+    
+    friend void to_json(weilsdk::scratch_json &j, const scan_range_args &obj) {
+        j = weilsdk::scratch_json::object();
+
+            j["table"] = obj.table;
+
+            j["start"] = obj.start;
+
+            j["end"] = obj.end;
+
+            j["limit"] = obj.limit;
+
+            j["fields"] = obj.fields;
+    }
+    
+    friend void from_json(const weilsdk::scratch_json &j, scan_range_args &obj) {
+        try {
+
+            if (!j.contains("table")) {
+                throw std::runtime_error("Missing required field 'table'");
+            }
+            j.at("table").get_to(obj.table);
+
+            if (!j.contains("start")) {
+                throw std::runtime_error("Missing required field 'start'");
+            }
+            j.at("start").get_to(obj.start);
+
+            if (!j.contains("end")) {
+                throw std::runtime_error("Missing required field 'end'");
+            }
+            j.at("end").get_to(obj.end);
+
+            if (!j.contains("limit")) {
+                throw std::runtime_error("Missing required field 'limit'");
+            }
+            j.at("limit").get_to(obj.limit);
+
+            if (!j.contains("fields")) {
+                throw std::runtime_error("Missing required field 'fields'");
+            }
+            j.at("fields").get_to(obj.fields);
+        } catch (const std::exception& e) {
+            throw std::runtime_error("Invalid argument format");
+        }
+    }
+    
+};
+struct scan_prefix_args {
+    std::string table;
+    std::string prefix;
+    int32_t limit;
+    std::vector<std::string> fields;
+
+    
+    friend void to_json(weilsdk::scratch_json &j, const scan_prefix_args &obj) {
+        j = weilsdk::scratch_json::object();
+
+            j["table"] = obj.table;
+
+            j["prefix"] = obj.prefix;
+
+            j["limit"] = obj.limit;
+
+            j["fields"] = obj.fields;
+    }
+    
+    friend void from_json(const weilsdk::scratch_json &j, scan_prefix_args &obj) {
+        try {
+
+            if (!j.contains("table")) {
+                throw std::runtime_error("Missing required field 'table'");
+            }
+            j.at("table").get_to(obj.table);
+
+            if (!j.contains("prefix")) {
+                throw std::runtime_error("Missing required field 'prefix'");
+            }
+            j.at("prefix").get_to(obj.prefix);
+
+            if (!j.contains("limit")) {
+                throw std::runtime_error("Missing required field 'limit'");
+            }
+            j.at("limit").get_to(obj.limit);
+
+            if (!j.contains("fields")) {
+                throw std::runtime_error("Missing required field 'fields'");
+            }
+            j.at("fields").get_to(obj.fields);
+        } catch (const std::exception& e) {
+            throw std::runtime_error("Invalid argument format");
+        }
+    }
+    
+};
+struct scan_args {
+    std::string table;
+    std::string cursor;
+    int32_t limit;
+    std::vector<std::string> fields;
+
+    
+    friend void to_json(weilsdk::scratch_json &j, const scan_args &obj) {
+        j = weilsdk::scratch_json::object();
+
+            j["table"] = obj.table;
+
+            j["cursor"] = obj.cursor;
+
+            j["limit"] = obj.limit;
+
+            j["fields"] = obj.fields;
+    }
+    
+    friend void from_json(const weilsdk::scratch_json &j, scan_args &obj) {
+        try {
+
+            if (!j.contains("table")) {
+                throw std::runtime_error("Missing required field 'table'");
+            }
+            j.at("table").get_to(obj.table);
+
+            if (!j.contains("cursor")) {
+                throw std::runtime_error("Missing required field 'cursor'");
+            }
+            j.at("cursor").get_to(obj.cursor);
+
+            if (!j.contains("limit")) {
+                throw std::runtime_error("Missing required field 'limit'");
+            }
+            j.at("limit").get_to(obj.limit);
+
+            if (!j.contains("fields")) {
+                throw std::runtime_error("Missing required field 'fields'");
+            }
+            j.at("fields").get_to(obj.fields);
+        } catch (const std::exception& e) {
+            throw std::runtime_error("Invalid argument format");
+        }
+    }
+    
+};
+struct truncate_table_args {
+    std::string table_name;
+
+    
+    friend void to_json(weilsdk::scratch_json &j, const truncate_table_args &obj) {
+        j = weilsdk::scratch_json::object();
+
+            j["table_name"] = obj.table_name;
+    }
+    
+    friend void from_json(const weilsdk::scratch_json &j, truncate_table_args &obj) {
+        try {
+
+            if (!j.contains("table_name")) {
+                throw std::runtime_error("Missing required field 'table_name'");
+            }
+            j.at("table_name").get_to(obj.table_name);
+        } catch (const std::exception& e) {
+            throw std::runtime_error("Invalid argument format");
+        }
+    }
+    
+};
+struct reclaim_args {
+    int32_t max_records;
+
+    
+    friend void to_json(weilsdk::scratch_json &j, const reclaim_args &obj) {
+        j = weilsdk::scratch_json::object();
+
+            j["max_records"] = obj.max_records;
+    }
+    
+    friend void from_json(const weilsdk::scratch_json &j, reclaim_args &obj) {
+        try {
+
+            if (!j.contains("max_records")) {
+                throw std::runtime_error("Missing required field 'max_records'");
+            }
+            j.at("max_records").get_to(obj.max_records);
+        } catch (const std::exception& e) {
+            throw std::runtime_error("Invalid argument format");
+        }
+    }
+    
+};
+struct insert_records_budgeted_args {
+    std::string table;
+    std::vector<std::tuple<std::string, std::vector<std::tuple<std::string, std::string>>>> records;
+    int32_t max_ops;
+
+    
+    friend void to_json(weilsdk::scratch_json &j, const insert_records_budgeted_args &obj) {
+        j = weilsdk::scratch_json::object();
+
+            j["table"] = obj.table;
+
+            j["records"] = obj.records;
+
+            j["max_ops"] = obj.max_ops;
+    }
+    
+    friend void from_json(const weilsdk::scratch_json &j, insert_records_budgeted_args &obj) {
+        try {
+
+            if (!j.contains("table")) {
+                throw std::runtime_error("Missing required field 'table'");
+            }
+            j.at("table").get_to(obj.table);
+
+            if (!j.contains("records")) {
+                throw std::runtime_error("Missing required field 'records'");
+            }
+            j.at("records").get_to(obj.records);
+
+            if (!j.contains("max_ops")) {
+                throw std::runtime_error("Missing required field 'max_ops'");
+            }
+            j.at("max_ops").get_to(obj.max_ops);
+        } catch (const std::exception& e) {
+            throw std::runtime_error("Invalid argument format");
+        }
+    }
+    
+};
+struct create_index_budgeted_args {
+    std::string table;
+    std::string field;
+    int32_t max_ops;
+
+    
+    friend void to_json(weilsdk::scratch_json &j, const create_index_budgeted_args &obj) {
+        j = weilsdk::scratch_json::object();
+
+            j["table"] = obj.table;
+
+            j["field"] = obj.field;
+
+            j["max_ops"] = obj.max_ops;
+    }
+    
+    friend void from_json(const weilsdk::scratch_json &j, create_index_budgeted_args &obj) {
+        try {
+
+            if (!j.contains("table")) {
+                throw std::runtime_error("Missing required field 'table'");
+            }
+            j.at("table").get_to(obj.table);
+
+            if (!j.contains("field")) {
+                throw std::runtime_error("Missing required field 'field'");
+            }
+            j.at("field").get_to(obj.field);
+
+            if (!j.contains("max_ops")) {
+                throw std::runtime_error("Missing required field 'max_ops'");
+            }
+            j.at("max_ops").get_to(obj.max_ops);
+        } catch (const std::exception& e) {
+            throw std::runtime_error("Invalid argument format");
+        }
+    }
+    
+};
+struct create_key_index_budgeted_args {
+    std::string table;
+    int32_t max_ops;
+
+    
+    friend void to_json(weilsdk::scratch_json &j, const create_key_index_budgeted_args &obj) {
+        j = weilsdk::scratch_json::object();
+
+            j["table"] = obj.table;
+
+            j["max_ops"] = obj.max_ops;
+    }
+    
+    friend void from_json(const weilsdk::scratch_json &j, create_key_index_budgeted_args &obj) {
+        try {
+
+            if (!j.contains("table")) {
+                throw std::runtime_error("Missing required field 'table'");
+            }
+            j.at("table").get_to(obj.table);
+
+            if (!j.contains("max_ops")) {
+                throw std::runtime_error("Missing required field 'max_ops'");
+            }
+            j.at("max_ops").get_to(obj.max_ops);
+        } catch (const std::exception& e) {
+            throw std::runtime_error("Invalid argument format");
+        }
+    }
+    
+};
+struct resume_args {
+    std::string token;
+    int32_t max_ops;
+
+    
+    friend void to_json(weilsdk::scratch_json &j, const resume_args &obj) {
+        j = weilsdk::scratch_json::object();
+
+            j["token"] = obj.token;
+
+            j["max_ops"] = obj.max_ops;
+    }
+    
+    friend void from_json(const weilsdk::scratch_json &j, resume_args &obj) {
+        try {
+
+            if (!j.contains("token")) {
+                throw std::runtime_error("Missing required field 'token'");
+            }
+            j.at("token").get_to(obj.token);
+
+            if (!j.contains("max_ops")) {
+                throw std::runtime_error("Missing required field 'max_ops'");
+            }
+            j.at("max_ops").get_to(obj.max_ops);
+        } catch (const std::exception& e) {
+            throw std::runtime_error("Invalid argument format");
+        }
+    }
+    
+};
+struct multi_get_args {
+    std::string table;
+    std::vector<std::string> keys;
+    std::vector<std::string> fields;
+
+    
+    friend void to_json(weilsdk::scratch_json &j, const multi_get_args &obj) {
+        j = weilsdk::scratch_json::object();
+
+            j["table"] = obj.table;
+
+            j["keys"] = obj.keys;
+
+            j["fields"] = obj.fields;
+    }
+    
+    friend void from_json(const weilsdk::scratch_json &j, multi_get_args &obj) {
+        try {
+
+            if (!j.contains("table")) {
+                throw std::runtime_error("Missing required field 'table'");
+            }
+            j.at("table").get_to(obj.table);
+
+            if (!j.contains("keys")) {
+                throw std::runtime_error("Missing required field 'keys'");
+            }
+            j.at("keys").get_to(obj.keys);
+
+            if (!j.contains("fields")) {
+                throw std::runtime_error("Missing required field 'fields'");
+            }
+            j.at("fields").get_to(obj.fields);
+        } catch (const std::exception& e) {
+            throw std::runtime_error("Invalid argument format");
+        }
+    }
+    
+};
+struct update_fields_args {
+    std::string table;
+    std::string key;
+    std::vector<std::tuple<std::string, std::string>> fields;
+
+    
+    friend void to_json(weilsdk::scratch_json &j, const update_fields_args &obj) {
+        j = weilsdk::scratch_json::object();
+
+            j["table"] = obj.table;
+
+            j["key"] = obj.key;
+
+            j["fields"] = obj.fields;
+    }
+    
+    friend void from_json(const weilsdk::scratch_json &j, update_fields_args &obj) {
+        try {
+
+            if (!j.contains("table")) {
+                throw std::runtime_error("Missing required field 'table'");
+            }
+            j.at("table").get_to(obj.table);
+
+            if (!j.contains("key")) {
+                throw std::runtime_error("Missing required field 'key'");
+            }
+            j.at("key").get_to(obj.key);
+
+            if (!j.contains("fields")) {
+                throw std::runtime_error("Missing required field 'fields'");
+            }
+            j.at("fields").get_to(obj.fields);
+        } catch (const std::exception& e) {
+            throw std::runtime_error("Invalid argument format");
+        }
+    }
+    
+};
+struct update_records_args {
+    std::string table;
+    std::vector<std::tuple<std::string, std::vector<std::tuple<std::string, std::string>>>> records;
+
+    
+    friend void to_json(weilsdk::scratch_json &j, const update_records_args &obj) {
+        j = weilsdk::scratch_json::object();
+
+            j["table"] = obj.table;
+
+            j["records"] = obj.records;
+    }
+    
+    friend void from_json(const weilsdk::scratch_json &j, update_records_args &obj) {
+        try {
+
+            if (!j.contains("table")) {
+                throw std::runtime_error("Missing required field 'table'");
+            }
+            j.at("table").get_to(obj.table);
+
+            if (!j.contains("records")) {
+                throw std::runtime_error("Missing required field 'records'");
+            }
+            j.at("records").get_to(obj.records);
+        } catch (const std::exception& e) {
+            throw std::runtime_error("Invalid argument format");
+        }
+    }
+    
+};
+struct remove_records_args {
+    std::string table;
+    std::vector<std::string> keys;
+
+    
+    friend void to_json(weilsdk::scratch_json &j, const remove_records_args &obj) {
+        j = weilsdk::scratch_json::object();
+
+            j["table"] = obj.table;
+
+            j["keys"] = obj.keys;
+    }
+    
+    friend void from_json(const weilsdk::scratch_json &j, remove_records_args &obj) {
+        try {
+
+            if (!j.contains("table")) {
+                throw std::runtime_error("Missing required field 'table'");
+            }
+            j.at("table").get_to(obj.table);
+
+            if (!j.contains("keys")) {
+                throw std::runtime_error("Missing required field 'keys'");
+            }
+            j.at("keys").get_to(obj.keys);
+        } catch (const std::exception& e) {
+            throw std::runtime_error("Invalid argument format");
+        }
+    }
+    
+};
+struct incr_args {
+    std::string table;
+    std::string key;
+    std::string field;
+    int32_t delta;
+
+    
+    friend void to_json(weilsdk::scratch_json &j, const incr_args &obj) {
+        j = weilsdk::scratch_json::object();
+
+            j["table"] = obj.table;
+
+            j["key"] = obj.key;
+
+            j["field"] = obj.field;
+
+            j["delta"] = obj.delta;
+    }
+    
+    friend void from_json(const weilsdk::scratch_json &j, incr_args &obj) {
+        try {
+
+            if (!j.contains("table")) {
+                throw std::runtime_error("Missing required field 'table'");
+            }
+            j.at("table").get_to(obj.table);
+
+            if (!j.contains("key")) {
+                throw std::runtime_error("Missing required field 'key'");
+            }
+            j.at("key").get_to(obj.key);
+
+            if (!j.contains("field")) {
+                throw std::runtime_error("Missing required field 'field'");
+            }
+            j.at("field").get_to(obj.field);
+
+            if (!j.contains("delta")) {
+                throw std::runtime_error("Missing required field 'delta'");
+            }
+            j.at("delta").get_to(obj.delta);
+        } catch (const std::exception& e) {
+            throw std::runtime_error("Invalid argument format");
+        }
+    }
+    
+};
+struct append_args {
+    std::string table;
+    std::string key;
+    std::string field;
+    std::string value;
+
+    
+    friend void to_json(weilsdk::scratch_json &j, const append_args &obj) {
+        j = weilsdk::scratch_json::object();
+
+            j["table"] = obj.table;
+
+            j["key"] = obj.key;
+
+            j["field"] = obj.field;
+
+            j["value"] = obj.value;
+    }
+    
+    friend void from_json(const weilsdk::scratch_json &j, append_args &obj) {
+        try {
+
+            if (!j.contains("table")) {
+                throw std::runtime_error("Missing required field 'table'");
+            }
+            j.at("table").get_to(obj.table);
+
+            if (!j.contains("key")) {
+                throw std::runtime_error("Missing required field 'key'");
+            }
+            j.at("key").get_to(obj.key);
+
+            if (!j.contains("field")) {
+                throw std::runtime_error("Missing required field 'field'");
+            }
+            j.at("field").get_to(obj.field);
+
+            if (!j.contains("value")) {
+                throw std::runtime_error("Missing required field 'value'");
+            }
+            j.at("value").get_to(obj.value);
+        } catch (const std::exception& e) {
+            throw std::runtime_error("Invalid argument format");
+        }
+    }
+    
+};
+struct get_version_args {
+    std::string table;
+    std::string key;
+
+    
+    friend void to_json(weilsdk::scratch_json &j, const get_version_args &obj) {
+        j = weilsdk::scratch_json::object();
+
+            j["table"] = obj.table;
+
+            j["key"] = obj.key;
+    }
+    
+    friend void from_json(const weilsdk::scratch_json &j, get_version_args &obj) {
+        try {
+
+            if (!j.contains("table")) {
+                throw std::runtime_error("Missing required field 'table'");
+            }
+            j.at("table").get_to(obj.table);
+
+            if (!j.contains("key")) {
+                throw std::runtime_error("Missing required field 'key'");
+            }
+            j.at("key").get_to(obj.key);
+        } catch (const std::exception& e) {
+            throw std::runtime_error("Invalid argument format");
+        }
+    }
+    
+};
+struct cas_args {
+    std::string table;
+    std::string key;
+    std::string field;
+    uint64_t expected;
+    std::string new_value;
+
+    
+    friend void to_json(weilsdk::scratch_json &j, const cas_args &obj) {
+        j = weilsdk::scratch_json::object();
+
+            j["table"] = obj.table;
+
+            j["key"] = obj.key;
+
+            j["field"] = obj.field;
+
+            j["expected"] = obj.expected;
+
+            j["new_value"] = obj.new_value;
+    }
+    
+    friend void from_json(const weilsdk::scratch_json &j, cas_args &obj) {
+        try {
+
+            if (!j.contains("table")) {
+                throw std::runtime_error("Missing required field 'table'");
+            }
+            j.at("table").get_to(obj.table);
+
+            if (!j.contains("key")) {
+                throw std::runtime_error("Missing required field 'key'");
+            }
+            j.at("key").get_to(obj.key);
+
+            if (!j.contains("field")) {
+                throw std::runtime_error("Missing required field 'field'");
+            }
+            j.at("field").get_to(obj.field);
+
+            if (!j.contains("expected")) {
+                throw std::runtime_error("Missing required field 'expected'");
+            }
+            j.at("expected").get_to(obj.expected);
+
+            if (!j.contains("new_value")) {
+                throw std::runtime_error("Missing required field 'new_value'");
+            }
+            j.at("new_value").get_to(obj.new_value);
+        } catch (const std::exception& e) {
+            throw std::runtime_error("Invalid argument format");
+        }
+    }
+    
+};
+struct select_records_args {
+    std::string table;
+    std::string where;
+    std::vector<std::string> fields;
+    int32_t limit;
+
+    
+    friend void to_json(weilsdk::scratch_json &j, const select_records_args &obj) {
+        j = weilsdk::scratch_json::object();
+
+            j["table"] = obj.table;
+
+            j["where"] = obj.where;
+
+            j["fields"] = obj.fields;
+
+            j["limit"] = obj.limit;
+    }
+    
+    friend void from_json(const weilsdk::scratch_json &j, select_records_args &obj) {
+        try {
+
+            if (!j.contains("table")) {
+                throw std::runtime_error("Missing required field 'table'");
+            }
+            j.at("table").get_to(obj.table);
+
+            if (!j.contains("where")) {
+                throw std::runtime_error("Missing required field 'where'");
+            }
+            j.at("where").get_to(obj.where);
+
+            if (!j.contains("fields")) {
+                throw std::runtime_error("Missing required field 'fields'");
+            }
+            j.at("fields").get_to(obj.fields);
+
+            if (!j.contains("limit")) {
+                throw std::runtime_error("Missing required field 'limit'");
+            }
+            j.at("limit").get_to(obj.limit);
+        } catch (const std::exception& e) {
+            throw std::runtime_error("Invalid argument format");
+        }
+    }
+    
+};
+extern "C" {
+
+    int __new(size_t len, unsigned char _id) {
+        void *ptr = weilsdk::scratch_allocate(len);
+        return static_cast<int>(reinterpret_cast<uintptr_t>(ptr));
+    }
+    
+    void __free(size_t ptr, size_t len) {
+        weilsdk::scratch_deallocate(ptr, len);
+    }
+    
+    
+    // Initialize contract state
+    void init() {
+        weilsdk::ArenaScope arena_scope;
+        collections::InvocationScope invocation_scope;
+        weilsdk::StatsScope stats_scope("init");
+        in_memory_db_ContractState new_instance;
+        // TODO: Initialize contract state as needed
+    
+        nlohmann::ordered_json j = new_instance;
+        weilsdk::WeilValue wv;
+        wv.new_with_state_and_ok_value(weilsdk::CountedJson::dump(j), "null");
+        collections::WriteBuffer::flush();
+        weilsdk::CountedRuntime::setStateAndResult(std::variant<weilsdk::WeilValue,std::string> {std::move(wv)});
+    }
+    
+    
+    // Method kind data collection
+    void method_kind_data() {
+        weilsdk::ArenaScope arena_scope;
+        collections::InvocationScope invocation_scope;
+        weilsdk::StatsScope stats_scope("method_kind_data");
+        std::map<std::string, std::string> method_kind_mapping;
+        
+        
+        method_kind_mapping["create_table"] = "mutate";    
+        method_kind_mapping["create_table_with_storage"] = "mutate";    
+        method_kind_mapping["drop_table"] = "mutate";    
+        method_kind_mapping["list_tables"] = "query";    
+        method_kind_mapping["table_size"] = "query";    
+        method_kind_mapping["insert"] = "mutate";    
+        method_kind_mapping["update"] = "mutate";    
+        method_kind_mapping["get_value"] = "query";    
+        method_kind_mapping["remove_field"] = "mutate";    
+        method_kind_mapping["remove_record"] = "mutate";    
+        method_kind_mapping["insert_record"] = "mutate";    
+        method_kind_mapping["insert_records"] = "mutate";    
+        method_kind_mapping["get_fields"] = "query";    
+        method_kind_mapping["get_all_fields"] = "query";
+        method_kind_mapping["create_index"] = "mutate";    
+        method_kind_mapping["drop_index"] = "mutate";    
+        method_kind_mapping["query_by_field"] = "query";    
+        method_kind_mapping["create_key_index"] = "mutate";    
+        method_kind_mapping["drop_key_index"] = "mutate";    
+        method_kind_mapping["scan_range"] = "query";    
+        method_kind_mapping["scan_prefix"] = "query";    
+        method_kind_mapping["scan"] = "query";    
+        method_kind_mapping["truncate_table"] = "mutate";    
+        method_kind_mapping["reclaim"] = "mutate";    
+        method_kind_mapping["insert_records_budgeted"] = "mutate";    
+        method_kind_mapping["create_index_budgeted"] = "mutate";    
+        method_kind_mapping["create_key_index_budgeted"] = "mutate";    
+        method_kind_mapping["resume"] = "mutate";    
+        method_kind_mapping["multi_get"] = "query";    
+        method_kind_mapping["update_fields"] = "mutate";    
+        method_kind_mapping["update_records"] = "mutate";    
+        method_kind_mapping["remove_records"] = "mutate";    
+        method_kind_mapping["incr"] = "mutate";    
+        method_kind_mapping["append"] = "mutate";    
+        method_kind_mapping["get_version"] = "query";    
+        method_kind_mapping["cas"] = "mutate";    
+        method_kind_mapping["select_records"] = "query";    
+        method_kind_mapping["tools"] = "query";
+        method_kind_mapping["__stats"] = "query";
+        nlohmann::ordered_json json_object = method_kind_mapping;
+        std::string serialized_string = weilsdk::CountedJson::dump(json_object);
+        weilsdk::CountedRuntime::setResult(serialized_string, 0);
+    }
+    
+    
+    void create_table() {
+        weilsdk::ArenaScope arena_scope;
+        collections::InvocationScope invocation_scope;
+        weilsdk::StatsScope stats_scope("create_table");
+        weilsdk::StateArgsView p = weilsdk::CountedRuntime::stateAndArgsView();
+        weilsdk::scratch_json j = weilsdk::CountedJson::parse<weilsdk::scratch_json>(p.args);
+        
+        if (j.is_discarded() || !j.contains("table_name")) {
+            weilsdk::MethodError me = weilsdk::MethodError("create_table", "invalid_args");
+            weilsdk::CountedRuntime::setResult(weilsdk::WeilError::MethodArgumentDeserializationError(me), 1);
+            return;
+        }
+        
+        create_table_args args;
+        args = j.get<create_table_args>();
+        
+        nlohmann::ordered_json j1 = weilsdk::CountedJson::parse<nlohmann::ordered_json>(p.state);
+        
+        from_json(j1, in_memory_db_instance);
+        
+        int32_t result = in_memory_db_instance.create_table(args.table_name);
+        nlohmann::ordered_json j2 = in_memory_db_instance;
+        weilsdk::WeilValue wv;
+        weilsdk::scratch_json j_result = result;
+        wv.new_with_state_and_ok_value(weilsdk::CountedJson::dump(j2), weilsdk::CountedJson::dump(j_result));
+        collections::WriteBuffer::flush();
+        weilsdk::CountedRuntime::setStateAndResult(std::variant<weilsdk::WeilValue,std::string> {std::move(wv)});
+    }
+
+
+    void create_table_with_storage() {
+        weilsdk::ArenaScope arena_scope;
+        collections::InvocationScope invocation_scope;
+        weilsdk::StatsScope stats_scope("create_table_with_storage");
+        weilsdk::StateArgsView p = weilsdk::CountedRuntime::stateAndArgsView();
+        weilsdk::scratch_json j = weilsdk::CountedJson::parse<weilsdk::scratch_json>(p.args);
+        
+        if (j.is_discarded() || !j.contains("table_name") || !j.contains("storage")) {
+            weilsdk::MethodError me = weilsdk::MethodError("create_table_with_storage", "invalid_args");
+            weilsdk::CountedRuntime::setResult(weilsdk::WeilError::MethodArgumentDeserializationError(me), 1);
+            return;
+        }
+        
+        create_table_with_storage_args args;
+        args = j.get<create_table_with_storage_args>();
+        
+        nlohmann::ordered_json j1 = weilsdk::CountedJson::parse<nlohmann::ordered_json>(p.state);
+        
+        from_json(j1, in_memory_db_instance);
+        
+        int32_t result = in_memory_db_instance.create_table_with_storage(args.table_name, args.storage);
+        nlohmann::ordered_json j2 = in_memory_db_instance;
+        weilsdk::WeilValue wv;
+        weilsdk::scratch_json j_result = result;
+        wv.new_with_state_and_ok_value(weilsdk::CountedJson::dump(j2), weilsdk::CountedJson::dump(j_result));
+        collections::WriteBuffer::flush();
+        weilsdk::CountedRuntime::setStateAndResult(std::variant<weilsdk::WeilValue,std::string> {std::move(wv)});
+    }
+
+
+    void drop_table() {
+        weilsdk::ArenaScope arena_scope;
+        collections::InvocationScope invocation_scope;
+        weilsdk::StatsScope stats_scope("drop_table");
+        weilsdk::StateArgsView p = weilsdk::CountedRuntime::stateAndArgsView();
+        weilsdk::scratch_json j = weilsdk::CountedJson::parse<weilsdk::scratch_json>(p.args);
+        
+        if (j.is_discarded() || !j.contains("table_name")) {
+            weilsdk::MethodError me = weilsdk::MethodError("drop_table", "invalid_args");
+            weilsdk::CountedRuntime::setResult(weilsdk::WeilError::MethodArgumentDeserializationError(me), 1);
+            return;
+        }
+        
+        drop_table_args args;
+        args = j.get<drop_table_args>();
+        
+        nlohmann::ordered_json j1 = weilsdk::CountedJson::parse<nlohmann::ordered_json>(p.state);
+        
+        from_json(j1, in_memory_db_instance);
+        
+        int32_t result = in_memory_db_instance.drop_table(args.table_name);
+        nlohmann::ordered_json j2 = in_memory_db_instance;
+        weilsdk::WeilValue wv;
+        weilsdk::scratch_json j_result = result;
+        wv.new_with_state_and_ok_value(weilsdk::CountedJson::dump(j2), weilsdk::CountedJson::dump(j_result));
+        collections::WriteBuffer::flush();
+        weilsdk::CountedRuntime::setStateAndResult(std::variant<weilsdk::WeilValue,std::string> {std::move(wv)});
+    }
+
+
+    void list_tables() {
+        weilsdk::ArenaScope arena_scope;
+        collections::InvocationScope invocation_scope;
+        weilsdk::StatsScope stats_scope("list_tables");
+        std::string stateString = weilsdk::CountedRuntime::state();
+    
+        nlohmann::ordered_json j1 = weilsdk::CountedJson::parse<nlohmann::ordered_json>(stateString);
+        from_json(j1, in_memory_db_instance);
+        
+        std::vector<std::string> result = in_memory_db_instance.list_tables();
+        weilsdk::scratch_json j_result = result;
+        weilsdk::CountedRuntime::setResult(weilsdk::CountedJson::dump(j_result), 0);
+    }
+
+
+    void table_size() {
+        weilsdk::ArenaScope arena_scope;
+        collections::InvocationScope invocation_scope;
+        weilsdk::StatsScope stats_scope("table_size");
+            weilsdk::StateArgsView p = weilsdk::CountedRuntime::stateAndArgsView();
+            weilsdk::scratch_json j = weilsdk::CountedJson::parse<weilsdk::scratch_json>(p.args);
+        
+            if (j.is_discarded() || !j.contains("table_name")) {
+            weilsdk::MethodError me = weilsdk::MethodError("table_size", "invalid_args");
+            weilsdk::CountedRuntime::setResult(weilsdk::WeilError::MethodArgumentDeserializationError(me), 1);
+            return;
+        }
+        
+        table_size_args args;
+        args = j.get<table_size_args>();
+        
+    
+        nlohmann::ordered_json j1 = weilsdk::CountedJson::parse<nlohmann::ordered_json>(p.state);
+        from_json(j1, in_memory_db_instance);
+        
+        int32_t result = in_memory_db_instance.table_size(args.table_name);
+        weilsdk::scratch_json j_result = result;
+        weilsdk::CountedRuntime::setResult(weilsdk::CountedJson::dump(j_result), 0);
+    }
+
+
+    void insert() {
+        weilsdk::ArenaScope arena_scope;
+        collections::InvocationScope invocation_scope;
+        weilsdk::StatsScope stats_scope("insert");
+        weilsdk::StateArgsView p = weilsdk::CountedRuntime::stateAndArgsView();
+        weilsdk::scratch_json j = weilsdk::CountedJson::parse<weilsdk::scratch_json>(p.args);
+        
+        if (j.is_discarded() || !j.contains("table") || !j.contains("key") || !j.contains("field") || !j.contains("value")) {
+            weilsdk::MethodError me = weilsdk::MethodError("insert", "invalid_args");
+            weilsdk::CountedRuntime::setResult(weilsdk::WeilError::MethodArgumentDeserializationError(me), 1);
+            return;
+        }
+        
+        insert_args args;
+        args = j.get<insert_args>();
+        
+        nlohmann::ordered_json j1 = weilsdk::CountedJson::parse<nlohmann::ordered_json>(p.state);
+        
+        from_json(j1, in_memory_db_instance);
+        
+        int32_t result = in_memory_db_instance.insert(args.table, args.key, args.field, args.value);
+        nlohmann::ordered_json j2 = in_memory_db_instance;
+        weilsdk::WeilValue wv;
+        weilsdk::scratch_json j_result = result;
+        wv.new_with_state_and_ok_value(weilsdk::CountedJson::dump(j2), weilsdk::CountedJson::dump(j_result));
+        collections::WriteBuffer::flush();
+        weilsdk::CountedRuntime::setStateAndResult(std::variant<weilsdk::WeilValue,std::string> {std::move(wv)});
+    }
+
+
+    void update() {
+        weilsdk::ArenaScope arena_scope;
+        collections::InvocationScope invocation_scope;
+        weilsdk::StatsScope stats_scope("update");
+        weilsdk::StateArgsView p = weilsdk::CountedRuntime::stateAndArgsView();
+        weilsdk::scratch_json j = weilsdk::CountedJson::parse<weilsdk::scratch_json>(p.args);
+        
+        if (j.is_discarded() || !j.contains("table") || !j.contains("key") || !j.contains("field") || !j.contains("value")) {
+            weilsdk::MethodError me = weilsdk::MethodError("update", "invalid_args");
+            weilsdk::CountedRuntime::setResult(weilsdk::WeilError::MethodArgumentDeserializationError(me), 1);
+            return;
+        }
+        
+        update_args args;
+        args = j.get<update_args>();
+        
+        nlohmann::ordered_json j1 = weilsdk::CountedJson::parse<nlohmann::ordered_json>(p.state);
+        
+        from_json(j1, in_memory_db_instance);
+        
+        int32_t result = in_memory_db_instance.update(args.table, args.key, args.field, args.value);
+        nlohmann::ordered_json j2 = in_memory_db_instance;
+        weilsdk::WeilValue wv;
+        weilsdk::scratch_json j_result = result;
+        wv.new_with_state_and_ok_value(weilsdk::CountedJson::dump(j2), weilsdk::CountedJson::dump(j_result));
+        collections::WriteBuffer::flush();
+        weilsdk::CountedRuntime::setStateAndResult(std::variant<weilsdk::WeilValue,std::string> {std::move(wv)});
+    }
+
+
+    void get_value() {
+        weilsdk::ArenaScope arena_scope;
+        collections::InvocationScope invocation_scope;
+        weilsdk::StatsScope stats_scope("get_value");
+            weilsdk::StateArgsView p = weilsdk::CountedRuntime::stateAndArgsView();
+            weilsdk::scratch_json j = weilsdk::CountedJson::parse<weilsdk::scratch_json>(p.args);
+        
+            if (j.is_discarded() || !j.contains("table") || !j.contains("key") || !j.contains("field")) {
+            weilsdk::MethodError me = weilsdk::MethodError("get_value", "invalid_args");
+            weilsdk::CountedRuntime::setResult(weilsdk::WeilError::MethodArgumentDeserializationError(me), 1);
+            return;
+        }
+        
+        get_value_args args;
+        args = j.get<get_value_args>();
+        
+    
+        nlohmann::ordered_json j1 = weilsdk::CountedJson::parse<nlohmann::ordered_json>(p.state);
+        from_json(j1, in_memory_db_instance);
+        
+        std::optional<std::string> result = in_memory_db_instance.get_value(args.table, args.key, args.field);
+        if (result.has_value()) {
+            weilsdk::scratch_json j_result = result.value();
+            weilsdk::CountedRuntime::setResult(weilsdk::CountedJson::dump(j_result), 0);
+        } else {
+            weilsdk::CountedRuntime::setResult("null", 0);
         }
     }
 
 
     void remove_field() {
-        std::pair<std::string, std::string> p = weilsdk::Runtime::stateAndArgs();
-        std::string raw_args = p.second;
-        nlohmann::ordered_json j = nlohmann::ordered_json::parse(raw_args);
+        weilsdk::ArenaScope arena_scope;
+        collections::InvocationScope invocation_scope;
+        weilsdk::StatsScope stats_scope("remove_field");
+        weilsdk::StateArgsView p = weilsdk::CountedRuntime::stateAndArgsView();
+        weilsdk::scratch_json j = weilsdk::CountedJson::parse<weilsdk::scratch_json>(p.args);
+        
+        if (j.is_discarded() || !j.contains("table") || !j.contains("key") || !j.contains("field")) {
+            weilsdk::MethodError me = weilsdk::MethodError("remove_field", "invalid_args");
+            weilsdk::CountedRuntime::setResult(weilsdk::WeilError::MethodArgumentDeserializationError(me), 1);
+            return;
+        }
+        
+        remove_field_args args;
+        args = j.get<remove_field_args>();
+        
+        nlohmann::ordered_json j1 = weilsdk::CountedJson::parse<nlohmann::ordered_json>(p.state);
+        
+        from_json(j1, in_memory_db_instance);
+        
+        int32_t result = in_memory_db_instance.remove_field(args.table, args.key, args.field);
+        nlohmann::ordered_json j2 = in_memory_db_instance;
+        weilsdk::WeilValue wv;
+        weilsdk::scratch_json j_result = result;
+        wv.new_with_state_and_ok_value(weilsdk::CountedJson::dump(j2), weilsdk::CountedJson::dump(j_result));
+        collections::WriteBuffer::flush();
+        weilsdk::CountedRuntime::setStateAndResult(std::variant<weilsdk::WeilValue,std::string> {std::move(wv)});
+    }
+
+
+    void remove_record() {
+        weilsdk::ArenaScope arena_scope;
+        collections::InvocationScope invocation_scope;
+        weilsdk::StatsScope stats_scope("remove_record");
+        weilsdk::StateArgsView p = weilsdk::CountedRuntime::stateAndArgsView();
+        weilsdk::scratch_json j = weilsdk::CountedJson::parse<weilsdk::scratch_json>(p.args);
+        
+        if (j.is_discarded() || !j.contains("table") || !j.contains("key")) {
+            weilsdk::MethodError me = weilsdk::MethodError("remove_record", "invalid_args");
+            weilsdk::CountedRuntime::setResult(weilsdk::WeilError::MethodArgumentDeserializationError(me), 1);
+            return;
+        }
+        
+        remove_record_args args;
+        args = j.get<remove_record_args>();
+        
+        nlohmann::ordered_json j1 = weilsdk::CountedJson::parse<nlohmann::ordered_json>(p.state);
+        
+        from_json(j1, in_memory_db_instance);
+        
+        int32_t result = in_memory_db_instance.remove_record(args.table, args.key);
+        nlohmann::ordered_json j2 = in_memory_db_instance;
+        weilsdk::WeilValue wv;
+        weilsdk::scratch_json j_result = result;
+        wv.new_with_state_and_ok_value(weilsdk::CountedJson::dump(j2), weilsdk::CountedJson::dump(j_result));
+        collections::WriteBuffer::flush();
+        weilsdk::CountedRuntime::setStateAndResult(std::variant<weilsdk::WeilValue,std::string> {std::move(wv)});
+    }
+
+
+    void insert_record() {
+        weilsdk::ArenaScope arena_scope;
+        collections::InvocationScope invocation_scope;
+        weilsdk::StatsScope stats_scope("insert_record");
+        weilsdk::StateArgsView p = weilsdk::CountedRuntime::stateAndArgsView();
+        weilsdk::scratch_json j = weilsdk::CountedJson::parse<weilsdk::scratch_json>(p.args);
+        
+        if (j.is_discarded() || !j.contains("table") || !j.contains("key") || !j.contains("fields")) {
+            weilsdk::MethodError me = weilsdk::MethodError("insert_record", "invalid_args");
+            weilsdk::CountedRuntime::setResult(weilsdk::WeilError::MethodArgumentDeserializationError(me), 1);
+            return;
+        }
+        
+        insert_record_args args;
+        args = j.get<insert_record_args>();
+        
+        nlohmann::ordered_json j1 = weilsdk::CountedJson::parse<nlohmann::ordered_json>(p.state);
+        
+        from_json(j1, in_memory_db_instance);
+        
+        int32_t result = in_memory_db_instance.insert_record(args.table, args.key, args.fields);
+        nlohmann::ordered_json j2 = in_memory_db_instance;
+        weilsdk::WeilValue wv;
+        weilsdk::scratch_json j_result = result;
+        wv.new_with_state_and_ok_value(weilsdk::CountedJson::dump(j2), weilsdk::CountedJson::dump(j_result));
+        collections::WriteBuffer::flush();
+        weilsdk::CountedRuntime::setStateAndResult(std::variant<weilsdk::WeilValue,std::string> {std::move(wv)});
+    }
+
+
+    void insert_records() {
+        weilsdk::ArenaScope arena_scope;
+        collections::InvocationScope invocation_scope;
+        weilsdk::StatsScope stats_scope("insert_records");
+        weilsdk::StateArgsView p = weilsdk::CountedRuntime::stateAndArgsView();
+        weilsdk::scratch_json j = weilsdk::CountedJson::parse<weilsdk::scratch_json>(p.args);
+        
+        if (j.is_discarded() || !j.contains("table") || !j.contains("records")) {
+            weilsdk::MethodError me = weilsdk::MethodError("insert_records", "invalid_args");
+            weilsdk::CountedRuntime::setResult(weilsdk::WeilError::MethodArgumentDeserializationError(me), 1);
+            return;
+        }
+        
+        insert_records_args args;
+        args = j.get<insert_records_args>();
+        
+        nlohmann::ordered_json j1 = weilsdk::CountedJson::parse<nlohmann::ordered_json>(p.state);
+        
+        from_json(j1, in_memory_db_instance);
+        
+        int32_t result = in_memory_db_instance.insert_records(args.table, args.records);
+        nlohmann::ordered_json j2 = in_memory_db_instance;
+        weilsdk::WeilValue wv;
+        weilsdk::scratch_json j_result = result;
+        wv.new_with_state_and_ok_value(weilsdk::CountedJson::dump(j2), weilsdk::CountedJson::dump(j_result));
+        collections::WriteBuffer::flush();
+        weilsdk::CountedRuntime::setStateAndResult(std::variant<weilsdk::WeilValue,std::string> {std::move(wv)});
+    }
+
+
+    void get_fields() {
+        weilsdk::ArenaScope arena_scope;
+        collections::InvocationScope invocation_scope;
+        weilsdk::StatsScope stats_scope("get_fields");
+            weilsdk::StateArgsView p = weilsdk::CountedRuntime::stateAndArgsView();
+            weilsdk::scratch_json j = weilsdk::CountedJson::parse<weilsdk::scratch_json>(p.args);
+        
+            if (j.is_discarded() || !j.contains("table") || !j.contains("key") || !j.contains("fields")) {
+            weilsdk::MethodError me = weilsdk::MethodError("get_fields", "invalid_args");
+            weilsdk::CountedRuntime::setResult(weilsdk::WeilError::MethodArgumentDeserializationError(me), 1);
+            return;
+        }
+        
+        get_fields_args args;
+        args = j.get<get_fields_args>();
+        
+    
+        nlohmann::ordered_json j1 = weilsdk::CountedJson::parse<nlohmann::ordered_json>(p.state);
+        from_json(j1, in_memory_db_instance);
+        
+        std::vector<std::tuple<std::string, std::string>> result = in_memory_db_instance.get_fields(args.table, args.key, args.fields);
+        weilsdk::scratch_json j_result = result;
+        weilsdk::CountedRuntime::setResult(weilsdk::CountedJson::dump(j_result), 0);
+    }
+
+
+    void get_all_fields() {
+        weilsdk::ArenaScope arena_scope;
+        collections::InvocationScope invocation_scope;
+        weilsdk::StatsScope stats_scope("get_all_fields");
+            weilsdk::StateArgsView p = weilsdk::CountedRuntime::stateAndArgsView();
+            weilsdk::scratch_json j = weilsdk::CountedJson::parse<weilsdk::scratch_json>(p.args);
+        
+            if (j.is_discarded() || !j.contains("table") || !j.contains("key")) {
+            weilsdk::MethodError me = weilsdk::MethodError("get_all_fields", "invalid_args");
+            weilsdk::CountedRuntime::setResult(weilsdk::WeilError::MethodArgumentDeserializationError(me), 1);
+            return;
+        }
+        
+        get_all_fields_args args;
+        args = j.get<get_all_fields_args>();
+        
+    
+        nlohmann::ordered_json j1 = weilsdk::CountedJson::parse<nlohmann::ordered_json>(p.state);
+        from_json(j1, in_memory_db_instance);
+        
+        std::vector<std::tuple<std::string, std::string>> result = in_memory_db_instance.get_all_fields(args.table, args.key);
+        weilsdk::scratch_json j_result = result;
+        weilsdk::CountedRuntime::setResult(weilsdk::CountedJson::dump(j_result), 0);
+    }
+
+
+    void create_index() {
+        weilsdk::ArenaScope arena_scope;
+        collections::InvocationScope invocation_scope;
+        weilsdk::StatsScope stats_scope("create_index");
+        weilsdk::StateArgsView p = weilsdk::CountedRuntime::stateAndArgsView();
+        weilsdk::scratch_json j = weilsdk::CountedJson::parse<weilsdk::scratch_json>(p.args);
+        
+        if (j.is_discarded() || !j.contains("table") || !j.contains("field")) {
+            weilsdk::MethodError me = weilsdk::MethodError("create_index", "invalid_args");
+            weilsdk::CountedRuntime::setResult(weilsdk::WeilError::MethodArgumentDeserializationError(me), 1);
+            return;
+        }
+        
+        create_index_args args;
+        args = j.get<create_index_args>();
+        
+        nlohmann::ordered_json j1 = weilsdk::CountedJson::parse<nlohmann::ordered_json>(p.state);
+        
+        from_json(j1, in_memory_db_instance);
+        
+        int32_t result = in_memory_db_instance.create_index(args.table, args.field);
+        nlohmann::ordered_json j2 = in_memory_db_instance;
+        weilsdk::WeilValue wv;
+        weilsdk::scratch_json j_result = result;
+        wv.new_with_state_and_ok_value(weilsdk::CountedJson::dump(j2), weilsdk::CountedJson::dump(j_result));
+        collections::WriteBuffer::flush();
+        weilsdk::CountedRuntime::setStateAndResult(std::variant<weilsdk::WeilValue,std::string> {std::move(wv)});
+    }
+
+
+    void drop_index() {
+        weilsdk::ArenaScope arena_scope;
+        collections::InvocationScope invocation_scope;
+        weilsdk::StatsScope stats_scope("drop_index");
+        weilsdk::StateArgsView p = weilsdk::CountedRuntime::stateAndArgsView();
+        weilsdk::scratch_json j = weilsdk::CountedJson::parse<weilsdk::scratch_json>(p.args);
+        
+        if (j.is_discarded() || !j.contains("table") || !j.contains("field")) {
+            weilsdk::MethodError me = weilsdk::MethodError("drop_index", "invalid_args");
+            weilsdk::CountedRuntime::setResult(weilsdk::WeilError::MethodArgumentDeserializationError(me), 1);
+            return;
+        }
+        
+        drop_index_args args;
+        args = j.get<drop_index_args>();
+        
+        nlohmann::ordered_json j1 = weilsdk::CountedJson::parse<nlohmann::ordered_json>(p.state);
         
-        if (j.is_discarded() || !j.contains("table") || !j.contains("key") || !j.contains("field")) {
-            weilsdk::MethodError me = weilsdk::MethodError("remove_field", "invalid_args");
-            weilsdk::Runtime::setResult(weilsdk::WeilError::MethodArgumentDeserializationError(me), 1);
+        from_json(j1, in_memory_db_instance);
+        
+        int32_t result = in_memory_db_instance.drop_index(args.table, args.field);
+        nlohmann::ordered_json j2 = in_memory_db_instance;
+        weilsdk::WeilValue wv;
+        weilsdk::scratch_json j_result = result;
+        wv.new_with_state_and_ok_value(weilsdk::CountedJson::dump(j2), weilsdk::CountedJson::dump(j_result));
+        collections::WriteBuffer::flush();
+        weilsdk::CountedRuntime::setStateAndResult(std::variant<weilsdk::WeilValue,std::string> {std::move(wv)});
+    }
+
+
+    void query_by_field() {
+        weilsdk::ArenaScope arena_scope;
+        collections::InvocationScope invocation_scope;
+        weilsdk::StatsScope stats_scope("query_by_field");
+        weilsdk::StateArgsView p = weilsdk::CountedRuntime::stateAndArgsView();
+        weilsdk::scratch_json j = weilsdk::CountedJson::parse<weilsdk::scratch_json>(p.args);
+        
+        if (j.is_discarded() || !j.contains("table") || !j.contains("field") || !j.contains("value") || !j.contains("limit") || !j.contains("cursor")) {
+            weilsdk::MethodError me = weilsdk::MethodError("query_by_field", "invalid_args");
+            weilsdk::CountedRuntime::setResult(weilsdk::WeilError::MethodArgumentDeserializationError(me), 1);
             return;
         }
         
-        remove_field_args args;
-        args = j.get<remove_field_args>();
+        query_by_field_args args;
+        args = j.get<query_by_field_args>();
+        
+    
+        nlohmann::ordered_json j1 = weilsdk::CountedJson::parse<nlohmann::ordered_json>(p.state);
+        from_json(j1, in_memory_db_instance);
+        
+        std::optional<std::tuple<std::vector<std::tuple<std::string, std::vector<std::tuple<std::string, std::string>>>>, std::string>> result = in_memory_db_instance.query_by_field(args.table, args.field, args.value, args.limit, args.cursor);
+        if (result.has_value()) {
+            weilsdk::scratch_json j_result = result.value();
+            weilsdk::CountedRuntime::setResult(weilsdk::CountedJson::dump(j_result), 0);
+        } else {
+            weilsdk::CountedRuntime::setResult("null", 0);
+        }
+    }
+
+
+    void create_key_index() {
+        weilsdk::ArenaScope arena_scope;
+        collections::InvocationScope invocation_scope;
+        weilsdk::StatsScope stats_scope("create_key_index");
+        weilsdk::StateArgsView p = weilsdk::CountedRuntime::stateAndArgsView();
+        weilsdk::scratch_json j = weilsdk::CountedJson::parse<weilsdk::scratch_json>(p.args);
+        
+        if (j.is_discarded() || !j.contains("table")) {
+            weilsdk::MethodError me = weilsdk::MethodError("create_key_index", "invalid_args");
+            weilsdk::CountedRuntime::setResult(weilsdk::WeilError::MethodArgumentDeserializationError(me), 1);
+            return;
+        }
+        
+        create_key_index_args args;
+        args = j.get<create_key_index_args>();
         
-        std::string stateString = p.first;
-        nlohmann::ordered_json j1 = nlohmann::ordered_json::parse(stateString);
+        nlohmann::ordered_json j1 = weilsdk::CountedJson::parse<nlohmann::ordered_json>(p.state);
         
         from_json(j1, in_memory_db_instance);
         
-        int32_t result = in_memory_db_instance.remove_field(args.table, args.key, args.field);
+        int32_t result = in_memory_db_instance.create_key_index(args.table);
         nlohmann::ordered_json j2 = in_memory_db_instance;
         weilsdk::WeilValue wv;
-        nlohmann::ordered_json j_result = result;
-        wv.new_with_state_and_ok_value(j2.dump(), j_result.dump());
-        weilsdk::Runtime::setStateAndResult(std::variant<weilsdk::WeilValue,std::string> {wv});
+        weilsdk::scratch_json j_result = result;
+        wv.new_with_state_and_ok_value(weilsdk::CountedJson::dump(j2), weilsdk::CountedJson::dump(j_result));
+        collections::WriteBuffer::flush();
+        weilsdk::CountedRuntime::setStateAndResult(std::variant<weilsdk::WeilValue,std::string> {std::move(wv)});
     }
 
 
-    void remove_record() {
-        std::pair<std::string, std::string> p = weilsdk::Runtime::stateAndArgs();
-        std::string raw_args = p.second;
-        nlohmann::ordered_json j = nlohmann::ordered_json::parse(raw_args);
+    void drop_key_index() {
+        weilsdk::ArenaScope arena_scope;
+        collections::InvocationScope invocation_scope;
+        weilsdk::StatsScope stats_scope("drop_key_index");
+        weilsdk::StateArgsView p = weilsdk::CountedRuntime::stateAndArgsView();
+        weilsdk::scratch_json j = weilsdk::CountedJson::parse<weilsdk::scratch_json>(p.args);
         
-        if (j.is_discarded() || !j.contains("table") || !j.contains("key")) {
-            weilsdk::MethodError me = weilsdk::MethodError("remove_record", "invalid_args");
-            weilsdk::Runtime::setResult(weilsdk::WeilError::MethodArgumentDeserializationError(me), 1);
+        if (j.is_discarded() || !j.contains("table")) {
+            weilsdk::MethodError me = weilsdk::MethodError("drop_key_index", "invalid_args");
+            weilsdk::CountedRuntime::setResult(weilsdk::WeilError::MethodArgumentDeserializationError(me), 1);
             return;
         }
         
-        remove_record_args args;
-        args = j.get<remove_record_args>();
+        drop_key_index_args args;
+        args = j.get<drop_key_index_args>();
         
-        std::string stateString = p.first;
-        nlohmann::ordered_json j1 = nlohmann::ordered_json::parse(stateString);
+        nlohmann::ordered_json j1 = weilsdk::CountedJson::parse<nlohmann::ordered_json>(p.state);
         
         from_json(j1, in_memory_db_instance);
         
-        int32_t result = in_memory_db_instance.remove_record(args.table, args.key);
+        int32_t result = in_memory_db_instance.drop_key_index(args.table);
         nlohmann::ordered_json j2 = in_memory_db_instance;
         weilsdk::WeilValue wv;
-        nlohmann::ordered_json j_result = result;
-        wv.new_with_state_and_ok_value(j2.dump(), j_result.dump());
-        weilsdk::Runtime::setStateAndResult(std::variant<weilsdk::WeilValue,std::string> {wv});
+        weilsdk::scratch_json j_result = result;
+        wv.new_with_state_and_ok_value(weilsdk::CountedJson::dump(j2), weilsdk::CountedJson::dump(j_result));
+        collections::WriteBuffer::flush();
+        weilsdk::CountedRuntime::setStateAndResult(std::variant<weilsdk::WeilValue,std::string> {std::move(wv)});
     }
 
 
-    void insert_record() {
-        std::pair<std::string, std::string> p = weilsdk::Runtime::stateAndArgs();
-        std::string raw_args = p.second;
-        nlohmann::ordered_json j = nlohmann::ordered_json::parse(raw_args);
+    void scan_range() {
+        weilsdk::ArenaScope arena_scope;
+        collections::InvocationScope invocation_scope;
+        weilsdk::StatsScope stats_scope("scan_range");
+        weilsdk::StateArgsView p = weilsdk::CountedRuntime::stateAndArgsView();
+        weilsdk::scratch_json j = weilsdk::CountedJson::parse<weilsdk::scratch_json>(p.args);
+        
+        if (j.is_discarded() || !j.contains("table") || !j.contains("start") || !j.contains("end") || !j.contains("limit") || !j.contains("fields")) {
+            weilsdk::MethodError me = weilsdk::MethodError("scan_range", "invalid_args");
+            weilsdk::CountedRuntime::setResult(weilsdk::WeilError::MethodArgumentDeserializationError(me), 1);
+            return;
+        }
+        
+        scan_range_args args;
+        args = j.get<scan_range_args>();
+        
+    
+        nlohmann::ordered_json j1 = weilsdk::CountedJson::parse<nlohmann::ordered_json>(p.state);
+        from_json(j1, in_memory_db_instance);
+        
+        std::optional<std::vector<std::tuple<std::string, std::vector<std::tuple<std::string, std::string>>>>> result = in_memory_db_instance.scan_range(args.table, args.start, args.end, args.limit, args.fields);
+        if (result.has_value()) {
+            weilsdk::scratch_json j_result = result.value();
+            weilsdk::CountedRuntime::setResult(weilsdk::CountedJson::dump(j_result), 0);
+        } else {
+            weilsdk::CountedRuntime::setResult("null", 0);
+        }
+    }
+
+
+    void scan_prefix() {
+        weilsdk::ArenaScope arena_scope;
+        collections::InvocationScope invocation_scope;
+        weilsdk::StatsScope stats_scope("scan_prefix");
+        weilsdk::StateArgsView p = weilsdk::CountedRuntime::stateAndArgsView();
+        weilsdk::scratch_json j = weilsdk::CountedJson::parse<weilsdk::scratch_json>(p.args);
+        
+        if (j.is_discarded() || !j.contains("table") || !j.contains("prefix") || !j.contains("limit") || !j.contains("fields")) {
+            weilsdk::MethodError me = weilsdk::MethodError("scan_prefix", "invalid_args");
+            weilsdk::CountedRuntime::setResult(weilsdk::WeilError::MethodArgumentDeserializationError(me), 1);
+            return;
+        }
+        
+        scan_prefix_args args;
+        args = j.get<scan_prefix_args>();
+        
+    
+        nlohmann::ordered_json j1 = weilsdk::CountedJson::parse<nlohmann::ordered_json>(p.state);
+        from_json(j1, in_memory_db_instance);
+        
+        std::optional<std::vector<std::tuple<std::string, std::vector<std::tuple<std::string, std::string>>>>> result = in_memory_db_instance.scan_prefix(args.table, args.prefix, args.limit, args.fields);
+        if (result.has_value()) {
+            weilsdk::scratch_json j_result = result.value();
+            weilsdk::CountedRuntime::setResult(weilsdk::CountedJson::dump(j_result), 0);
+        } else {
+            weilsdk::CountedRuntime::setResult("null", 0);
+        }
+    }
+
+
+    void scan() {
+        weilsdk::ArenaScope arena_scope;
+        collections::InvocationScope invocation_scope;
+        weilsdk::StatsScope stats_scope("scan");
+        weilsdk::StateArgsView p = weilsdk::CountedRuntime::stateAndArgsView();
+        weilsdk::scratch_json j = weilsdk::CountedJson::parse<weilsdk::scratch_json>(p.args);
+        
+        if (j.is_discarded() || !j.contains("table") || !j.contains("cursor") || !j.contains("limit") || !j.contains("fields")) {
+            weilsdk::MethodError me = weilsdk::MethodError("scan", "invalid_args");
+            weilsdk::CountedRuntime::setResult(weilsdk::WeilError::MethodArgumentDeserializationError(me), 1);
+            return;
+        }
+        
+        scan_args args;
+        args = j.get<scan_args>();
+        
+    
+        nlohmann::ordered_json j1 = weilsdk::CountedJson::parse<nlohmann::ordered_json>(p.state);
+        from_json(j1, in_memory_db_instance);
+        
+        std::optional<std::tuple<std::vector<std::tuple<std::string, std::vector<std::tuple<std::string, std::string>>>>, std::string>> result = in_memory_db_instance.scan(args.table, args.cursor, args.limit, args.fields);
+        if (result.has_value()) {
+            weilsdk::scratch_json j_result = result.value();
+            weilsdk::CountedRuntime::setResult(weilsdk::CountedJson::dump(j_result), 0);
+        } else {
+            weilsdk::CountedRuntime::setResult("null", 0);
+        }
+    }
+
+
+    void truncate_table() {
+        weilsdk::ArenaScope arena_scope;
+        collections::InvocationScope invocation_scope;
+        weilsdk::StatsScope stats_scope("truncate_table");
+        weilsdk::StateArgsView p = weilsdk::CountedRuntime::stateAndArgsView();
+        weilsdk::scratch_json j = weilsdk::CountedJson::parse<weilsdk::scratch_json>(p.args);
+        
+        if (j.is_discarded() || !j.contains("table_name")) {
+            weilsdk::MethodError me = weilsdk::MethodError("truncate_table", "invalid_args");
+            weilsdk::CountedRuntime::setResult(weilsdk::WeilError::MethodArgumentDeserializationError(me), 1);
+            return;
+        }
+        
+        truncate_table_args args;
+        args = j.get<truncate_table_args>();
+        
+        nlohmann::ordered_json j1 = weilsdk::CountedJson::parse<nlohmann::ordered_json>(p.state);
+        
+        from_json(j1, in_memory_db_instance);
+        
+        int32_t result = in_memory_db_instance.truncate_table(args.table_name);
+        nlohmann::ordered_json j2 = in_memory_db_instance;
+        weilsdk::WeilValue wv;
+        weilsdk::scratch_json j_result = result;
+        wv.new_with_state_and_ok_value(weilsdk::CountedJson::dump(j2), weilsdk::CountedJson::dump(j_result));
+        collections::WriteBuffer::flush();
+        weilsdk::CountedRuntime::setStateAndResult(std::variant<weilsdk::WeilValue,std::string> {std::move(wv)});
+    }
+
+
+    void reclaim() {
+        weilsdk::ArenaScope arena_scope;
+        collections::InvocationScope invocation_scope;
+        weilsdk::StatsScope stats_scope("reclaim");
+        weilsdk::StateArgsView p = weilsdk::CountedRuntime::stateAndArgsView();
+        weilsdk::scratch_json j = weilsdk::CountedJson::parse<weilsdk::scratch_json>(p.args);
+        
+        if (j.is_discarded() || !j.contains("max_records")) {
+            weilsdk::MethodError me = weilsdk::MethodError("reclaim", "invalid_args");
+            weilsdk::CountedRuntime::setResult(weilsdk::WeilError::MethodArgumentDeserializationError(me), 1);
+            return;
+        }
+        
+        reclaim_args args;
+        args = j.get<reclaim_args>();
+        
+        nlohmann::ordered_json j1 = weilsdk::CountedJson::parse<nlohmann::ordered_json>(p.state);
+        
+        from_json(j1, in_memory_db_instance);
+        
+        int32_t result = in_memory_db_instance.reclaim(args.max_records);
+        nlohmann::ordered_json j2 = in_memory_db_instance;
+        weilsdk::WeilValue wv;
+        weilsdk::scratch_json j_result = result;
+        wv.new_with_state_and_ok_value(weilsdk::CountedJson::dump(j2), weilsdk::CountedJson::dump(j_result));
+        collections::WriteBuffer::flush();
+        weilsdk::CountedRuntime::setStateAndResult(std::variant<weilsdk::WeilValue,std::string> {std::move(wv)});
+    }
+
+
+    void insert_records_budgeted() {
+        weilsdk::ArenaScope arena_scope;
+        collections::InvocationScope invocation_scope;
+        weilsdk::StatsScope stats_scope("insert_records_budgeted");
+        weilsdk::StateArgsView p = weilsdk::CountedRuntime::stateAndArgsView();
+        weilsdk::scratch_json j = weilsdk::CountedJson::parse<weilsdk::scratch_json>(p.args);
+        
+        if (j.is_discarded() || !j.contains("table") || !j.contains("records") || !j.contains("max_ops")) {
+            weilsdk::MethodError me = weilsdk::MethodError("insert_records_budgeted", "invalid_args");
+            weilsdk::CountedRuntime::setResult(weilsdk::WeilError::MethodArgumentDeserializationError(me), 1);
+            return;
+        }
+        
+        insert_records_budgeted_args args;
+        args = j.get<insert_records_budgeted_args>();
+        
+        nlohmann::ordered_json j1 = weilsdk::CountedJson::parse<nlohmann::ordered_json>(p.state);
+        
+        from_json(j1, in_memory_db_instance);
+        
+        std::tuple<int32_t, std::string> result = in_memory_db_instance.insert_records_budgeted(args.table, args.records, args.max_ops);
+        nlohmann::ordered_json j2 = in_memory_db_instance;
+        weilsdk::WeilValue wv;
+        weilsdk::scratch_json j_result = result;
+        wv.new_with_state_and_ok_value(weilsdk::CountedJson::dump(j2), weilsdk::CountedJson::dump(j_result));
+        collections::WriteBuffer::flush();
+        weilsdk::CountedRuntime::setStateAndResult(std::variant<weilsdk::WeilValue,std::string> {std::move(wv)});
+    }
+
+
+    void create_index_budgeted() {
+        weilsdk::ArenaScope arena_scope;
+        collections::InvocationScope invocation_scope;
+        weilsdk::StatsScope stats_scope("create_index_budgeted");
+        weilsdk::StateArgsView p = weilsdk::CountedRuntime::stateAndArgsView();
+        weilsdk::scratch_json j = weilsdk::CountedJson::parse<weilsdk::scratch_json>(p.args);
+        
+        if (j.is_discarded() || !j.contains("table") || !j.contains("field") || !j.contains("max_ops")) {
+            weilsdk::MethodError me = weilsdk::MethodError("create_index_budgeted", "invalid_args");
+            weilsdk::CountedRuntime::setResult(weilsdk::WeilError::MethodArgumentDeserializationError(me), 1);
+            return;
+        }
+        
+        create_index_budgeted_args args;
+        args = j.get<create_index_budgeted_args>();
+        
+        nlohmann::ordered_json j1 = weilsdk::CountedJson::parse<nlohmann::ordered_json>(p.state);
+        
+        from_json(j1, in_memory_db_instance);
+        
+        std::tuple<int32_t, std::string> result = in_memory_db_instance.create_index_budgeted(args.table, args.field, args.max_ops);
+        nlohmann::ordered_json j2 = in_memory_db_instance;
+        weilsdk::WeilValue wv;
+        weilsdk::scratch_json j_result = result;
+        wv.new_with_state_and_ok_value(weilsdk::CountedJson::dump(j2), weilsdk::CountedJson::dump(j_result));
+        collections::WriteBuffer::flush();
+        weilsdk::CountedRuntime::setStateAndResult(std::variant<weilsdk::WeilValue,std::string> {std::move(wv)});
+    }
+
+
+    void create_key_index_budgeted() {
+        weilsdk::ArenaScope arena_scope;
+        collections::InvocationScope invocation_scope;
+        weilsdk::StatsScope stats_scope("create_key_index_budgeted");
+        weilsdk::StateArgsView p = weilsdk::CountedRuntime::stateAndArgsView();
+        weilsdk::scratch_json j = weilsdk::CountedJson::parse<weilsdk::scratch_json>(p.args);
+        
+        if (j.is_discarded() || !j.contains("table") || !j.contains("max_ops")) {
+            weilsdk::MethodError me = weilsdk::MethodError("create_key_index_budgeted", "invalid_args");
+            weilsdk::CountedRuntime::setResult(weilsdk::WeilError::MethodArgumentDeserializationError(me), 1);
+            return;
+        }
+        
+        create_key_index_budgeted_args args;
+        args = j.get<create_key_index_budgeted_args>();
+        
+        nlohmann::ordered_json j1 = weilsdk::CountedJson::parse<nlohmann::ordered_json>(p.state);
+        
+        from_json(j1, in_memory_db_instance);
+        
+        std::tuple<int32_t, std::string> result = in_memory_db_instance.create_key_index_budgeted(args.table, args.max_ops);
+        nlohmann::ordered_json j2 = in_memory_db_instance;
+        weilsdk::WeilValue wv;
+        weilsdk::scratch_json j_result = result;
+        wv.new_with_state_and_ok_value(weilsdk::CountedJson::dump(j2), weilsdk::CountedJson::dump(j_result));
+        collections::WriteBuffer::flush();
+        weilsdk::CountedRuntime::setStateAndResult(std::variant<weilsdk::WeilValue,std::string> {std::move(wv)});
+    }
+
+
+    void resume() {
+        weilsdk::ArenaScope arena_scope;
+        collections::InvocationScope invocation_scope;
+        weilsdk::StatsScope stats_scope("resume");
+        weilsdk::StateArgsView p = weilsdk::CountedRuntime::stateAndArgsView();
+        weilsdk::scratch_json j = weilsdk::CountedJson::parse<weilsdk::scratch_json>(p.args);
+        
+        if (j.is_discarded() || !j.contains("token") || !j.contains("max_ops")) {
+            weilsdk::MethodError me = weilsdk::MethodError("resume", "invalid_args");
+            weilsdk::CountedRuntime::setResult(weilsdk::WeilError::MethodArgumentDeserializationError(me), 1);
+            return;
+        }
+        
+        resume_args args;
+        args = j.get<resume_args>();
+        
+        nlohmann::ordered_json j1 = weilsdk::CountedJson::parse<nlohmann::ordered_json>(p.state);
+        
+        from_json(j1, in_memory_db_instance);
+        
+        std::tuple<int32_t, std::string> result = in_memory_db_instance.resume(args.token, args.max_ops);
+        nlohmann::ordered_json j2 = in_memory_db_instance;
+        weilsdk::WeilValue wv;
+        weilsdk::scratch_json j_result = result;
+        wv.new_with_state_and_ok_value(weilsdk::CountedJson::dump(j2), weilsdk::CountedJson::dump(j_result));
+        collections::WriteBuffer::flush();
+        weilsdk::CountedRuntime::setStateAndResult(std::variant<weilsdk::WeilValue,std::string> {std::move(wv)});
+    }
+
+
+    void multi_get() {
+        weilsdk::ArenaScope arena_scope;
+        collections::InvocationScope invocation_scope;
+        weilsdk::StatsScope stats_scope("multi_get");
+        weilsdk::StateArgsView p = weilsdk::CountedRuntime::stateAndArgsView();
+        weilsdk::scratch_json j = weilsdk::CountedJson::parse<weilsdk::scratch_json>(p.args);
+        
+        if (j.is_discarded() || !j.contains("table") || !j.contains("keys") || !j.contains("fields")) {
+            weilsdk::MethodError me = weilsdk::MethodError("multi_get", "invalid_args");
+            weilsdk::CountedRuntime::setResult(weilsdk::WeilError::MethodArgumentDeserializationError(me), 1);
+            return;
+        }
+        
+        multi_get_args args;
+        args = j.get<multi_get_args>();
+        
+    
+        nlohmann::ordered_json j1 = weilsdk::CountedJson::parse<nlohmann::ordered_json>(p.state);
+        from_json(j1, in_memory_db_instance);
+        
+        std::optional<std::vector<std::tuple<std::string, std::vector<std::tuple<std::string, std::string>>>>> result = in_memory_db_instance.multi_get(args.table, args.keys, args.fields);
+        if (result.has_value()) {
+            weilsdk::scratch_json j_result = result.value();
+            weilsdk::CountedRuntime::setResult(weilsdk::CountedJson::dump(j_result), 0);
+        } else {
+            weilsdk::CountedRuntime::setResult("null", 0);
+        }
+    }
+
+
+    void update_fields() {
+        weilsdk::ArenaScope arena_scope;
+        collections::InvocationScope invocation_scope;
+        weilsdk::StatsScope stats_scope("update_fields");
+        weilsdk::StateArgsView p = weilsdk::CountedRuntime::stateAndArgsView();
+        weilsdk::scratch_json j = weilsdk::CountedJson::parse<weilsdk::scratch_json>(p.args);
         
         if (j.is_discarded() || !j.contains("table") || !j.contains("key") || !j.contains("fields")) {
-            weilsdk::MethodError me = weilsdk::MethodError("insert_record", "invalid_args");
-            weilsdk::Runtime::setResult(weilsdk::WeilError::MethodArgumentDeserializationError(me), 1);
+            weilsdk::MethodError me = weilsdk::MethodError("update_fields", "invalid_args");
+            weilsdk::CountedRuntime::setResult(weilsdk::WeilError::MethodArgumentDeserializationError(me), 1);
             return;
         }
         
-        insert_record_args args;
-        args = j.get<insert_record_args>();
+        update_fields_args args;
+        args = j.get<update_fields_args>();
         
-        std::string stateString = p.first;
-        nlohmann::ordered_json j1 = nlohmann::ordered_json::parse(stateString);
+        nlohmann::ordered_json j1 = weilsdk::CountedJson::parse<nlohmann::ordered_json>(p.state);
         
         from_json(j1, in_memory_db_instance);
         
-        int32_t result = in_memory_db_instance.insert_record(args.table, args.key, args.fields);
+        int32_t result = in_memory_db_instance.update_fields(args.table, args.key, args.fields);
         nlohmann::ordered_json j2 = in_memory_db_instance;
         weilsdk::WeilValue wv;
-        nlohmann::ordered_json j_result = result;
-        wv.new_with_state_and_ok_value(j2.dump(), j_result.dump());
-        weilsdk::Runtime::setStateAndResult(std::variant<weilsdk::WeilValue,std::string> {wv});
+        weilsdk::scratch_json j_result = result;
+        wv.new_with_state_and_ok_value(weilsdk::CountedJson::dump(j2), weilsdk::CountedJson::dump(j_result));
+        collections::WriteBuffer::flush();
+        weilsdk::CountedRuntime::setStateAndResult(std::variant<weilsdk::WeilValue,std::string> {std::move(wv)});
     }
 
 
-    void insert_records() {
-        std::pair<std::string, std::string> p = weilsdk::Runtime::stateAndArgs();
-        std::string raw_args = p.second;
-        nlohmann::ordered_json j = nlohmann::ordered_json::parse(raw_args);
+    void update_records() {
+        weilsdk::ArenaScope arena_scope;
+        collections::InvocationScope invocation_scope;
+        weilsdk::StatsScope stats_scope("update_records");
+        weilsdk::StateArgsView p = weilsdk::CountedRuntime::stateAndArgsView();
+        weilsdk::scratch_json j = weilsdk::CountedJson::parse<weilsdk::scratch_json>(p.args);
         
         if (j.is_discarded() || !j.contains("table") || !j.contains("records")) {
-            weilsdk::MethodError me = weilsdk::MethodError("insert_records", "invalid_args");
-            weilsdk::Runtime::setResult(weilsdk::WeilError::MethodArgumentDeserializationError(me), 1);
+            weilsdk::MethodError me = weilsdk::MethodError("update_records", "invalid_args");
+            weilsdk::CountedRuntime::setResult(weilsdk::WeilError::MethodArgumentDeserializationError(me), 1);
             return;
         }
         
-        insert_records_args args;
-        args = j.get<insert_records_args>();
+        update_records_args args;
+        args = j.get<update_records_args>();
         
-        std::string stateString = p.first;
-        nlohmann::ordered_json j1 = nlohmann::ordered_json::parse(stateString);
+        nlohmann::ordered_json j1 = weilsdk::CountedJson::parse<nlohmann::ordered_json>(p.state);
         
         from_json(j1, in_memory_db_instance);
         
-        int32_t result = in_memory_db_instance.insert_records(args.table, args.records);
+        int32_t result = in_memory_db_instance.update_records(args.table, args.records);
         nlohmann::ordered_json j2 = in_memory_db_instance;
         weilsdk::WeilValue wv;
-        nlohmann::ordered_json j_result = result;
-        wv.new_with_state_and_ok_value(j2.dump(), j_result.dump());
-        weilsdk::Runtime::setStateAndResult(std::variant<weilsdk::WeilValue,std::string> {wv});
+        weilsdk::scratch_json j_result = result;
+        wv.new_with_state_and_ok_value(weilsdk::CountedJson::dump(j2), weilsdk::CountedJson::dump(j_result));
+        collections::WriteBuffer::flush();
+        weilsdk::CountedRuntime::setStateAndResult(std::variant<weilsdk::WeilValue,std::string> {std::move(wv)});
     }
 
 
-    void get_fields() {
-            std::pair<std::string, std::string> p = weilsdk::Runtime::stateAndArgs();
-            std::string raw_args = p.second;
-            nlohmann::ordered_json j = nlohmann::ordered_json::parse(raw_args);
+    void remove_records() {
+        weilsdk::ArenaScope arena_scope;
+        collections::InvocationScope invocation_scope;
+        weilsdk::StatsScope stats_scope("remove_records");
+        weilsdk::StateArgsView p = weilsdk::CountedRuntime::stateAndArgsView();
+        weilsdk::scratch_json j = weilsdk::CountedJson::parse<weilsdk::scratch_json>(p.args);
         
-            if (j.is_discarded() || !j.contains("table") || !j.contains("key") || !j.contains("fields")) {
-            weilsdk::MethodError me = weilsdk::MethodError("get_fields", "invalid_args");
-            weilsdk::Runtime::setResult(weilsdk::WeilError::MethodArgumentDeserializationError(me), 1);
+        if (j.is_discarded() || !j.contains("table") || !j.contains("keys")) {
+            weilsdk::MethodError me = weilsdk::MethodError("remove_records", "invalid_args");
+            weilsdk::CountedRuntime::setResult(weilsdk::WeilError::MethodArgumentDeserializationError(me), 1);
             return;
         }
         
-        get_fields_args args;
-        args = j.get<get_fields_args>();
+        remove_records_args args;
+        args = j.get<remove_records_args>();
+        
+        nlohmann::ordered_json j1 = weilsdk::CountedJson::parse<nlohmann::ordered_json>(p.state);
+        
+        from_json(j1, in_memory_db_instance);
+        
+        int32_t result = in_memory_db_instance.remove_records(args.table, args.keys);
+        nlohmann::ordered_json j2 = in_memory_db_instance;
+        weilsdk::WeilValue wv;
+        weilsdk::scratch_json j_result = result;
+        wv.new_with_state_and_ok_value(weilsdk::CountedJson::dump(j2), weilsdk::CountedJson::dump(j_result));
+        collections::WriteBuffer::flush();
+        weilsdk::CountedRuntime::setStateAndResult(std::variant<weilsdk::WeilValue,std::string> {std::move(wv)});
+    }
+
+
+    void incr() {
+        weilsdk::ArenaScope arena_scope;
+        collections::InvocationScope invocation_scope;
+        weilsdk::StatsScope stats_scope("incr");
+        weilsdk::StateArgsView p = weilsdk::CountedRuntime::stateAndArgsView();
+        weilsdk::scratch_json j = weilsdk::CountedJson::parse<weilsdk::scratch_json>(p.args);
+        
+        if (j.is_discarded() || !j.contains("table") || !j.contains("key") || !j.contains("field") || !j.contains("delta")) {
+            weilsdk::MethodError me = weilsdk::MethodError("incr", "invalid_args");
+            weilsdk::CountedRuntime::setResult(weilsdk::WeilError::MethodArgumentDeserializationError(me), 1);
+            return;
+        }
+        
+        incr_args args;
+        args = j.get<incr_args>();
+        
+        nlohmann::ordered_json j1 = weilsdk::CountedJson::parse<nlohmann::ordered_json>(p.state);
+        
+        from_json(j1, in_memory_db_instance);
+        
+        std::optional<std::string> result = in_memory_db_instance.incr(args.table, args.key, args.field, args.delta);
+        nlohmann::ordered_json j2 = in_memory_db_instance;
+        weilsdk::WeilValue wv;
+        weilsdk::scratch_json j_result = nullptr;
+        if (result.has_value()) {
+            j_result = result.value();
+        }
+        wv.new_with_state_and_ok_value(weilsdk::CountedJson::dump(j2), weilsdk::CountedJson::dump(j_result));
+        collections::WriteBuffer::flush();
+        weilsdk::CountedRuntime::setStateAndResult(std::variant<weilsdk::WeilValue,std::string> {std::move(wv)});
+    }
+
+
+    void append() {
+        weilsdk::ArenaScope arena_scope;
+        collections::InvocationScope invocation_scope;
+        weilsdk::StatsScope stats_scope("append");
+        weilsdk::StateArgsView p = weilsdk::CountedRuntime::stateAndArgsView();
+        weilsdk::scratch_json j = weilsdk::CountedJson::parse<weilsdk::scratch_json>(p.args);
+        
+        if (j.is_discarded() || !j.contains("table") || !j.contains("key") || !j.contains("field") || !j.contains("value")) {
+            weilsdk::MethodError me = weilsdk::MethodError("append", "invalid_args");
+            weilsdk::CountedRuntime::setResult(weilsdk::WeilError::MethodArgumentDeserializationError(me), 1);
+            return;
+        }
+        
+        append_args args;
+        args = j.get<append_args>();
+        
+        nlohmann::ordered_json j1 = weilsdk::CountedJson::parse<nlohmann::ordered_json>(p.state);
+        
+        from_json(j1, in_memory_db_instance);
+        
+        std::optional<int32_t> result = in_memory_db_instance.append(args.table, args.key, args.field, args.value);
+        nlohmann::ordered_json j2 = in_memory_db_instance;
+        weilsdk::WeilValue wv;
+        weilsdk::scratch_json j_result = nullptr;
+        if (result.has_value()) {
+            j_result = result.value();
+        }
+        wv.new_with_state_and_ok_value(weilsdk::CountedJson::dump(j2), weilsdk::CountedJson::dump(j_result));
+        collections::WriteBuffer::flush();
+        weilsdk::CountedRuntime::setStateAndResult(std::variant<weilsdk::WeilValue,std::string> {std::move(wv)});
+    }
+
+
+    void get_version() {
+        weilsdk::ArenaScope arena_scope;
+        collections::InvocationScope invocation_scope;
+        weilsdk::StatsScope stats_scope("get_version");
+        weilsdk::StateArgsView p = weilsdk::CountedRuntime::stateAndArgsView();
+        weilsdk::scratch_json j = weilsdk::CountedJson::parse<weilsdk::scratch_json>(p.args);
+        
+        if (j.is_discarded() || !j.contains("table") || !j.contains("key")) {
+            weilsdk::MethodError me = weilsdk::MethodError("get_version", "invalid_args");
+            weilsdk::CountedRuntime::setResult(weilsdk::WeilError::MethodArgumentDeserializationError(me), 1);
+            return;
+        }
+        
+        get_version_args args;
+        args = j.get<get_version_args>();
         
-        std::string stateString = p.first;
     
-        nlohmann::ordered_json j1 = nlohmann::ordered_json::parse(stateString);
+        nlohmann::ordered_json j1 = weilsdk::CountedJson::parse<nlohmann::ordered_json>(p.state);
         from_json(j1, in_memory_db_instance);
         
-        std::vector<std::tuple<std::string, std::string>> result = in_memory_db_instance.get_fields(args.table, args.key, args.fields);
-        nlohmann::ordered_json j_result = result;
-        weilsdk::Runtime::setResult(j_result.dump(), 0);
+        std::optional<uint64_t> result = in_memory_db_instance.get_version(args.table, args.key);
+        if (result.has_value()) {
+            weilsdk::scratch_json j_result = result.value();
+            weilsdk::CountedRuntime::setResult(weilsdk::CountedJson::dump(j_result), 0);
+        } else {
+            weilsdk::CountedRuntime::setResult("null", 0);
+        }
     }
 
 
-    void get_all_fields() {
-            std::pair<std::string, std::string> p = weilsdk::Runtime::stateAndArgs();
-            std::string raw_args = p.second;
-            nlohmann::ordered_json j = nlohmann::ordered_json::parse(raw_args);
+    void cas() {
+        weilsdk::ArenaScope arena_scope;
+        collections::InvocationScope invocation_scope;
+        weilsdk::StatsScope stats_scope("cas");
+        weilsdk::StateArgsView p = weilsdk::CountedRuntime::stateAndArgsView();
+        weilsdk::scratch_json j = weilsdk::CountedJson::parse<weilsdk::scratch_json>(p.args);
         
-            if (j.is_discarded() || !j.contains("table") || !j.contains("key")) {
-            weilsdk::MethodError me = weilsdk::MethodError("get_all_fields", "invalid_args");
-            weilsdk::Runtime::setResult(weilsdk::WeilError::MethodArgumentDeserializationError(me), 1);
+        if (j.is_discarded() || !j.contains("table") || !j.contains("key") || !j.contains("field") || !j.contains("expected") || !j.contains("new_value")) {
+            weilsdk::MethodError me = weilsdk::MethodError("cas", "invalid_args");
+            weilsdk::CountedRuntime::setResult(weilsdk::WeilError::MethodArgumentDeserializationError(me), 1);
             return;
         }
         
-        get_all_fields_args args;
-        args = j.get<get_all_fields_args>();
+        cas_args args;
+        args = j.get<cas_args>();
+        
+        nlohmann::ordered_json j1 = weilsdk::CountedJson::parse<nlohmann::ordered_json>(p.state);
+        
+        from_json(j1, in_memory_db_instance);
+        
+        std::tuple<int32_t, uint64_t> result = in_memory_db_instance.cas(args.table, args.key, args.field, args.expected, args.new_value);
+        nlohmann::ordered_json j2 = in_memory_db_instance;
+        weilsdk::WeilValue wv;
+        weilsdk::scratch_json j_result = result;
+        wv.new_with_state_and_ok_value(weilsdk::CountedJson::dump(j2), weilsdk::CountedJson::dump(j_result));
+        collections::WriteBuffer::flush();
+        weilsdk::CountedRuntime::setStateAndResult(std::variant<weilsdk::WeilValue,std::string> {std::move(wv)});
+    }
+
+
+    void select_records() {
+        weilsdk::ArenaScope arena_scope;
+        collections::InvocationScope invocation_scope;
+        weilsdk::StatsScope stats_scope("select_records");
+        weilsdk::StateArgsView p = weilsdk::CountedRuntime::stateAndArgsView();
+        weilsdk::scratch_json j = weilsdk::CountedJson::parse<weilsdk::scratch_json>(p.args);
+        
+        if (j.is_discarded() || !j.contains("table") || !j.contains("where") || !j.contains("fields") || !j.contains("limit")) {
+            weilsdk::MethodError me = weilsdk::MethodError("select_records", "invalid_args");
+            weilsdk::CountedRuntime::setResult(weilsdk::WeilError::MethodArgumentDeserializationError(me), 1);
+            return;
+        }
+        
+        select_records_args args;
+        args = j.get<select_records_args>();
         
-        std::string stateString = p.first;
     
-        nlohmann::ordered_json j1 = nlohmann::ordered_json::parse(stateString);
+        nlohmann::ordered_json j1 = weilsdk::CountedJson::parse<nlohmann::ordered_json>(p.state);
         from_json(j1, in_memory_db_instance);
         
-        std::vector<std::tuple<std::string, std::string>> result = in_memory_db_instance.get_all_fields(args.table, args.key);
-        nlohmann::ordered_json j_result = result;
-        weilsdk::Runtime::setResult(j_result.dump(), 0);
+        std::optional<std::vector<std::tuple<std::string, std::vector<std::tuple<std::string, std::string>>>>> result = in_memory_db_instance.select_records(args.table, args.where, args.fields, args.limit);
+        if (result.has_value()) {
+            weilsdk::scratch_json j_result = result.value();
+            weilsdk::CountedRuntime::setResult(weilsdk::CountedJson::dump(j_result), 0);
+        } else {
+            weilsdk::CountedRuntime::setResult("null", 0);
+        }
     }
 
     void tools() {
+    weilsdk::ArenaScope arena_scope;
+    collections::InvocationScope invocation_scope;
+    weilsdk::StatsScope stats_scope("tools");
     // 1. Recover state
-    std::string stateString = weilsdk::Runtime::state();
-    nlohmann::ordered_json j = nlohmann::ordered_json::parse(stateString);
+    std::string stateString = weilsdk::CountedRuntime::state();
+    nlohmann::ordered_json j = weilsdk::CountedJson::parse<nlohmann::ordered_json>(stateString);
     from_json(j, in_memory_db_instance);
 
     // 2. Get tools JSON string
@@ -845,7 +2554,13 @@ extern "C" {
 
     // 3. Wrap as a JSON string to satisfy the host's type expectation
     nlohmann::ordered_json result_wrapper = tools_json_raw;
-    weilsdk::Runtime::setResult(result_wrapper.dump(), 0);
+    weilsdk::CountedRuntime::setResult(weilsdk::CountedJson::dump(result_wrapper), 0);
 }
 
+    // Per-method host-call, byte and JSON counters collected since the
+    // instance was created
+    void __stats() {
+        weilsdk::CountedRuntime::setResult(weilsdk::Stats::report(), 0);
+    }
+
 } // extern "C"